@@ -1,4 +1,6 @@
 #include "../include/limit_order_book.hpp"
+#include "../include/order_flow.hpp"
+#include "../include/flow_models.hpp"
 #include <iostream>
 #include <chrono>
 #include <random>
@@ -192,6 +194,163 @@ public:
         return result;
     }
     
+    BenchmarkResult benchmark_order_flow_generation(size_t num_orders) {
+        OrderFlowParams params;
+        params.symbol_id = 100;
+        params.base_price = 5000;
+        params.price_range = 500;
+        params.min_quantity = 100;
+        params.max_quantity = 5000;
+        params.volatility = 0.02;
+        
+        OrderFlowGenerator generator(params, 42);
+        std::vector<OrderCommand> commands(OrderFlowGenerator::kBatchSize);
+        uint64_t checksum = 0;
+        
+        auto start_time = std::chrono::high_resolution_clock::now();
+        
+        for (size_t i = 0; i < num_orders; i += commands.size()) {
+            generator.generate(commands.data(), commands.size());
+            checksum += commands[0].quantity;
+        }
+        
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+        
+        // Keep the generated commands observable
+        volatile uint64_t sink = checksum;
+        (void)sink;
+        
+        BenchmarkResult result;
+        result.test_name = "Order Flow Generation";
+        result.num_operations = num_orders;
+        result.duration_ms = duration.count() / 1000.0;
+        result.operations_per_second = (num_orders * 1000.0) / result.duration_ms;
+        result.average_latency_ns = (result.duration_ms * 1000000.0) / num_orders;
+        
+        return result;
+    }
+    
+    BenchmarkResult benchmark_hawkes_flow_model(size_t num_events) {
+        OrderFlowParams params;
+        params.symbol_id = 100;
+        params.base_price = 5000;
+        params.price_range = 500;
+        params.min_quantity = 100;
+        params.max_quantity = 5000;
+        
+        HawkesFlowModel model(params, HawkesFlowModel::symmetric(10000.0), 42);
+        BookTop top{4999, 1000, 5001, 1000};
+        SimTime now = 0;
+        
+        auto start_time = std::chrono::high_resolution_clock::now();
+        
+        for (size_t i = 0; i < num_events; ++i) {
+            now = model.next_event(now, top).time;
+        }
+        
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+        
+        volatile SimTime sink = now;
+        (void)sink;
+        
+        BenchmarkResult result;
+        result.test_name = "Hawkes Flow Model Events";
+        result.num_operations = num_events;
+        result.duration_ms = duration.count() / 1000.0;
+        result.operations_per_second = (num_events * 1000.0) / result.duration_ms;
+        result.average_latency_ns = (result.duration_ms * 1000000.0) / num_events;
+        
+        return result;
+    }
+    
+    BenchmarkResult benchmark_risk_checks(size_t num_checks) {
+        RiskEngine risk;
+        RiskLimits limits;
+        limits.max_order_quantity = 100000;
+        limits.max_order_notional = 1000000000;
+        limits.max_open_notional = 1ULL << 62;
+        limits.price_collar_bps = 1000;
+        risk.set_default_limits(limits);
+        
+        auto start_time = std::chrono::high_resolution_clock::now();
+        
+        for (size_t i = 0; i < num_checks; ++i) {
+            uint32_t account = static_cast<uint32_t>(i & 1023);
+            risk.check_and_reserve(account, OrderType::LIMIT, 100, 5000, 5000);
+            risk.release(account, 100 * 5000);
+        }
+        
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+        
+        BenchmarkResult result;
+        result.test_name = "Risk Check + Release";
+        result.num_operations = num_checks;
+        result.duration_ms = duration.count() / 1000.0;
+        result.operations_per_second = (num_checks * 1000.0) / result.duration_ms;
+        result.average_latency_ns = (result.duration_ms * 1000000.0) / num_checks;
+        
+        return result;
+    }
+    
+    BenchmarkResult benchmark_quote_refresh(size_t num_refreshes, bool use_mass_quote) {
+        OrderBookSimulator simulator(1);
+        constexpr uint32_t symbol_id = 1;
+        constexpr size_t levels = 10;
+        uint64_t updates = 0;
+        
+        // Two-sided ladder re-centred on every refresh
+        std::vector<QuoteEntry> quotes(2 * levels);
+        std::vector<uint64_t> order_ids;
+        auto build_ladder = [&](uint64_t mid) {
+            for (size_t i = 0; i < levels; ++i) {
+                quotes[2 * i] = {symbol_id, Side::BUY, mid - 1 - i, 100};
+                quotes[2 * i + 1] = {symbol_id, Side::SELL, mid + 1 + i, 100};
+            }
+        };
+        
+        build_ladder(5000);
+        if (use_mass_quote) {
+            simulator.mass_quote(1, quotes.data(), quotes.size());
+        } else {
+            for (const auto& quote : quotes) {
+                order_ids.push_back(simulator.submit_order(symbol_id, quote.side, OrderType::LIMIT,
+                                                           quote.quantity, quote.price));
+            }
+        }
+        
+        // One market data subscriber, as a feed handler would have
+        simulator.register_market_data_callback(symbol_id, [&updates](const MarketDataSnapshot&) { updates++; });
+        
+        auto start_time = std::chrono::high_resolution_clock::now();
+        
+        for (size_t i = 0; i < num_refreshes; ++i) {
+            build_ladder(5000 + (i & 1));
+            if (use_mass_quote) {
+                simulator.mass_quote(1, quotes.data(), quotes.size());
+            } else {
+                for (size_t leg = 0; leg < quotes.size(); ++leg) {
+                    simulator.modify_order(order_ids[leg], quotes[leg].quantity, quotes[leg].price);
+                }
+            }
+        }
+        
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+        
+        size_t legs = num_refreshes * quotes.size();
+        BenchmarkResult result;
+        result.test_name = use_mass_quote ? "Quote Refresh (mass quote)" : "Quote Refresh (modify per leg)";
+        result.num_operations = legs;
+        result.duration_ms = duration.count() / 1000.0;
+        result.operations_per_second = (legs * 1000.0) / result.duration_ms;
+        result.average_latency_ns = (result.duration_ms * 1000000.0) / legs;
+        
+        return result;
+    }
+    
     void print_result(const BenchmarkResult& result) {
         std::cout << std::left << std::setw(35) << result.test_name
                   << std::setw(12) << std::right << result.num_operations
@@ -234,6 +393,17 @@ public:
         print_result(benchmark_concurrent_access(20000, 4));
         print_result(benchmark_concurrent_access(20000, 8));
         
+        // Synthetic order flow generation (single core)
+        print_result(benchmark_order_flow_generation(50000000));
+        print_result(benchmark_hawkes_flow_model(5000000));
+        
+        // Pre-trade risk stage
+        print_result(benchmark_risk_checks(10000000));
+        
+        // Market maker quote refresh, 10 levels per side
+        print_result(benchmark_quote_refresh(20000, false));
+        print_result(benchmark_quote_refresh(20000, true));
+        
         std::cout << "\nBenchmark completed!\n";
     }
 };
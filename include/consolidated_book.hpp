@@ -0,0 +1,120 @@
+#pragma once
+
+#include "limit_order_book.hpp"
+
+namespace lob {
+
+// National best bid and offer across venues
+struct Nbbo {
+    uint64_t best_bid_price = 0;
+    uint64_t best_bid_quantity = 0;     // At the winning venue
+    uint64_t best_ask_price = 0;
+    uint64_t best_ask_quantity = 0;
+    uint32_t best_bid_venue = 0;
+    uint32_t best_ask_venue = 0;
+};
+
+// Top levels of one venue's book, published lock-free per venue
+struct VenueDepth {
+    static constexpr uint32_t kMaxDepth = 10;
+    
+    struct Level {
+        uint64_t price;
+        uint64_t quantity;
+    };
+    
+    uint32_t bid_count = 0;
+    uint32_t ask_count = 0;
+    Level bids[kMaxDepth] = {};     // Best first
+    Level asks[kMaxDepth] = {};
+};
+
+// One venue's quantity at a consolidated price level
+struct ConsolidatedLevel {
+    uint64_t price;
+    uint64_t quantity;
+    uint32_t venue;
+};
+
+// Consolidated book over several OrderBookSimulator venues.
+//
+// Each tracked symbol subscribes to every venue's market data updates. An
+// update refreshes that venue's top of book and depth copy, then replays
+// one leaf-to-root path of a tournament tree per side, so the NBBO is
+// recomputed in O(log venues) without looking at the other venues. NBBO
+// and per-venue depth are published through seqlocks and read lock-free.
+class ConsolidatedBook {
+public:
+    static constexpr uint32_t kMaxVenues = 64;
+    
+    // depth levels per side are copied from each venue on every update
+    explicit ConsolidatedBook(uint32_t depth = 5);
+    
+    // Detaches from every venue; no venue callback runs into it afterwards
+    ~ConsolidatedBook();
+    
+    ConsolidatedBook(const ConsolidatedBook&) = delete;
+    ConsolidatedBook& operator=(const ConsolidatedBook&) = delete;
+    
+    // Venues must outlive the consolidated book. Add all venues, then track
+    // symbols, before trading starts.
+    uint32_t add_venue(OrderBookSimulator& venue);
+    void track_symbol(uint32_t symbol_id);
+    
+    // Called on the venue thread that changed the NBBO, in change order;
+    // callbacks must be short and must not call back into this object
+    void subscribe(std::function<void(uint32_t symbol_id, const Nbbo& nbbo)> callback);
+    
+    Nbbo get_nbbo(uint32_t symbol_id) const;
+    bool get_venue_depth(uint32_t symbol_id, uint32_t venue, VenueDepth& out) const;
+    
+    // Merge every venue's levels on one side in price priority (ties in
+    // venue order); returns the number of levels written, at most max_levels
+    size_t get_depth(uint32_t symbol_id, Side side, ConsolidatedLevel* out, size_t max_levels) const;
+    
+    uint64_t get_nbbo_updates(uint32_t symbol_id) const;
+    size_t venue_count() const noexcept { return venues_.size(); }
+    OrderBookSimulator& venue(uint32_t index) const noexcept { return *venues_[index]; }
+    
+private:
+    struct SymbolState {
+        std::atomic_flag lock = ATOMIC_FLAG_INIT;     // Venue updates
+        uint32_t leaves = 1;
+        std::vector<TopOfBook> tops;                  // Per leaf; padding leaves stay empty
+        std::vector<uint32_t> bid_tree;               // Winning leaf per node, root at 1
+        std::vector<uint32_t> ask_tree;
+        Nbbo nbbo;                                    // Last published, under lock
+        std::atomic<uint64_t> updates{0};
+        SeqLocked<Nbbo> published;
+        std::unique_ptr<SeqLocked<VenueDepth>[]> depth;
+    };
+    
+    uint32_t depth_;
+    std::vector<OrderBookSimulator*> venues_;
+    std::unordered_map<uint32_t, std::unique_ptr<SymbolState>> symbols_;   // Read-only once trading
+    std::vector<std::function<void(uint32_t, const Nbbo&)>> callbacks_;
+    
+    // Venue market data registrations, dropped on destruction
+    struct Subscription {
+        uint32_t venue;
+        uint32_t symbol_id;
+        uint64_t token;
+    };
+    std::vector<Subscription> subscriptions_;
+    
+    const SymbolState* find(uint32_t symbol_id) const;
+    void refresh(uint32_t symbol_id, SymbolState& state, uint32_t venue);
+    
+    static bool better_bid(const TopOfBook& a, const TopOfBook& b) noexcept {
+        return a.best_bid_price != b.best_bid_price ? a.best_bid_price > b.best_bid_price
+                                                    : a.best_bid_quantity > b.best_bid_quantity;
+    }
+    static bool better_ask(const TopOfBook& a, const TopOfBook& b) noexcept {
+        // An empty ask side (price 0) loses to any offer
+        uint64_t a_price = a.best_ask_price ? a.best_ask_price : UINT64_MAX;
+        uint64_t b_price = b.best_ask_price ? b.best_ask_price : UINT64_MAX;
+        return a_price != b_price ? a_price < b_price : a.best_ask_quantity > b.best_ask_quantity;
+    }
+};
+
+} // namespace lob
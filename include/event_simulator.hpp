@@ -0,0 +1,106 @@
+#pragma once
+
+#include "limit_order_book.hpp"
+#include <random>
+
+namespace lob {
+
+// Simulated time in nanoseconds since the start of the run
+using SimTime = uint64_t;
+
+// Latency distribution for one leg of an agent's path to the exchange
+class LatencyModel {
+public:
+    enum class Kind : uint8_t {
+        CONSTANT = 0,
+        UNIFORM = 1,
+        EXPONENTIAL = 2    // Fixed base plus exponentially distributed jitter
+    };
+
+    LatencyModel() noexcept : kind_(Kind::CONSTANT), base_ns_(0), spread_ns_(0) {}
+
+    static LatencyModel constant(SimTime latency_ns) noexcept {
+        return LatencyModel(Kind::CONSTANT, latency_ns, 0);
+    }
+    static LatencyModel uniform(SimTime min_ns, SimTime max_ns) noexcept {
+        return LatencyModel(Kind::UNIFORM, min_ns, max_ns > min_ns ? max_ns - min_ns : 0);
+    }
+    static LatencyModel exponential(SimTime base_ns, SimTime mean_jitter_ns) noexcept {
+        return LatencyModel(Kind::EXPONENTIAL, base_ns, mean_jitter_ns);
+    }
+
+    SimTime sample(std::mt19937_64& rng) const;
+
+private:
+    LatencyModel(Kind kind, SimTime base_ns, SimTime spread_ns) noexcept
+        : kind_(kind), base_ns_(base_ns), spread_ns_(spread_ns) {}
+
+    Kind kind_;
+    SimTime base_ns_;
+    SimTime spread_ns_;
+};
+
+// Discrete-event scheduler that drives order books in simulated time.
+//
+// Events are ordered by (time, insertion sequence), so ties resolve in
+// scheduling order and a run is fully deterministic for a given seed as
+// long as all randomness is drawn from rng(). Nothing sleeps: the clock
+// jumps straight to the next event.
+class DiscreteEventSimulator {
+public:
+    using Action = std::function<void()>;
+
+    explicit DiscreteEventSimulator(uint64_t seed = 0);
+
+    // Register an agent with its network (one-way) and exchange processing latencies
+    uint32_t add_agent(LatencyModel network, LatencyModel processing);
+
+    // Schedule an action at an absolute or relative simulated time
+    void schedule_at(SimTime time, Action action);
+    void schedule_after(SimTime delay, Action action) { schedule_at(now_ + delay, std::move(action)); }
+
+    // Deliver an agent's message: on_exchange runs after network + processing
+    // latency, on_response (if set) runs back at the agent one network leg later
+    void send_to_exchange(uint32_t agent, Action on_exchange, Action on_response = nullptr);
+
+    // Execute the next event; false when the queue is empty
+    bool step();
+
+    // Execute events up to and including end_time; returns events executed
+    uint64_t run_until(SimTime end_time);
+
+    // Execute until the queue drains
+    uint64_t run();
+
+    SimTime now() const noexcept { return now_; }
+    size_t pending_events() const noexcept { return events_.size(); }
+    uint64_t events_processed() const noexcept { return events_processed_; }
+    std::mt19937_64& rng() noexcept { return rng_; }
+
+private:
+    struct Event {
+        SimTime time;
+        uint64_t sequence;
+        Action action;
+    };
+
+    struct Later {
+        bool operator()(const Event& a, const Event& b) const noexcept {
+            return a.time != b.time ? a.time > b.time : a.sequence > b.sequence;
+        }
+    };
+
+    struct Agent {
+        LatencyModel network;
+        LatencyModel processing;
+    };
+
+    std::vector<Event> events_;    // Binary min-heap on (time, sequence)
+    std::vector<Agent> agents_;
+    std::mt19937_64 rng_;
+    SimTime now_ = 0;
+    uint64_t next_sequence_ = 0;
+    uint64_t events_processed_ = 0;
+};
+
+} // namespace lob
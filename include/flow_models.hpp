@@ -0,0 +1,136 @@
+#pragma once
+
+#include "event_simulator.hpp"
+#include "order_flow.hpp"
+#include <array>
+
+namespace lob {
+
+// Top-of-book state a flow model conditions on
+struct BookTop {
+    uint64_t best_bid_price = 0;
+    uint64_t best_bid_quantity = 0;
+    uint64_t best_ask_price = 0;
+    uint64_t best_ask_quantity = 0;
+};
+
+// One event produced by a flow model
+struct FlowEvent {
+    SimTime time;
+    OrderCommand command;
+    bool cancel;           // Cancel a resting order on command.side instead of submitting
+};
+
+// Pluggable order-flow model driven in simulated time
+class FlowModel {
+public:
+    virtual ~FlowModel() = default;
+
+    // Draw the next event strictly after `now` given the current book top
+    virtual FlowEvent next_event(SimTime now, const BookTop& book) = 0;
+};
+
+// Factory used by MarketDataSimulator to build one model per symbol
+using FlowModelFactory = std::function<std::unique_ptr<FlowModel>(
+    const OrderFlowParams& params, double orders_per_second, uint64_t seed, uint64_t stream)>;
+
+// Homogeneous Poisson arrivals with the uniform OrderFlowGenerator marks
+class PoissonFlowModel : public FlowModel {
+public:
+    PoissonFlowModel(const OrderFlowParams& params, double orders_per_second, uint64_t seed, uint64_t stream = 0);
+
+    FlowEvent next_event(SimTime now, const BookTop& book) override;
+
+    static FlowModelFactory factory();
+
+private:
+    OrderFlowGenerator generator_;
+    Xoshiro256pp rng_;
+    double mean_interarrival_ns_;
+};
+
+// Multivariate self- and cross-exciting Hawkes process over four event
+// types (limit buy, limit sell, market buy, market sell) with exponential
+// kernels sharing one decay rate:
+//
+//   lambda_i(t) = mu_i + sum_j alpha_ij * sum_{t_k in j} exp(-beta (t - t_k))
+//
+// The excitation sum is kept per target type and decayed in place, so each
+// intensity update is O(1) per type. Events are drawn by Ogata thinning,
+// which is exact here because intensities only decay between events.
+class HawkesFlowModel : public FlowModel {
+public:
+    static constexpr size_t kEventTypes = 4;
+    enum EventType : size_t {
+        LIMIT_BUY = 0,
+        LIMIT_SELL = 1,
+        MARKET_BUY = 2,
+        MARKET_SELL = 3
+    };
+
+    struct Parameters {
+        std::array<double, kEventTypes> baseline_per_second{};               // mu
+        std::array<std::array<double, kEventTypes>, kEventTypes> excitation{}; // alpha[target][source], per second
+        double decay_per_second = 1.0;                                       // beta
+        uint64_t max_price_offset = 5;   // Limit orders rest up to this many ticks behind the best
+    };
+
+    HawkesFlowModel(const OrderFlowParams& params, const Parameters& hawkes, uint64_t seed, uint64_t stream = 0);
+
+    FlowEvent next_event(SimTime now, const BookTop& book) override;
+
+    // Current total intensity (events per second)
+    double intensity() const noexcept;
+
+    // Symmetric parameters with the given stationary rate and branching
+    // ratio (share of events triggered by earlier events, must be < 1)
+    static Parameters symmetric(double orders_per_second, double branching_ratio = 0.7,
+                                double decay_per_second = 50.0, double market_share = 0.1);
+
+    static FlowModelFactory factory(double branching_ratio = 0.7, double decay_per_second = 50.0);
+
+private:
+    OrderFlowParams params_;
+    Parameters hawkes_;
+    Xoshiro256pp rng_;
+    std::array<double, kEventTypes> excitation_{};   // Decayed sum of kernels per target type
+    SimTime last_time_;                              // Time excitation_ was last decayed to
+    uint64_t reference_price_;
+
+    void decay(double dt_seconds) noexcept;
+    double uniform() noexcept { return static_cast<double>(rng_() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+// Queue-reactive model (after Huang, Lehalle & Rosenbaum): event intensities
+// are functions of the current best bid and ask queue sizes, measured in
+// units of the average order size. Limit inserts slow down as a queue grows,
+// cancellations scale with queue size and market orders need a non-empty
+// queue to hit. Evaluating all intensities is a handful of flops per event.
+class QueueReactiveFlowModel : public FlowModel {
+public:
+    struct Parameters {
+        double limit_rate_per_second = 100.0;     // Insert rate into an empty queue
+        double cancel_rate_per_second = 5.0;      // Per queue unit
+        double market_rate_per_second = 20.0;     // While the opposite queue is non-empty
+        double reference_queue_units = 5.0;       // Queue size at which inserts halve
+    };
+
+    QueueReactiveFlowModel(const OrderFlowParams& params, const Parameters& queue, uint64_t seed, uint64_t stream = 0);
+
+    FlowEvent next_event(SimTime now, const BookTop& book) override;
+
+    // Insert rate scaled to each symbol's configured order rate
+    static FlowModelFactory factory();
+    static FlowModelFactory factory(const Parameters& queue);
+
+private:
+    OrderFlowParams params_;
+    Parameters queue_;
+    Xoshiro256pp rng_;
+    double queue_unit_;          // Average order size
+    uint64_t reference_price_;
+
+    double uniform() noexcept { return static_cast<double>(rng_() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+} // namespace lob
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "limit_order_book.hpp"
+#include <fstream>
+#include <string>
+
+namespace lob {
+
+// Location and key ranges of one archive block
+struct JournalBlockInfo {
+    uint64_t offset = 0;             // File offset of the block header
+    uint64_t first_sequence = 0;     // Min and max over the block
+    uint64_t last_sequence = 0;
+    uint64_t first_timestamp = 0;
+    uint64_t last_timestamp = 0;
+    uint32_t record_count = 0;
+    uint32_t byte_count = 0;         // Encoded payload after the header
+};
+
+// A symbol's first record in one block; the index holds one per (symbol,
+// block) pair, sorted by symbol then block
+struct JournalSymbolEntry {
+    uint32_t symbol_id;
+    uint32_t block;
+    uint64_t first_sequence;
+    uint64_t first_timestamp;
+};
+
+// Writer for the compressed journal archive.
+//
+// Records are packed into blocks of up to block_records. Within a block,
+// timestamps, order ids and prices are deltas against the previous record
+// of the same symbol, sequence numbers are deltas against the previous
+// record, and everything is written as (zigzag) varints behind a one-byte
+// tag. Delta state resets at every block, so each block decodes on its
+// own. close() appends the block index and the per-symbol index, then a
+// fixed footer locating them. Integers in the header, index and footer are
+// in native byte order.
+class JournalArchiveWriter {
+public:
+    static constexpr uint32_t kDefaultBlockRecords = 4096;
+
+    explicit JournalArchiveWriter(uint32_t block_records = kDefaultBlockRecords);
+    ~JournalArchiveWriter() { close(); }
+
+    bool open(const std::string& path);
+
+    // Not thread-safe; false if the archive is not open or a write failed
+    bool append(const JournalRecord& record);
+
+    // Flush the last block and write the index; safe to call twice
+    bool close();
+
+    uint64_t records_written() const noexcept { return records_; }
+    uint64_t bytes_written() const noexcept { return offset_; }
+
+private:
+    struct SymbolState {
+        uint64_t timestamp = 0;
+        uint64_t order_id = 0;
+        uint64_t price = 0;
+    };
+
+    std::ofstream file_;
+    uint32_t block_records_;
+    std::vector<uint8_t> buffer_;
+    JournalBlockInfo block_;
+    std::unordered_map<uint32_t, SymbolState> symbols_;     // Reset per block
+    SymbolState* last_state_ = nullptr;
+    uint32_t last_symbol_ = 0;
+    uint64_t last_sequence_ = 0;
+    std::vector<JournalBlockInfo> blocks_;
+    std::vector<JournalSymbolEntry> symbol_entries_;
+    uint64_t offset_ = 0;
+    uint64_t records_ = 0;
+
+    bool flush_block();
+};
+
+// Reader for archives written by JournalArchiveWriter. open() loads only
+// the footer and the indexes; blocks are read and decoded on demand. Not
+// thread-safe.
+class JournalArchiveReader {
+public:
+    bool open(const std::string& path);
+
+    size_t block_count() const noexcept { return blocks_.size(); }
+    const JournalBlockInfo& block(size_t index) const { return blocks_[index]; }
+    uint64_t record_count() const noexcept { return record_count_; }
+
+    // First block whose sequence range reaches sequence; block_count() if none
+    size_t find_block(uint64_t sequence) const noexcept;
+
+    // Block holding the symbol's last record at or before sequence (or
+    // timestamp): the last of its blocks whose first record for it is not
+    // later. The symbol's first block if all its records are later, and
+    // block_count() if it has none.
+    size_t find_block(uint32_t symbol_id, uint64_t sequence) const noexcept;
+    size_t find_block_at_time(uint32_t symbol_id, uint64_t timestamp) const noexcept;
+
+    // Next block after `block` with records of the symbol; block_count() if none
+    size_t next_block(uint32_t symbol_id, size_t block) const noexcept;
+
+    // Decode one block, replacing the contents of out
+    bool read_block(size_t index, std::vector<JournalRecord>& out);
+
+    // Decode count records from an encoded block payload
+    static bool decode_block(const uint8_t* data, size_t size, uint32_t count, JournalRecord* out);
+
+private:
+    std::ifstream file_;
+    std::vector<JournalBlockInfo> blocks_;
+    std::vector<JournalSymbolEntry> symbol_entries_;
+    std::vector<uint8_t> scratch_;
+    uint64_t record_count_ = 0;
+
+    template <typename Key>
+    size_t find_symbol_block(uint32_t symbol_id, uint64_t value, Key key) const noexcept;
+};
+
+} // namespace lob
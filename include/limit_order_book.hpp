@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
@@ -12,6 +13,9 @@
 #include <functional>
 #include <map>
 #include <shared_mutex>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
 
 namespace lob {
 
@@ -34,7 +38,51 @@ enum class OrderStatus : uint8_t {
 enum class OrderType : uint8_t {
     LIMIT = 0,
     MARKET = 1,
-    STOP = 2
+    STOP = 2,
+    MARKET_TO_LIMIT = 3      // Executes as a market order, remainder rests as a LIMIT at the last fill price
+};
+
+// Market-type orders arrive without a price and take no risk reservation
+inline bool is_market_type(OrderType type) noexcept {
+    return type == OrderType::MARKET || type == OrderType::MARKET_TO_LIMIT;
+}
+
+// Client-supplied order id (FIX ClOrdID) stored inline in four words.
+// Unused bytes are zero and the length sits in the last byte, so equality
+// and hashing are fixed-width word operations with no allocation.
+struct ClOrdId {
+    static constexpr size_t kMaxLength = 31;
+    
+    uint64_t words[4] = {0, 0, 0, 0};
+    
+    // False if the id is empty or longer than kMaxLength
+    static bool from_string(std::string_view text, ClOrdId& id) noexcept {
+        if (text.empty() || text.size() > kMaxLength) {
+            return false;
+        }
+        id = ClOrdId{};
+        std::memcpy(id.words, text.data(), text.size());
+        reinterpret_cast<unsigned char*>(id.words)[kMaxLength] = static_cast<unsigned char>(text.size());
+        return true;
+    }
+    
+    size_t length() const noexcept { return reinterpret_cast<const unsigned char*>(words)[kMaxLength]; }
+    std::string_view view() const noexcept { return {reinterpret_cast<const char*>(words), length()}; }
+    
+    // Multiply-xorshift over the four words
+    uint64_t hash() const noexcept {
+        uint64_t h = 0x243F6A8885A308D3ULL;
+        for (uint64_t word : words) {
+            h = (h ^ word) * 0x9E3779B97F4A7C15ULL;
+            h ^= h >> 29;
+        }
+        return h;
+    }
+    
+    bool operator==(const ClOrdId& other) const noexcept {
+        return ((words[0] ^ other.words[0]) | (words[1] ^ other.words[1]) |
+                (words[2] ^ other.words[2]) | (words[3] ^ other.words[3])) == 0;
+    }
 };
 
 // Core Order structure optimized for performance
@@ -49,21 +97,29 @@ struct Order {
     uint64_t timestamp;       // Microsecond timestamp
     OrderStatus status;
     uint64_t filled_quantity;
+    uint32_t account_id;      // Owning account (0 when unattributed)
+    uint32_t session_id;      // Client session receiving execution reports (0 for none)
+    ClOrdId cl_ord_id;        // The session's id for the order; empty when none
+    
+    // Intrusive links in the owning session's live-order list, maintained
+    // by the engine from lifecycle events
+    mutable Order* session_prev = nullptr;
+    mutable Order* session_next = nullptr;
     
     // Default constructor
     Order() noexcept : order_id(0), symbol_id(0), side(Side::BUY), 
                       order_type(OrderType::LIMIT), quantity(0), 
                       price(0), stop_price(0), timestamp(0), 
-                      status(OrderStatus::NEW), filled_quantity(0) {}
+                      status(OrderStatus::NEW), filled_quantity(0), account_id(0), session_id(0) {}
     
     // Parameterized constructor
     Order(uint64_t id, uint32_t symbol, Side s, OrderType type, 
-          uint64_t qty, uint64_t px, uint64_t stop_px = 0) noexcept
+          uint64_t qty, uint64_t px, uint64_t stop_px = 0, uint32_t account = 0) noexcept
         : order_id(id), symbol_id(symbol), side(s), order_type(type),
           quantity(qty), price(px), stop_price(stop_px), 
           timestamp(std::chrono::duration_cast<std::chrono::microseconds>(
               std::chrono::high_resolution_clock::now().time_since_epoch()).count()),
-          status(OrderStatus::NEW), filled_quantity(0) {}
+          status(OrderStatus::NEW), filled_quantity(0), account_id(account), session_id(0) {}
     
     // Check if order is fully filled
     bool is_filled() const noexcept { return filled_quantity == quantity; }
@@ -90,6 +146,215 @@ struct Trade {
               std::chrono::high_resolution_clock::now().time_since_epoch()).count()) {}
 };
 
+// Minimal spinlock guard for critical sections of a few loads and stores
+class SpinGuard {
+public:
+    explicit SpinGuard(std::atomic_flag& flag) noexcept : flag_(flag) {
+        while (flag_.test_and_set(std::memory_order_acquire)) {
+        }
+    }
+    ~SpinGuard() { flag_.clear(std::memory_order_release); }
+    
+    SpinGuard(const SpinGuard&) = delete;
+    SpinGuard& operator=(const SpinGuard&) = delete;
+    
+private:
+    std::atomic_flag& flag_;
+};
+
+// Bounded single-producer single-consumer ring. Head and tail sit on their
+// own cache lines and each side caches the other's index, so a push or pop
+// only touches shared state when the cached view runs out.
+template <typename T>
+class SpscRing {
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        buffer_.resize(size);
+        mask_ = size - 1;
+    }
+    
+    // Producer side; false if the ring is full
+    bool try_push(const T& value) noexcept {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ > mask_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ > mask_) {
+                return false;
+            }
+        }
+        buffer_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Consumer side; copies up to max_count entries and returns the count
+    size_t pop_batch(T* out, size_t max_count) noexcept {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        if (cached_tail_ == head) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+        }
+        size_t count = std::min<uint64_t>(cached_tail_ - head, max_count);
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = buffer_[(head + i) & mask_];
+        }
+        head_.store(head + count, std::memory_order_release);
+        return count;
+    }
+    
+    size_t size() const noexcept {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+    size_t capacity() const noexcept { return buffer_.size(); }
+    
+private:
+    std::vector<T> buffer_;
+    uint64_t mask_ = 0;
+    
+    alignas(64) std::atomic<uint64_t> head_{0};   // Written by the consumer
+    uint64_t cached_tail_ = 0;
+    alignas(64) std::atomic<uint64_t> tail_{0};   // Written by the producer
+    uint64_t cached_head_ = 0;
+};
+
+// Single-writer sequence lock publishing a trivially copyable value.
+// The value is stored as relaxed atomic words, so readers never block the
+// writer and simply retry if they observe a write in progress. Concurrent
+// writers must be serialized by the caller.
+template <typename T>
+class SeqLocked {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLocked requires a trivially copyable type");
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    
+    std::atomic<uint64_t> sequence_{0};
+    std::atomic<uint64_t> words_[kWords];
+    
+public:
+    SeqLocked() noexcept {
+        for (auto& word : words_) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+    
+    void store(const T& value) noexcept {
+        uint64_t buffer[kWords] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+        
+        uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kWords; ++i) {
+            words_[i].store(buffer[i], std::memory_order_relaxed);
+        }
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+    
+    T load() const noexcept {
+        uint64_t buffer[kWords];
+        uint64_t before, after;
+        do {
+            before = sequence_.load(std::memory_order_acquire);
+            for (size_t i = 0; i < kWords; ++i) {
+                buffer[i] = words_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence_.load(std::memory_order_relaxed);
+        } while (before != after || (before & 1));
+        
+        T value;
+        std::memcpy(&value, buffer, sizeof(T));
+        return value;
+    }
+    
+    // Number of completed writes
+    uint64_t version() const noexcept { return sequence_.load(std::memory_order_acquire) / 2; }
+};
+
+// Best bid/offer published by a book after every change
+struct TopOfBook {
+    uint64_t best_bid_price = 0;
+    uint64_t best_bid_quantity = 0;
+    uint64_t best_ask_price = 0;
+    uint64_t best_ask_quantity = 0;
+};
+
+// Commands a book applies, in the order it applies them
+enum class JournalCommand : uint8_t {
+    NEW_ORDER = 0,
+    CANCEL = 1,
+    MODIFY = 2,              // Cancel/replace with the new quantity and price
+    ADVANCE_TIME = 3         // Timer-driven clock advance; timestamp only
+};
+
+// One entry of the sequenced command journal. Applying a symbol's records
+// in sequence order to a fresh book reproduces that book.
+struct JournalRecord {
+    uint64_t sequence = 0;
+    uint64_t timestamp = 0;          // Book clock in microseconds, non-decreasing per symbol
+    uint64_t order_id = 0;
+    uint64_t quantity = 0;
+    uint64_t price = 0;
+    uint32_t symbol_id = 0;
+    uint32_t account_id = 0;
+    uint32_t session_id = 0;
+    ClOrdId cl_ord_id;               // NEW_ORDER and MODIFY on a session; empty otherwise
+    JournalCommand command = JournalCommand::NEW_ORDER;
+    Side side = Side::BUY;
+    OrderType order_type = OrderType::LIMIT;
+};
+
+// Receives each record under the book lock and may restamp its sequence
+using JournalSink = std::function<void(JournalRecord&)>;
+
+// Price protection for market-type orders: levels beyond a collar from the
+// opposite best at arrival are not taken. With both limits set the tighter
+// one applies.
+struct MarketProtection {
+    uint32_t collar_ticks = 0;       // 0 disables
+    uint64_t tick_size = 1;
+    uint32_t collar_bps = 0;         // 0 disables
+};
+
+// Microstructure features computed by a book on every update
+struct BookFeaturesConfig {
+    static constexpr uint32_t kMaxDepth = 16;
+    
+    uint32_t depth = 0;              // Levels per side; 0 disables
+    double ewma_alpha = 0.05;        // Weight of the newest BBO change in the rolling stats
+};
+
+// Published lock-free with the BBO; exactly one cache line
+struct BookFeatures {
+    double imbalance = 0.0;              // Top level (bid - ask) / (bid + ask) quantity
+    double depth_imbalance = 0.0;        // The same over the configured depth
+    double microprice = 0.0;             // Quantity-weighted toward the thinner side
+    double depth_weighted_mid = 0.0;     // Mean of the two sides' VWAPs over the depth
+    double spread_mean = 0.0;            // EWMA of the spread per BBO change
+    double spread_volatility = 0.0;      // EWMA standard deviation of the spread
+    double mid_volatility = 0.0;         // EWMA standard deviation of mid changes
+    uint64_t bbo_changes = 0;
+};
+
+// Fill an order would receive against a single resting order
+struct SimulatedFill {
+    uint64_t resting_order_id;
+    uint64_t price;
+    uint64_t quantity;
+};
+
+// Result of a non-mutating match simulation (pre-trade market impact)
+struct MatchSimulation {
+    std::vector<SimulatedFill> fills;
+    uint64_t filled_quantity = 0;
+    uint64_t remaining_quantity = 0;
+    uint32_t levels_consumed = 0;   // Price levels touched, fully or partially
+    double average_price = 0.0;
+};
+
 // Price level containing orders at the same price
 class PriceLevel {
 private:
@@ -109,16 +374,67 @@ public:
     // Get best order (FIFO within price level)
     std::shared_ptr<Order> get_best_order();
     
+    // Append the fills a quantity would receive here without modifying any order;
+    // returns the quantity filled at this level
+    uint64_t simulate_fills(uint64_t price, uint64_t quantity, std::vector<SimulatedFill>& fills) const;
+    
+    // Reduce resting quantity after a fill against an order at this level
+    void reduce_quantity(uint64_t quantity) noexcept;
+    
     // Get total quantity at this price level
     uint64_t get_total_quantity() const noexcept { return total_quantity_.load(); }
     
     // Get number of orders at this price level
     size_t get_order_count() const;
     
+    // Append copies of the resting orders in time priority
+    void copy_orders(std::vector<Order>& out) const;
+    
     // Check if price level is empty
     bool is_empty() const;
 };
 
+// Engine-internal observer of order lifecycle events. Invoked synchronously
+// on the matching path under the book lock, so implementations must be
+// short and must not call back into the book.
+class OrderEventListener {
+public:
+    virtual ~OrderEventListener() = default;
+    
+    // Order entering the matching stage, before any fills
+    virtual void on_accept(const Order& /*order*/) {}
+    
+    // Market-to-limit remainder turned into a limit order at its last fill
+    // price, just before it rests
+    virtual void on_convert(const Order& /*order*/) {}
+    
+    // Order (or its remainder) joining a price level queue, after matching
+    virtual void on_rest(const Order& /*order*/) {}
+    
+    // Quantity of an order executed at price
+    virtual void on_fill(const Order& /*order*/, uint64_t /*quantity*/, uint64_t /*price*/) {}
+    
+    // Unfilled quantity of an order leaving the book without executing
+    // (cancelled or an unfillable market remainder)
+    virtual void on_cancel(const Order& /*order*/, uint64_t /*quantity*/) {}
+    
+    // Order replaced in place under the same id, before the replacement
+    // matches; by default a cancel of the original and an accept of the new
+    virtual void on_replace(const Order& original, const Order& replacement) {
+        on_cancel(original, original.remaining_quantity());
+        on_accept(replacement);
+    }
+    
+    // Trade printed, after both sides' on_fill
+    virtual void on_trade(const Trade& /*trade*/) {}
+    
+    // Book state replaced from a snapshot: each resting order is dropped,
+    // then each snapshot order is reinstated just before it rests. Nothing
+    // executes, so no reports are due.
+    virtual void on_restore_drop(const Order& /*order*/) {}
+    virtual void on_restore(const Order& /*order*/) {}
+};
+
 // Market data snapshot
 struct MarketDataSnapshot {
     uint32_t symbol_id;
@@ -137,6 +453,81 @@ struct MarketDataSnapshot {
           last_trade_price(0), last_trade_quantity(0), volume(0) {}
 };
 
+// Trading phase of a book under price band protection
+enum class TradingState : uint8_t {
+    CONTINUOUS = 0,
+    LIMIT_STATE = 1,     // Best bid at the upper band or best ask at the lower band
+    HALTED = 2           // Call phase of the reopening volatility auction
+};
+
+// Limit-up/limit-down style protection for one book. Times are in the
+// microseconds of Order::timestamp.
+struct PriceBandConfig {
+    uint32_t band_bps = 0;                          // Half-width around the reference; 0 disables
+    uint64_t reference_window_us = 300'000'000;     // Rolling mean of trade prices
+    uint64_t limit_state_us = 15'000'000;           // Time in a limit state before halting
+    uint64_t halt_us = 300'000'000;                 // Halt length before the reopening auction
+    uint64_t initial_reference_price = 0;           // E.g. the previous close; 0 waits for a trade
+};
+
+// Band state, republished lock-free on every change
+struct PriceBands {
+    uint64_t reference_price = 0;
+    uint64_t lower = 0;                 // Both 0 while bands are inactive
+    uint64_t upper = 0;
+    uint64_t state_deadline_us = 0;     // End of the limit state or halt
+    TradingState state = TradingState::CONTINUOUS;
+};
+
+// Rolling mean of trade prices over a time window. Prints are summed into a
+// ring of time buckets with running totals, so adding a print and reading
+// the mean are O(1); expiring old buckets is bounded by the ring size.
+class RollingPriceAverage {
+public:
+    static constexpr size_t kBuckets = 64;
+    
+    explicit RollingPriceAverage(uint64_t window_us = 300'000'000) noexcept { reset(window_us); }
+    
+    void reset(uint64_t window_us) noexcept;
+    void add(uint64_t time_us, uint64_t price) noexcept;
+    
+    // Mean over the window ending at time_us; 0 if it holds no prints
+    uint64_t mean(uint64_t time_us) noexcept;
+    
+private:
+    uint64_t bucket_us_;
+    uint64_t head_;                     // Absolute index of the newest bucket
+    uint64_t price_sum_[kBuckets];
+    uint64_t count_[kBuckets];
+    uint64_t total_sum_;
+    uint64_t total_count_;
+    
+    void expire(uint64_t time_us) noexcept;
+};
+
+// Point-in-time copy of one book: resting orders in priority order plus the
+// clock, statistics, protection and feature state needed to continue from it
+struct BookSnapshot {
+    uint32_t symbol_id = 0;
+    uint64_t sequence = 0;               // Last journal sequence applied
+    uint64_t clock_us = 0;
+    uint64_t next_trade_id = 1;
+    uint64_t total_volume = 0;
+    uint64_t trade_count = 0;
+    uint64_t last_trade_price = 0;
+    uint64_t last_trade_quantity = 0;
+    MarketProtection market_protection;
+    PriceBandConfig band_config;
+    RollingPriceAverage band_reference;
+    PriceBands bands;
+    BookFeaturesConfig feature_config;
+    BookFeatures features;
+    TopOfBook feature_top;
+    double spread_variance = 0.0;
+    double mid_variance = 0.0;
+    std::vector<Order> orders;           // Bids best first, then asks best first; FIFO within a level
+};
+
 // Order book for a single symbol
 class OrderBook {
 private:
@@ -159,20 +550,67 @@ private:
     // Statistics
     std::atomic<uint64_t> total_volume_{0};
     std::atomic<uint64_t> trade_count_{0};
+    std::atomic<uint64_t> last_trade_price_{0};
+    std::atomic<uint64_t> last_trade_quantity_{0};
+    
+    // Lifecycle listeners (registered before the book is shared)
+    std::vector<OrderEventListener*> listeners_;
+    
+    // Lock-free copy of the BBO, republished under the book lock
+    SeqLocked<TopOfBook> top_of_book_;
+    
+    // Market order protection, guarded by book_mutex_
+    MarketProtection market_protection_;
+    
+    // Command journal, guarded by book_mutex_
+    JournalSink journal_;
+    uint64_t journal_sequence_ = 0;     // Last sequence journaled, as restamped by the sink
+    
+    // Microstructure features, guarded by book_mutex_
+    BookFeaturesConfig feature_config_;
+    BookFeatures features_;
+    TopOfBook feature_top_;              // BBO of the last feature update
+    double spread_variance_ = 0.0;
+    double mid_variance_ = 0.0;
+    SeqLocked<BookFeatures> published_features_;
+    
+    // Price band protection, guarded by book_mutex_
+    PriceBandConfig band_config_;
+    RollingPriceAverage band_reference_;
+    PriceBands bands_;
+    uint64_t clock_us_ = 0;             // Latest event time seen
+    SeqLocked<PriceBands> published_bands_;
     
     // Market data callbacks
-    std::vector<std::function<void(const MarketDataSnapshot&)>> market_data_callbacks_;
+    std::vector<std::pair<uint64_t, std::function<void(const MarketDataSnapshot&)>>> market_data_callbacks_;
+    uint64_t next_callback_token_ = 1;           // Under callbacks_mutex_
     std::vector<std::function<void(const Trade&)>> trade_callbacks_;
-    mutable std::mutex callbacks_mutex_;
+    mutable std::mutex callbacks_mutex_;          // Market data callbacks, taken without the book lock
+    mutable std::mutex trade_callbacks_mutex_;    // Trade callbacks, taken under the book lock
     
-    // Internal helper methods
+    // Internal helper methods; process_* and remove_from_book expect book_mutex_ held
     void process_limit_order(std::shared_ptr<Order> order);
     void process_market_order(std::shared_ptr<Order> order);
+    void remove_from_book(const Order& order, bool erase_empty_level = true);
+    bool cancel_locked(Order& order);
     bool try_match_order(std::shared_ptr<Order> order, std::map<uint64_t, std::unique_ptr<PriceLevel>>& opposite_side);
-    void execute_trade(std::shared_ptr<Order> buy_order, std::shared_ptr<Order> sell_order, uint64_t quantity);
+    void match_at_level(const std::shared_ptr<Order>& order, PriceLevel& level, uint64_t price);
+    uint64_t market_collar(Side side, uint64_t opposite_best) const noexcept;
+    void execute_trade(std::shared_ptr<Order> aggressor, std::shared_ptr<Order> resting, uint64_t quantity, uint64_t price);
     void add_to_book(std::shared_ptr<Order> order);
-    void notify_market_data();
+    void publish_top_of_book();
+    void update_features(const TopOfBook& top);
     void notify_trade(const Trade& trade);
+    void journal_command(JournalCommand command, const Order* order);
+    
+    // Band helpers; all expect book_mutex_ held
+    bool advance_clock(uint64_t now_us);
+    void set_reference_price(uint64_t reference_price);
+    void update_limit_state(const TopOfBook& top);
+    void run_volatility_auction();
+    bool within_band(uint64_t price) const noexcept {
+        return bands_.upper == 0 || (price >= bands_.lower && price <= bands_.upper);
+    }
     
 public:
     explicit OrderBook(uint32_t symbol_id) : symbol_id_(symbol_id) {}
@@ -180,23 +618,541 @@ public:
     // Order management
     bool add_order(std::shared_ptr<Order> order);
     bool cancel_order(uint64_t order_id);
-    bool modify_order(uint64_t order_id, uint64_t new_quantity, uint64_t new_price = 0);
+    
+    // Cancel many orders under one book lock with a single market data
+    // update; returns the number cancelled
+    size_t cancel_orders(const std::vector<uint64_t>& order_ids);
+    
+    // Cancel/replace in one book-lock epoch; the order loses time priority.
+    // A timestamp of 0 stamps the replacement with the current time; a null
+    // cl_ord_id keeps the original's ClOrdID.
+    bool modify_order(uint64_t order_id, uint64_t new_quantity, uint64_t new_price = 0, uint64_t timestamp = 0,
+                      const ClOrdId* cl_ord_id = nullptr);
+    
+    // Batched updates: take the book lock once, apply any number of quote
+    // replacements, then release it and call notify_market_data() once
+    std::unique_lock<std::shared_mutex> lock_for_update() { return std::unique_lock<std::shared_mutex>(book_mutex_); }
+    void replace_quotes_locked(const std::vector<uint64_t>& cancel_ids,
+                               const std::vector<std::shared_ptr<Order>>& quotes);
+    
+    // Push a snapshot to market data subscribers; call without the book lock
+    void notify_market_data();
+    
+    // Drop all resting orders and statistics (callbacks are kept)
+    void reset();
+    
+    // Collar for market and market-to-limit orders; configure before trading
+    void set_market_protection(const MarketProtection& protection);
+    
+    // Record every applied command (new, cancel, modify, timer advance)
+    // under the book lock, numbered per book in application order
+    void set_journal(JournalSink sink);
+    
+    // Consistent copy of the book at its last journaled sequence, and the
+    // inverse: replace this book's state with a snapshot (callbacks, listeners
+    // and the journal sink are kept)
+    BookSnapshot snapshot() const;
+    void restore(const BookSnapshot& snapshot);
+    
+    // Limit-up/limit-down protection. Executions are confined to bands
+    // around a rolling mean of trade prices; a limit remainder that still
+    // crosses prices outside the band is cancelled rather than rested. A
+    // book whose best bid or ask stays at a band for limit_state_us halts:
+    // limit orders rest without matching and market orders are rejected
+    // until halt_us has passed, then a single-price auction reopens it at a
+    // new reference. Transitions are driven by order timestamps or advance_time.
+    // Reconfiguring a halted book runs its reopening auction first.
+    void set_price_bands(const PriceBandConfig& config);
+    void advance_time(uint64_t now_us);
+    PriceBands get_price_bands() const noexcept { return published_bands_.load(); }
+    
+    // Look up an order known to this book
+    std::shared_ptr<Order> find_order(uint64_t order_id) const;
     
     // Market data queries
     MarketDataSnapshot get_market_data() const;
     std::vector<std::pair<uint64_t, uint64_t>> get_bid_levels(uint32_t depth = 10) const;
     std::vector<std::pair<uint64_t, uint64_t>> get_ask_levels(uint32_t depth = 10) const;
     
-    // Callback registration
-    void register_market_data_callback(std::function<void(const MarketDataSnapshot&)> callback);
+    // Lock-free BBO read; never waits on matching
+    TopOfBook get_top_of_book() const noexcept { return top_of_book_.load(); }
+    
+    // Imbalance, microprice, depth-weighted mid and rolling spread and mid
+    // statistics, recomputed from the top levels whenever the BBO is
+    // published. Configure before trading starts; reads are lock-free.
+    void set_features(const BookFeaturesConfig& config);
+    BookFeatures get_features() const noexcept { return published_features_.load(); }
+    
+    // Copy up to depth (price, quantity) levels of one side into a caller buffer
+    uint32_t copy_levels(Side side, std::pair<uint64_t, uint64_t>* out, uint32_t depth) const;
+    
+    // Dry-run match under a reader lock; limit_price of 0 means no price limit
+    MatchSimulation simulate_match(Side side, uint64_t quantity, uint64_t limit_price = 0) const;
+    
+    // Callback registration. A market data callback's token unregisters it;
+    // once unregister returns the callback is not running and never runs again.
+    uint64_t register_market_data_callback(std::function<void(const MarketDataSnapshot&)> callback);
+    void unregister_market_data_callback(uint64_t token);
     void register_trade_callback(std::function<void(const Trade&)> callback);
     
+    // Attach an engine component to fill/cancel events; not thread-safe
+    // against concurrent order flow, so register before trading starts
+    void add_listener(OrderEventListener* listener);
+    
     // Statistics
     uint64_t get_total_volume() const noexcept { return total_volume_.load(); }
+    uint64_t get_last_trade_price() const noexcept { return last_trade_price_.load(std::memory_order_relaxed); }
     uint64_t get_trade_count() const noexcept { return trade_count_.load(); }
     uint32_t get_symbol_id() const noexcept { return symbol_id_; }
 };
 
+// Reason an order failed symbol reference data validation
+enum class ValidationResult : uint8_t {
+    OK = 0,
+    INVALID_QUANTITY = 1,          // Zero or not a multiple of the lot size
+    INVALID_TICK = 2,              // Price not on the tick grid of its band
+    OUTSIDE_STATIC_BAND = 3,
+    OUTSIDE_DYNAMIC_BAND = 4
+};
+
+// Static reference data for one symbol: a tick table by price band, lot
+// size and static/dynamic price bands. Fixed size so a table of them is a
+// dense array; unused tick bands have a floor of UINT64_MAX.
+struct SymbolRules {
+    static constexpr size_t kMaxTickBands = 4;
+    
+    uint64_t band_floor[kMaxTickBands] = {0, UINT64_MAX, UINT64_MAX, UINT64_MAX};
+    uint64_t band_tick[kMaxTickBands] = {1, 1, 1, 1};
+    uint64_t lot_size = 1;
+    uint64_t min_price = 1;              // Static band, inclusive
+    uint64_t max_price = UINT64_MAX;
+    uint32_t dynamic_band_bps = 0;       // Around the reference price; 0 disables
+    
+    // Tick size for prices at or above floor; bands must be added in
+    // ascending order of floor. The first band always starts at 0.
+    bool add_tick_band(uint64_t floor, uint64_t tick_size) noexcept;
+    
+    // Tick grid at a price: one compare-and-select per band, no branches
+    uint64_t tick_size_at(uint64_t price) const noexcept {
+        uint64_t tick = band_tick[0];
+        for (size_t i = 1; i < kMaxTickBands; ++i) {
+            tick = price >= band_floor[i] ? band_tick[i] : tick;
+        }
+        return tick;
+    }
+    
+    // All checks are evaluated and folded into a bitmask; market orders
+    // skip the price checks. A reference price of 0 skips the dynamic band.
+    ValidationResult validate(OrderType type, uint64_t quantity, uint64_t price,
+                              uint64_t reference_price) const noexcept;
+    
+    // Valid prices in the static band, and a price's index among them; an
+    // array-based book sizes and addresses its ladder with these
+    uint64_t ladder_levels() const noexcept;
+    uint64_t ladder_index(uint64_t price) const noexcept;
+    uint64_t grid_prices_up_to(uint64_t price) const noexcept;
+};
+
+// Dense, read-mostly table of SymbolRules indexed by symbol id. Symbols
+// without an entry use the default rules. Configure before trading starts.
+class SymbolRulesTable {
+public:
+    static constexpr uint32_t kMaxSymbols = 1u << 20;
+    
+    // False for an out-of-range symbol, or a zero lot size or tick
+    bool set(uint32_t symbol_id, const SymbolRules& rules);
+    
+    const SymbolRules& get(uint32_t symbol_id) const noexcept {
+        return symbol_id < rules_.size() ? rules_[symbol_id] : default_rules_;
+    }
+    
+private:
+    std::vector<SymbolRules> rules_;
+    SymbolRules default_rules_;
+};
+
+// Pre-trade risk limits; a zero field disables that check
+struct RiskLimits {
+    uint64_t max_order_quantity = 0;
+    uint64_t max_order_notional = 0;     // quantity * price, in ticks
+    uint64_t max_open_notional = 0;      // Per account: resting plus in-flight orders
+    uint32_t price_collar_bps = 0;       // Max distance of a limit price from the reference price
+};
+
+// Reason a pre-trade check rejected an order
+enum class RiskRejectReason : uint8_t {
+    NONE = 0,
+    PRICE_COLLAR = 1,
+    MAX_ORDER_QUANTITY = 2,
+    MAX_ORDER_NOTIONAL = 3,
+    OPEN_NOTIONAL_LIMIT = 4
+};
+
+// In-engine pre-trade risk stage.
+//
+// Per-account state lives in open-addressing tables split across shards by
+// account id; each shard is cache-line aligned and guarded by its own
+// spinlock, so checks for different accounts never contend and no check
+// takes a global lock. Open notional is reserved when a limit order passes
+// and released from fills and cancels via OrderEventListener. Market
+// orders are checked against the reference price but never reserve, since
+// they cannot rest.
+class RiskEngine : public OrderEventListener {
+public:
+    static constexpr size_t kShards = 64;
+    
+    RiskEngine();
+    
+    // Limits for accounts without an override; configure before trading starts
+    void set_default_limits(const RiskLimits& limits) noexcept { default_limits_ = limits; }
+    void set_account_limits(uint32_t account_id, const RiskLimits& limits);
+    
+    // Check an order and, if it passes, reserve its open notional.
+    // credit_notional is exposure about to be released by a replaced order.
+    RiskRejectReason check_and_reserve(uint32_t account_id, OrderType type, uint64_t quantity,
+                                       uint64_t price, uint64_t reference_price,
+                                       uint64_t credit_notional = 0);
+    
+    // Return previously reserved notional
+    void release(uint32_t account_id, uint64_t notional);
+    
+    // Reserve without checking, for orders already accepted upstream
+    void reserve(uint32_t account_id, uint64_t notional);
+    
+    uint64_t get_open_notional(uint32_t account_id) const;
+    uint64_t get_reject_count() const noexcept { return reject_count_.load(std::memory_order_relaxed); }
+    
+    // OrderEventListener
+    void on_convert(const Order& order) override;
+    void on_fill(const Order& order, uint64_t quantity, uint64_t price) override;
+    void on_cancel(const Order& order, uint64_t quantity) override;
+    void on_restore_drop(const Order& order) override;
+    void on_restore(const Order& order) override;
+    
+private:
+    struct AccountState {
+        uint32_t account_id = 0;
+        bool occupied = false;
+        bool has_limits = false;
+        RiskLimits limits;
+        uint64_t open_notional = 0;
+    };
+    
+    struct alignas(64) Shard {
+        mutable std::atomic_flag lock = ATOMIC_FLAG_INIT;
+        std::vector<AccountState> slots;     // Power-of-two capacity, linear probing
+        size_t size = 0;
+    };
+    
+    RiskLimits default_limits_;
+    std::unique_ptr<Shard[]> shards_;
+    std::atomic<uint64_t> reject_count_{0};
+    
+    static size_t shard_index(uint32_t account_id) noexcept { return account_id % kShards; }
+    static AccountState& find_or_insert(Shard& shard, uint32_t account_id);
+    static const AccountState* find(const Shard& shard, uint32_t account_id) noexcept;
+};
+
+// Net position and cost basis of one account in one symbol
+struct PositionState {
+    int64_t position = 0;            // Signed: long > 0, short < 0
+    double average_cost = 0.0;       // Average entry price of the open position
+    double realized_pnl = 0.0;       // In price ticks * quantity
+    uint64_t bought_quantity = 0;
+    uint64_t sold_quantity = 0;
+};
+
+// Per-account position and P&L keeper fed from fills.
+//
+// Fills for a symbol are serialized by that book's lock, so each
+// (account, symbol) record has exactly one writer at a time. The writer
+// publishes every update through a SeqLocked copy, so reads never take the
+// book lock and never block matching; the shard lock only guards record
+// creation. Account 0 is unattributed and not tracked.
+class PositionKeeper : public OrderEventListener {
+public:
+    static constexpr size_t kShards = 16;
+    
+    PositionKeeper();
+    
+    // Latest published state; false if the account never traded the symbol
+    bool get_position(uint32_t account_id, uint32_t symbol_id, PositionState& state) const;
+    
+    // All symbols the account has traded
+    std::vector<std::pair<uint32_t, PositionState>> get_account_positions(uint32_t account_id) const;
+    
+    // OrderEventListener
+    void on_fill(const Order& order, uint64_t quantity, uint64_t price) override;
+    
+private:
+    struct PositionRecord {
+        PositionState working;                 // Writer-private
+        SeqLocked<PositionState> published;
+    };
+    
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<uint64_t, std::unique_ptr<PositionRecord>> records;
+    };
+    
+    std::unique_ptr<Shard[]> shards_;
+    
+    static uint64_t position_key(uint32_t account_id, uint32_t symbol_id) noexcept {
+        return (static_cast<uint64_t>(account_id) << 32) | symbol_id;
+    }
+    static size_t shard_index(uint64_t key) noexcept { return (key * 0x9E3779B97F4A7C15ULL) >> 60; }
+    PositionRecord& find_or_insert(uint64_t key);
+};
+
+// Execution state of one order as seen by clients
+struct OrderState {
+    uint64_t order_id = 0;           // 0 if the order is unknown
+    uint64_t filled_quantity = 0;
+    uint64_t remaining_quantity = 0;
+    double average_price = 0.0;      // Of the fills so far
+    OrderStatus status = OrderStatus::NEW;
+};
+
+// Versioned per-order state records, indexed directly by engine order id.
+//
+// Records live in fixed-size chunks allocated on first use and never freed
+// before the store is destroyed, so a lookup is two loads plus a seqlock
+// read and never blocks matching. Each record is written only under its
+// book's lock, which gives the seqlock its single writer.
+class OrderStateStore : public OrderEventListener {
+public:
+    static constexpr size_t kChunkBits = 12;
+    static constexpr size_t kChunkSize = size_t(1) << kChunkBits;
+    static constexpr size_t kMaxChunks = size_t(1) << 16;
+    
+    OrderStateStore();
+    ~OrderStateStore() override;
+    
+    OrderStateStore(const OrderStateStore&) = delete;
+    OrderStateStore& operator=(const OrderStateStore&) = delete;
+    
+    // False if the id was never seen
+    bool get(uint64_t order_id, OrderState& state) const noexcept;
+    
+    // OrderEventListener
+    void on_accept(const Order& order) override;
+    void on_fill(const Order& order, uint64_t quantity, uint64_t price) override;
+    void on_cancel(const Order& order, uint64_t quantity) override;
+    void on_restore(const Order& order) override;
+    
+private:
+    struct Record {
+        SeqLocked<OrderState> published;
+        OrderState working;          // Writer-private
+        double fill_notional = 0.0;
+    };
+    
+    std::unique_ptr<std::atomic<Record*>[]> chunks_;
+    
+    Record* record(uint64_t order_id);
+};
+
+// OHLCV bar with VWAP for one symbol and interval
+struct Bar {
+    uint32_t symbol_id = 0;
+    uint64_t interval_us = 0;
+    uint64_t start_us = 0;           // Interval-aligned, in Trade::timestamp units
+    uint64_t open = 0;
+    uint64_t high = 0;
+    uint64_t low = 0;
+    uint64_t close = 0;
+    uint64_t volume = 0;
+    uint64_t trade_count = 0;
+    double notional = 0.0;
+    
+    double vwap() const noexcept { return volume ? notional / static_cast<double>(volume) : 0.0; }
+};
+
+// Time bars built from the trade path. Each attached book gets its own feed
+// listener that copies a 24-byte print into an SPSC ring under the book
+// lock; everything else runs on the consumer thread in poll(), which folds
+// each print into every interval's bar in O(1) and emits bars as the next
+// print (or flush) closes them.
+class BarAggregator {
+public:
+    static constexpr size_t kDefaultRingCapacity = 1 << 16;
+    
+    explicit BarAggregator(std::vector<uint64_t> intervals_us, size_t ring_capacity = kDefaultRingCapacity);
+    
+    // Feed a book's trades into the aggregator; register before trading starts
+    void attach(OrderBook& book);
+    
+    // Completed bars are delivered on the thread calling poll or flush;
+    // callbacks must not call back into the aggregator
+    void subscribe(std::function<void(const Bar&)> callback);
+    
+    // Drain queued prints from every feed; returns prints aggregated. One
+    // consumer thread at a time.
+    size_t poll();
+    
+    // Emit bars whose interval ended by now_us, for symbols gone quiet;
+    // returns bars emitted
+    size_t flush(uint64_t now_us);
+    
+    // Bar in progress for a symbol and interval index; consumer thread only
+    bool current_bar(uint32_t symbol_id, size_t interval, Bar& out) const;
+    
+    uint64_t get_dropped_prints() const;
+    const std::vector<uint64_t>& intervals() const noexcept { return intervals_; }
+    
+private:
+    struct Print {
+        uint64_t timestamp;
+        uint64_t price;
+        uint64_t quantity;
+    };
+    
+    class Feed : public OrderEventListener {
+    public:
+        Feed(uint32_t symbol, size_t ring_capacity) : symbol_id(symbol), ring(ring_capacity) {}
+        
+        void on_trade(const Trade& trade) override {
+            if (!ring.try_push({trade.timestamp, trade.price, trade.quantity})) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        
+        uint32_t symbol_id;
+        SpscRing<Print> ring;
+        std::atomic<uint64_t> dropped{0};
+        std::vector<Bar> bars;           // One per interval, consumer-owned
+    };
+    
+    std::vector<uint64_t> intervals_;
+    size_t ring_capacity_;
+    std::vector<std::unique_ptr<Feed>> feeds_;
+    std::vector<std::function<void(const Bar&)>> callbacks_;
+    std::vector<Print> scratch_;
+    mutable std::mutex mutex_;           // Feeds and callbacks against attach
+    
+    void emit(Bar& bar);
+};
+
+// Compact time-and-sales record
+struct TapePrint {
+    uint64_t timestamp;
+    uint64_t trade_id;
+    uint64_t price;
+    uint64_t quantity;
+};
+
+// Fixed-capacity time-and-sales ring for one symbol, attached to its book
+// as a listener. Prints are appended in arrival order with timestamps
+// clamped to be non-decreasing, so the ring is its own time index and
+// range queries binary search it. Readers never lock: they copy, then
+// check against the writer's claim counter that nothing they used was
+// overwritten meanwhile, and retry if it was.
+class TradeTape : public OrderEventListener {
+public:
+    // Capacity is rounded up to a power of two
+    explicit TradeTape(size_t capacity);
+    
+    // Single writer: the owning book, under its lock
+    void on_trade(const Trade& trade) override;
+    
+    // Prints appended since creation (older ones are overwritten)
+    uint64_t total() const noexcept { return count_.load(std::memory_order_acquire); }
+    size_t capacity() const noexcept { return mask_ + 1; }
+    
+    // Up to count most recent prints, oldest first
+    size_t last(size_t count, TapePrint* out) const;
+    
+    // Prints with from_timestamp <= timestamp <= to_timestamp, oldest
+    // first, up to max_count
+    size_t between(uint64_t from_timestamp, uint64_t to_timestamp, TapePrint* out, size_t max_count) const;
+    
+private:
+    static constexpr size_t kWords = sizeof(TapePrint) / sizeof(uint64_t);
+    
+    std::unique_ptr<std::atomic<uint64_t>[]> words_;
+    uint64_t mask_;
+    alignas(64) std::atomic<uint64_t> claimed_{0};     // Positions the writer has started
+    std::atomic<uint64_t> count_{0};                   // Positions fully written
+    uint64_t last_timestamp_ = 0;                      // Writer-private
+    
+    void read(uint64_t position, TapePrint& out) const noexcept;
+    uint64_t timestamp_at(uint64_t position) const noexcept {
+        return words_[(position & mask_) * kWords].load(std::memory_order_relaxed);
+    }
+    // Oldest position not yet overwritten, judged after reading
+    uint64_t oldest_valid() const noexcept {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t claimed = claimed_.load(std::memory_order_relaxed);
+        return claimed > capacity() ? claimed - capacity() : 0;
+    }
+};
+
+// Position with mark-to-market P&L
+struct PositionSnapshot {
+    uint32_t account_id = 0;
+    uint32_t symbol_id = 0;
+    PositionState state;
+    uint64_t mark_price = 0;         // Bid for longs, ask for shorts, else last trade
+    double unrealized_pnl = 0.0;
+};
+
+// Flat open-addressing index from ClOrdID to the owning book and order.
+// One per session; entries are kept for the session's lifetime so a
+// ClOrdID can never be reused, as FIX requires. Not thread-safe.
+class ClientOrderIndex {
+public:
+    struct Entry {
+        ClOrdId id;
+        uint64_t hash = 0;
+        uint64_t order_id = 0;       // 0 marks an empty slot
+        uint32_t symbol_id = 0;
+    };
+    
+    ClientOrderIndex() : slots_(16) {}
+    
+    // False if the id is already present
+    bool insert(const ClOrdId& id, uint64_t order_id, uint32_t symbol_id);
+    const Entry* find(const ClOrdId& id) const noexcept;
+    size_t size() const noexcept { return size_; }
+    
+private:
+    std::vector<Entry> slots_;       // Power-of-two capacity, linear probing
+    size_t size_ = 0;
+    
+    void grow();
+};
+
+// Execution report kinds
+enum class ExecType : uint8_t {
+    ACK = 0,
+    PARTIAL_FILL = 1,
+    FILL = 2,
+    CANCEL = 3,
+    REJECT = 4,
+    REPLACE = 5
+};
+
+// Per-order event delivered to the owning client session
+struct ExecutionReport {
+    uint64_t order_id = 0;
+    uint64_t price = 0;                  // Order's limit price
+    uint64_t last_quantity = 0;          // Fills only
+    uint64_t last_price = 0;             // Fills only
+    uint64_t cumulative_quantity = 0;
+    uint64_t leaves_quantity = 0;
+    uint32_t symbol_id = 0;
+    ExecType type = ExecType::ACK;
+    Side side = Side::BUY;
+};
+
+// One leg of a mass quote; quantity 0 only pulls the symbol's quotes
+struct QuoteEntry {
+    uint32_t symbol_id = 0;
+    Side side = Side::BUY;
+    uint64_t price = 0;
+    uint64_t quantity = 0;
+};
+
 // High-performance order book simulator
 class OrderBookSimulator {
 private:
@@ -217,27 +1173,266 @@ private:
     std::atomic<uint64_t> orders_processed_{0};
     std::atomic<uint64_t> total_latency_ns_{0};
     
+    // Symbol reference data checked before the risk stage
+    SymbolRulesTable symbol_rules_;
+    std::atomic<uint64_t> validation_rejects_{0};
+    
+    // Pre-trade risk stage, attached to every book as a listener
+    RiskEngine risk_engine_;
+    
+    // Post-trade positions, attached to every book as a listener
+    PositionKeeper position_keeper_;
+    
+    // Per-order execution state, attached to every book as a listener
+    OrderStateStore order_states_;
+    
+    // Optional bar aggregation, attached to every book once enabled
+    std::unique_ptr<BarAggregator> bars_;
+    
+    // Optional time-and-sales tapes by symbol, guarded by books_mutex_
+    size_t tape_capacity_ = 0;
+    std::unordered_map<uint32_t, std::unique_ptr<TradeTape>> tapes_;
+    
+    // Optional command journal across all books, guarded by books_mutex_
+    std::function<void(const JournalRecord&)> journal_;
+    std::atomic<uint64_t> journal_sequence_{0};
+    void attach_journal(OrderBook& order_book);
+    
+    // Ids and sequence numbers issued from here on continue past these
+    void advance_counters(uint64_t order_id, uint64_t sequence) noexcept;
+    
+    // External listeners attached to every book, guarded by books_mutex_
+    std::vector<OrderEventListener*> book_listeners_;
+    
+    PositionSnapshot mark_position(uint32_t account_id, uint32_t symbol_id, const PositionState& state) const;
+    
+    // Per-session client order state
+    struct ClientSession {
+        explicit ClientSession(size_t report_capacity) : reports(report_capacity) {}
+        
+        mutable std::mutex mutex;                 // Client requests
+        ClientOrderIndex index;
+        std::unordered_map<uint32_t, std::vector<uint64_t>> quotes;   // Quote order ids per symbol
+        SpscRing<ExecutionReport> reports;
+        std::atomic_flag report_lock = ATOMIC_FLAG_INIT;   // Books reporting concurrently
+        std::atomic<uint64_t> dropped_reports{0};
+        
+        // Live orders, linked through Order::session_prev/next under report_lock
+        Order* live_head = nullptr;
+        size_t live_count = 0;
+        std::atomic<int64_t> last_heartbeat_ns{0};          // 0 until the first heartbeat
+        
+        void link(const Order& order) noexcept {
+            order.session_prev = nullptr;
+            order.session_next = live_head;
+            if (live_head) {
+                live_head->session_prev = const_cast<Order*>(&order);
+            }
+            live_head = const_cast<Order*>(&order);
+            live_count++;
+        }
+        
+        void unlink(const Order& order) noexcept {
+            if (order.session_prev) {
+                order.session_prev->session_next = order.session_next;
+            } else if (live_head == &order) {
+                live_head = order.session_next;
+            } else {
+                return;    // Not linked
+            }
+            if (order.session_next) {
+                order.session_next->session_prev = order.session_prev;
+            }
+            order.session_prev = order.session_next = nullptr;
+            live_count--;
+        }
+    };
+    
+    // Sessions indexed directly by id, created once and kept for the
+    // simulator's lifetime so the matching path can look them up lock-free
+    std::unique_ptr<std::atomic<ClientSession*>[]> sessions_;
+    
+    // Routes book events to the owning session's report ring
+    class ReportRouter : public OrderEventListener {
+    public:
+        explicit ReportRouter(OrderBookSimulator& simulator) : simulator_(simulator) {}
+        
+        void on_accept(const Order& order) override;
+        void on_fill(const Order& order, uint64_t quantity, uint64_t price) override;
+        void on_cancel(const Order& order, uint64_t quantity) override;
+        void on_replace(const Order& original, const Order& replacement) override;
+        void on_restore_drop(const Order& order) override;
+        void on_restore(const Order& order) override;
+        
+    private:
+        OrderBookSimulator& simulator_;
+        
+        // Queue a report and update the live-order list in one critical section
+        void publish(const Order& order, ExecType type, uint64_t last_quantity = 0, uint64_t last_price = 0,
+                     const Order* unlink = nullptr, const Order* link = nullptr);
+    };
+    ReportRouter report_router_{*this};
+    
+    std::atomic<uint32_t> session_high_water_{0};
+    
+    ClientSession* get_or_create_session(uint32_t session_id, size_t report_capacity = kDefaultReportCapacity);
+    size_t purge_session(ClientSession& session);
+    ClientSession* find_session(uint32_t session_id) const noexcept;
+    uint64_t place_order(uint32_t symbol_id, Side side, OrderType type, uint64_t quantity, uint64_t price,
+                         uint64_t stop_price, uint32_t account_id, uint32_t session_id,
+                         const ClOrdId& cl_ord_id = ClOrdId{});
+    OrderBook* find_book(uint32_t symbol_id) const;
+    bool validate_order(uint32_t symbol_id, OrderType type, uint64_t quantity, uint64_t price, uint64_t reference_price);
+    bool modify_in_book(OrderBook& order_book, uint64_t order_id, uint64_t new_quantity, uint64_t new_price,
+                        const ClOrdId* cl_ord_id = nullptr);
+    
     void worker_thread_function();
+    OrderBook* get_or_create_book(uint32_t symbol_id);
     
 public:
+    static constexpr size_t kMaxSessions = size_t(1) << 16;
+    static constexpr size_t kDefaultReportCapacity = 4096;
+    
     OrderBookSimulator(size_t num_threads = std::thread::hardware_concurrency());
     ~OrderBookSimulator();
     
-    // Order operations
+    // Order operations; submit_order returns 0 if the risk stage rejects the order
     uint64_t submit_order(uint32_t symbol_id, Side side, OrderType type, 
-                         uint64_t quantity, uint64_t price, uint64_t stop_price = 0);
+                         uint64_t quantity, uint64_t price, uint64_t stop_price = 0,
+                         uint32_t account_id = 0);
     bool cancel_order(uint64_t order_id);
     bool modify_order(uint64_t order_id, uint64_t new_quantity, uint64_t new_price = 0);
     
+    // Order operations keyed by client order id, unique per session. Cancels
+    // and amends resolve straight to the owning book; an amend gives the
+    // order a new ClOrdID and keeps the engine order id.
+    uint64_t submit_client_order(uint32_t session_id, std::string_view cl_ord_id, uint32_t symbol_id,
+                                 Side side, OrderType type, uint64_t quantity, uint64_t price,
+                                 uint64_t stop_price = 0, uint32_t account_id = 0);
+    bool cancel_client_order(uint32_t session_id, std::string_view cl_ord_id);
+    bool modify_client_order(uint32_t session_id, std::string_view orig_cl_ord_id, std::string_view new_cl_ord_id,
+                             uint64_t new_quantity, uint64_t new_price = 0);
+    uint64_t find_client_order(uint32_t session_id, std::string_view cl_ord_id) const;
+    
+    // Replace all of a session's quotes in every symbol named in quotes.
+    // All legs pass risk or none are placed; affected books are locked
+    // together in symbol order so no order can trade against a half-updated
+    // quote, and each book publishes one market data update.
+    bool mass_quote(uint32_t session_id, const QuoteEntry* quotes, size_t count, uint32_t account_id = 0);
+    
+    // Execution reports (ack, fills, cancel, reject, replace) for a session's
+    // orders, written directly from the matching path into an SPSC ring.
+    // Sessions are created on first use with the default ring capacity, or
+    // opened explicitly before first use; ids run from 1 to kMaxSessions - 1.
+    // Each session's reports must be polled by one thread. Reports that
+    // find the ring full are dropped and counted. Risk rejects are not
+    // queued: the submit call returns 0.
+    bool open_session(uint32_t session_id, size_t report_capacity = kDefaultReportCapacity);
+    size_t poll_execution_reports(uint32_t session_id, ExecutionReport* out, size_t max_count);
+    uint64_t get_dropped_reports(uint32_t session_id) const;
+    
+    // Cancel-on-disconnect. Each session keeps an intrusive list of its live
+    // orders; a purge cancels them grouped by book, one lock acquisition and
+    // one market data update per affected symbol. Sessions that have sent a
+    // heartbeat are purged by expire_sessions once it is older than timeout.
+    size_t disconnect_session(uint32_t session_id);
+    void session_heartbeat(uint32_t session_id);
+    size_t expire_sessions(std::chrono::nanoseconds timeout);
+    size_t get_live_order_count(uint32_t session_id) const;
+    
+    // Lock-free order status; order_id is 0 in the result if unknown
+    OrderState get_order_state(uint64_t order_id) const noexcept {
+        OrderState state;
+        order_states_.get(order_id, state);
+        return state;
+    }
+    
     // Market data
     MarketDataSnapshot get_market_data(uint32_t symbol_id) const;
+    TopOfBook get_top_of_book(uint32_t symbol_id) const;
+    uint32_t copy_levels(uint32_t symbol_id, Side side, std::pair<uint64_t, uint64_t>* out, uint32_t depth) const;
     std::vector<std::pair<uint64_t, uint64_t>> get_bid_levels(uint32_t symbol_id, uint32_t depth = 10) const;
     std::vector<std::pair<uint64_t, uint64_t>> get_ask_levels(uint32_t symbol_id, uint32_t depth = 10) const;
+    MatchSimulation simulate_match(uint32_t symbol_id, Side side, uint64_t quantity, uint64_t limit_price = 0) const;
     
-    // Callback registration
-    void register_market_data_callback(uint32_t symbol_id, std::function<void(const MarketDataSnapshot&)> callback);
+    // Callback registration; see OrderBook for the unregister guarantee
+    uint64_t register_market_data_callback(uint32_t symbol_id, std::function<void(const MarketDataSnapshot&)> callback);
+    void unregister_market_data_callback(uint32_t symbol_id, uint64_t token);
     void register_trade_callback(uint32_t symbol_id, std::function<void(const Trade&)> callback);
     
+    // Pre-trade risk configuration
+    void set_risk_limits(const RiskLimits& limits) { risk_engine_.set_default_limits(limits); }
+    void set_account_risk_limits(uint32_t account_id, const RiskLimits& limits) {
+        risk_engine_.set_account_limits(account_id, limits);
+    }
+    const RiskEngine& get_risk_engine() const noexcept { return risk_engine_; }
+    
+    // Tick, lot and price band rules; orders that fail them are rejected
+    // before the risk stage (submit returns 0). Configure before trading.
+    bool set_symbol_rules(uint32_t symbol_id, const SymbolRules& rules) { return symbol_rules_.set(symbol_id, rules); }
+    const SymbolRules& get_symbol_rules(uint32_t symbol_id) const noexcept { return symbol_rules_.get(symbol_id); }
+    
+    // Limit-up/limit-down bands and halts, per book (see OrderBook);
+    // advance_time runs timer transitions for every book
+    void set_price_bands(uint32_t symbol_id, const PriceBandConfig& config) {
+        get_or_create_book(symbol_id)->set_price_bands(config);
+    }
+    PriceBands get_price_bands(uint32_t symbol_id) const;
+    void advance_time(uint64_t now_us);
+    
+    // Market order collar per symbol (see OrderBook::set_market_protection)
+    void set_market_protection(uint32_t symbol_id, const MarketProtection& protection) {
+        get_or_create_book(symbol_id)->set_market_protection(protection);
+    }
+    
+    // Streaming book features per symbol (see OrderBook::set_features)
+    void set_book_features(uint32_t symbol_id, const BookFeaturesConfig& config) {
+        get_or_create_book(symbol_id)->set_features(config);
+    }
+    BookFeatures get_book_features(uint32_t symbol_id) const;
+    
+    // OHLCV/VWAP bars for every symbol over the given intervals (in
+    // Trade::timestamp units); enable before trading starts. Prints queue
+    // from the matching path and are aggregated when the returned
+    // aggregator is polled.
+    BarAggregator& enable_bars(std::vector<uint64_t> intervals_us);
+    BarAggregator* get_bar_aggregator() noexcept { return bars_.get(); }
+    
+    // Time-and-sales ring per symbol, for existing and future books; enable
+    // before trading starts. Tapes are read lock-free from any thread.
+    void enable_trade_tapes(size_t capacity);
+    const TradeTape* get_trade_tape(uint32_t symbol_id) const;
+    
+    // Sequenced command journal across all books; set before trading starts.
+    // The sink runs under each book's lock on the submitting thread, so it
+    // must be thread-safe. Sequence numbers are global; each symbol's records
+    // arrive in sequence order.
+    void set_journal(std::function<void(const JournalRecord&)> sink);
+    uint64_t get_journal_sequence() const noexcept { return journal_sequence_.load(std::memory_order_relaxed); }
+    
+    // Snapshot of one book, consistent with its journal position
+    BookSnapshot snapshot_book(uint32_t symbol_id) const;
+    
+    // Apply a record from another engine's journal, bypassing validation
+    // and risk checks but mirroring the reservations they made. Order ids
+    // and journal sequence numbers issued afterwards continue past the
+    // record's. Returns whether the book applied it.
+    bool apply_journal_record(const JournalRecord& record);
+    
+    // Replace a book's state with a snapshot. Open notional, session
+    // live-order lists and order states move from the dropped orders to the
+    // restored ones. Ids continue past the snapshot's orders and
+    // last_order_id, sequence numbers past the snapshot's.
+    void restore_book(const BookSnapshot& snapshot, uint64_t last_order_id = 0);
+    
+    // Attach a listener to every current and future book; register before
+    // trading starts
+    void add_book_listener(OrderEventListener* listener);
+    
+    // Positions and P&L, marked to the lock-free top of book
+    PositionSnapshot get_position(uint32_t account_id, uint32_t symbol_id) const;
+    std::vector<PositionSnapshot> get_account_positions(uint32_t account_id) const;
+    
     // Performance metrics
     struct PerformanceMetrics {
         uint64_t orders_processed;
@@ -245,6 +1440,8 @@ public:
         double orders_per_second;
         uint64_t total_volume;
         uint64_t trade_count;
+        uint64_t risk_rejects;
+        uint64_t validation_rejects;
     };
     
     PerformanceMetrics get_performance_metrics() const;
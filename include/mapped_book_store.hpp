@@ -0,0 +1,96 @@
+#pragma once
+
+#include "limit_order_book.hpp"
+#include <string>
+
+namespace lob {
+
+// Resting-book image kept in a memory-mapped file, so a restarted process
+// can map it and serve again without replaying the journal.
+//
+// The file holds an order pool, a pool of price levels and a per-symbol
+// table, each with an open-addressed hash index, all fixed size. Orders
+// and levels refer to each other through 32-bit slot handles (index + 1,
+// 0 for none) rather than pointers, so the image is valid at any mapping
+// address. Each level keeps its orders as a doubly linked FIFO. The store
+// is fed as a book listener, so it follows every book it is attached to
+// under that book's lock.
+//
+// The header carries a running checksum over the resting orders. commit()
+// stamps it together with a journal sequence and marks the image clean;
+// the next update marks it dirty again. open() accepts only a clean image
+// whose chains re-add to the committed checksum. An image left dirty by a
+// crash is rejected, and the caller falls back to snapshot plus journal.
+// POSIX only; not built on Windows.
+class MappedBookStore : public OrderEventListener {
+public:
+    struct Capacity {
+        uint32_t orders = 1u << 20;
+        uint32_t levels = 1u << 16;
+        uint32_t symbols = 1u << 12;
+    };
+
+    ~MappedBookStore() override;
+    MappedBookStore(const MappedBookStore&) = delete;
+    MappedBookStore& operator=(const MappedBookStore&) = delete;
+
+    // Create an empty image, or map and validate an existing one; nullptr
+    // on I/O failure or an image that is dirty, corrupt or of another layout
+    static std::unique_ptr<MappedBookStore> create(const std::string& path, const Capacity& capacity);
+    static std::unique_ptr<MappedBookStore> open(const std::string& path);
+
+    // Mark the image consistent with the journal up to sequence; call while
+    // no book it follows is changing. False once a pool has overflowed.
+    bool commit(uint64_t journal_sequence);
+    uint64_t committed_sequence() const noexcept;
+
+    // Queries straight from the mapping
+    size_t order_count() const noexcept;
+    size_t level_count() const noexcept;
+    uint64_t checksum() const noexcept;
+    bool find_order(uint64_t order_id, Order& out) const;
+
+    // Rebuild every stored book into a simulator (existing book settings
+    // are kept); returns the number of orders restored
+    size_t restore_into(OrderBookSimulator& simulator) const;
+
+    // OrderEventListener
+    void on_accept(const Order& order) override;
+    void on_rest(const Order& order) override;
+    void on_fill(const Order& order, uint64_t quantity, uint64_t price) override;
+    void on_cancel(const Order& order, uint64_t quantity) override;
+    void on_replace(const Order& original, const Order& replacement) override;
+    void on_trade(const Trade& trade) override;
+    void on_restore_drop(const Order& order) override;
+
+private:
+    struct Header;
+    struct StoredOrder;
+    struct StoredLevel;
+    struct StoredSymbol;
+
+    int fd_;
+    void* base_;
+    size_t bytes_;
+    Header* header_;
+    StoredOrder* orders_;
+    StoredLevel* levels_;
+    StoredSymbol* symbols_;
+    uint32_t* order_index_;
+    uint32_t* level_index_;
+    uint32_t* symbol_index_;
+    mutable std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+
+    MappedBookStore(int fd, void* base, size_t bytes);
+
+    void mark_dirty() noexcept;
+    uint32_t find_order_slot(uint64_t order_id) const noexcept;
+    uint32_t find_level(uint32_t symbol_id, Side side, uint64_t price) const noexcept;
+    uint32_t find_symbol(uint32_t symbol_id) const noexcept;
+    uint32_t insert_level(uint32_t symbol_id, Side side, uint64_t price) noexcept;
+    uint32_t insert_symbol(uint32_t symbol_id) noexcept;
+    void remove_order(uint32_t handle) noexcept;
+    bool validate() const noexcept;
+};
+
+} // namespace lob
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "limit_order_book.hpp"
+#include <limits>
+
+namespace lob {
+
+// xoshiro256++ (Blackman & Vigna). Satisfies UniformRandomBitGenerator, so it
+// can stand in for std::mt19937_64 with the standard distributions, but it is
+// a quarter of the state and several times faster. Seeded through splitmix64
+// so that (seed, stream) pairs give independent per-thread sequences.
+class Xoshiro256pp {
+public:
+    using result_type = uint64_t;
+
+    explicit Xoshiro256pp(uint64_t seed = 0, uint64_t stream = 0) noexcept {
+        uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+        for (auto& word : state_) {
+            word = splitmix64(x);
+        }
+    }
+
+    static constexpr result_type min() noexcept { return 0; }
+    static constexpr result_type max() noexcept { return std::numeric_limits<uint64_t>::max(); }
+
+    result_type operator()() noexcept {
+        const uint64_t result = rotl(state_[0] + state_[3], 23) + state_[0];
+        const uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotl(state_[3], 45);
+        return result;
+    }
+
+    static uint64_t splitmix64(uint64_t& x) noexcept {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) noexcept { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t state_[4];
+};
+
+// Four independent xoshiro256++ lanes in structure-of-arrays layout. The
+// per-lane update has no cross-lane dependency, so fill() compiles to SIMD
+// under -march=native.
+class Xoshiro256ppX4 {
+public:
+    static constexpr size_t kLanes = 4;
+
+    explicit Xoshiro256ppX4(uint64_t seed = 0, uint64_t stream = 0) noexcept;
+
+    // Write count random words (count must be a multiple of kLanes)
+    void fill(uint64_t* out, size_t count) noexcept;
+
+private:
+    alignas(32) uint64_t s0_[kLanes];
+    alignas(32) uint64_t s1_[kLanes];
+    alignas(32) uint64_t s2_[kLanes];
+    alignas(32) uint64_t s3_[kLanes];
+};
+
+// Compact synthetic order command written into preallocated buffers
+struct OrderCommand {
+    uint64_t quantity;
+    uint64_t price;          // 0 for market orders
+    uint32_t symbol_id;
+    Side side;
+    OrderType order_type;
+};
+
+// Shape of the synthetic flow for one symbol
+struct OrderFlowParams {
+    uint32_t symbol_id = 0;
+    uint64_t base_price = 0;
+    uint64_t price_range = 0;
+    uint64_t min_quantity = 1;
+    uint64_t max_quantity = 1;
+    double volatility = 0.0;
+    double limit_ratio = 0.9;    // Share of limit orders, remainder are market orders
+    uint64_t tick_size = 1;      // Generated prices are multiples of tick_size
+    uint64_t lot_size = 1;       // Generated quantities are multiples of lot_size
+};
+
+// Batched order-flow generator: one per thread, no shared state.
+//
+// Each batch first draws raw random words for the whole batch, then decodes
+// side, order type and quantity with branch-free multiplicative range mapping (no
+// divisions, no distribution objects, no clock reads). Only the price random
+// walk is sequential, matching the original model in which each limit price
+// becomes the next reference price.
+class OrderFlowGenerator {
+public:
+    static constexpr size_t kBatchSize = 1024;
+
+    // batch_size bounds the per-generator buffers; keep it small when one
+    // thread drives many symbols
+    OrderFlowGenerator(const OrderFlowParams& params, uint64_t seed, uint64_t stream = 0,
+                       size_t batch_size = kBatchSize);
+
+    // Fill out[0..count) with generated commands
+    void generate(OrderCommand* out, size_t count) noexcept;
+
+    // Single command from an internal batch buffer
+    const OrderCommand& next() noexcept {
+        if (batch_index_ == batch_.size()) {
+            generate(batch_.data(), batch_.size());
+            batch_index_ = 0;
+        }
+        return batch_[batch_index_++];
+    }
+
+    const OrderFlowParams& params() const noexcept { return params_; }
+    uint64_t current_price() const noexcept { return current_price_; }
+
+private:
+    OrderFlowParams params_;
+    Xoshiro256ppX4 rng_;
+    uint64_t current_price_;
+    uint64_t min_price_;
+    uint64_t max_price_;
+    uint64_t limit_threshold_;        // Compared against 31 random bits
+    double quantity_scale_;           // Quantity span / 2^32
+    std::vector<uint64_t> random_words_;
+    std::vector<double> multipliers_;
+    std::vector<OrderCommand> batch_;
+    size_t batch_index_;
+    size_t batch_size_;
+};
+
+} // namespace lob
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "journal.hpp"
+#include <iosfwd>
+
+namespace lob {
+
+// Binary snapshot I/O; false on a short or malformed stream
+bool write_book_snapshot(std::ostream& out, const BookSnapshot& snapshot);
+bool read_book_snapshot(std::istream& in, BookSnapshot& snapshot);
+
+// Random-access replay of one symbol's journal from an archive.
+//
+// seek() restores the nearest snapshot at or before the target and applies
+// only the journal records after it, reading just the symbol's blocks from
+// the archive index. Seeking forward from the current position applies
+// only the gap. While stepping forward, a snapshot is kept every
+// checkpoint_interval records, so later seeks back are bounded as well.
+class ReplaySession {
+public:
+    // configure runs on every fresh book before a snapshot is restored
+    // into it, e.g. to attach features; snapshots carry their own settings
+    ReplaySession(JournalArchiveReader& archive, uint32_t symbol_id,
+                  std::function<void(OrderBook&)> configure = nullptr);
+
+    // Snapshots may be added in any order, e.g. loaded from files
+    void add_snapshot(BookSnapshot snapshot);
+    size_t snapshot_count() const noexcept { return snapshots_.size(); }
+
+    // Keep a snapshot every records applied; 0 disables
+    void set_checkpoint_interval(uint64_t records) noexcept { checkpoint_interval_ = records; }
+
+    // Move to the state after every record with sequence (or timestamp) at
+    // or before the target; false if the archive could not be read
+    bool seek(uint64_t sequence);
+    bool seek_to_time(uint64_t timestamp);
+
+    // Next record without applying it, and apply it; nullptr at the end of
+    // the journal. Pointers are valid until the next call.
+    const JournalRecord* peek();
+    const JournalRecord* step();
+
+    const OrderBook& book() const noexcept { return *book_; }
+    uint64_t position() const noexcept { return position_; }       // Sequence of the last record applied
+    uint64_t time() const noexcept { return time_; }                // Its timestamp
+    uint64_t records_applied() const noexcept { return records_applied_; }
+
+private:
+    JournalArchiveReader& archive_;
+    uint32_t symbol_id_;
+    std::function<void(OrderBook&)> configure_;
+    std::unique_ptr<OrderBook> book_;
+    std::vector<BookSnapshot> snapshots_;       // Ascending by sequence
+    uint64_t checkpoint_interval_ = 0;
+    uint64_t since_checkpoint_ = 0;
+
+    size_t block_ = 0;                          // Current archive block
+    bool block_loaded_ = false;
+    bool read_error_ = false;
+    std::vector<JournalRecord> records_;
+    size_t index_ = 0;                          // Next record in records_
+    uint64_t position_ = 0;
+    uint64_t time_ = 0;
+    uint64_t records_applied_ = 0;
+
+    void restart(const BookSnapshot* snapshot);
+    void apply(const JournalRecord& record);
+};
+
+} // namespace lob
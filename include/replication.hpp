@@ -0,0 +1,127 @@
+#pragma once
+
+#include "limit_order_book.hpp"
+#include <string>
+
+namespace lob {
+
+// Single-producer single-consumer ring of journal records in a shared
+// memory mapping (a file under /dev/shm, or any file), so a primary and a
+// standby in different processes on one host can share it. Like SpscRing,
+// head and tail sit on their own cache lines and each side caches the
+// other's index. The header also carries the primary's heartbeat, a drop
+// counter and an orderly-close flag. POSIX only; not built on Windows.
+class JournalRing {
+public:
+    struct Slot {
+        JournalRecord record;
+        uint64_t publish_ns;         // steady_clock time the primary published it
+    };
+
+    ~JournalRing();
+    JournalRing(const JournalRing&) = delete;
+    JournalRing& operator=(const JournalRing&) = delete;
+
+    // Primary creates (capacity rounded up to a power of two), standby
+    // attaches; nullptr if the file cannot be mapped or is not a ring
+    static std::unique_ptr<JournalRing> create(const std::string& path, size_t capacity);
+    static std::unique_ptr<JournalRing> attach(const std::string& path);
+
+    // Producer side; false if the ring is full
+    bool try_push(const JournalRecord& record, uint64_t now_ns) noexcept;
+    void heartbeat(uint64_t now_ns) noexcept;
+    void count_drop() noexcept;
+    void close_stream() noexcept;
+
+    // Consumer side; false if the ring is empty
+    bool try_pop(Slot& out) noexcept;
+
+    uint64_t heartbeat_ns() const noexcept;
+    uint64_t dropped() const noexcept;
+    bool closed() const noexcept;
+    size_t capacity() const noexcept { return mask_ + 1; }
+
+private:
+    struct Header;
+
+    int fd_;
+    void* base_;
+    size_t bytes_;
+    Header* header_;
+    Slot* slots_;
+    uint64_t mask_;
+    uint64_t cached_head_ = 0;       // Producer's view of the consumer
+    uint64_t cached_tail_ = 0;       // Consumer's view of the producer
+
+    JournalRing(int fd, void* base, size_t bytes);
+};
+
+// Primary side of replication: forwards the simulator's journal into a
+// ring. The journal sink runs on any submitting thread, so pushes are
+// serialized by a spinlock. A full ring drops the record rather than stall
+// matching; the drop counter then tells the standby it can no longer take over.
+class JournalPublisher {
+public:
+    explicit JournalPublisher(JournalRing& ring) : ring_(ring) {}
+
+    void publish(const JournalRecord& record);
+
+    // Call periodically while no commands flow
+    void heartbeat();
+
+    // Sink for OrderBookSimulator::set_journal
+    std::function<void(const JournalRecord&)> sink() {
+        return [this](const JournalRecord& record) { publish(record); };
+    }
+
+private:
+    JournalRing& ring_;
+    std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+};
+
+// Standby side: applies the primary's journal to a replica simulator as it
+// arrives. The ring preserves each symbol's command order, which is all a
+// book's state depends on, so the replica's books follow the primary's
+// exactly. Promotion drains the ring and leaves the replica ready to take
+// orders, with no snapshot reload or replay. Don't give the replica a
+// journal sink until it has been promoted.
+class HotStandby {
+public:
+    HotStandby(JournalRing& ring, OrderBookSimulator& replica);
+    ~HotStandby() { stop(); }
+
+    // Apply up to max_records waiting records on the calling thread
+    size_t poll(size_t max_records = SIZE_MAX);
+
+    // Busy-poll on a background thread. With a failover timeout, the thread
+    // promotes the replica itself once the primary's heartbeat is older than
+    // the timeout or the stream was closed, then calls on_promote.
+    void start(uint64_t failover_timeout_ns = 0, std::function<void()> on_promote = nullptr);
+    void stop();
+
+    bool primary_failed(uint64_t timeout_ns) const noexcept;
+
+    // Stop following and drain the ring; false if records were dropped, in
+    // which case the replica is not a faithful copy
+    bool promote();
+
+    bool promoted() const noexcept { return promoted_.load(std::memory_order_acquire); }
+    bool diverged() const noexcept { return ring_.dropped() > 0; }
+    uint64_t records_applied() const noexcept { return records_applied_.load(std::memory_order_relaxed); }
+    uint64_t last_lag_ns() const noexcept { return last_lag_ns_.load(std::memory_order_relaxed); }
+    uint64_t max_lag_ns() const noexcept { return max_lag_ns_.load(std::memory_order_relaxed); }
+
+private:
+    JournalRing& ring_;
+    OrderBookSimulator& replica_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> promoted_{false};
+    std::atomic<uint64_t> records_applied_{0};
+    std::atomic<uint64_t> last_lag_ns_{0};
+    std::atomic<uint64_t> max_lag_ns_{0};
+
+    void follow(uint64_t failover_timeout_ns, std::function<void()> on_promote);
+};
+
+} // namespace lob
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "consolidated_book.hpp"
+
+namespace lob {
+
+// One child order of a routed parent
+struct ChildOrder {
+    uint32_t venue = 0;
+    uint64_t quantity = 0;
+    uint64_t limit_price = 0;        // Worst level the plan takes at this venue
+    uint64_t order_id = 0;           // 0 until submitted, or if the venue rejected it
+    uint64_t filled_quantity = 0;
+};
+
+// Fixed-capacity routing decision; filling one never allocates
+struct RoutePlan {
+    ChildOrder children[ConsolidatedBook::kMaxVenues];
+    uint32_t child_count = 0;
+    uint64_t planned_quantity = 0;   // May fall short of the parent if depth runs out
+    uint64_t filled_quantity = 0;    // After route()
+    double expected_cost = 0.0;      // Notional at effective prices (fees and latency included)
+};
+
+// Smart order router over a ConsolidatedBook's venues.
+//
+// plan() is a read-only sweep over the lock-free per-venue depth copies: the
+// venues' levels are merged by effective price (price plus taker fee plus a
+// per-microsecond latency penalty for buys, minus for sells) and taken best
+// first until the parent is covered or the limit is reached, giving at most
+// one child per venue. route() then submits the children in parallel
+// batches, slowest venue first, and cancels any unfilled child remainder so
+// children behave as immediate-or-cancel.
+class SmartOrderRouter {
+public:
+    // num_threads workers submit children; 1 submits on the calling thread
+    SmartOrderRouter(const ConsolidatedBook& book, size_t num_threads = 1, double latency_cost_per_us = 0.0);
+    ~SmartOrderRouter();
+    
+    SmartOrderRouter(const SmartOrderRouter&) = delete;
+    SmartOrderRouter& operator=(const SmartOrderRouter&) = delete;
+    
+    // Taker fee in price units per unit quantity and one-way latency per venue
+    void set_venue_cost(uint32_t venue, double fee_per_unit, uint64_t latency_ns);
+    
+    // limit_price of 0 means no limit; false if nothing can be planned
+    bool plan(uint32_t symbol_id, Side side, uint64_t quantity, uint64_t limit_price, RoutePlan& out) const;
+    
+    // Plan, then submit; one route() at a time
+    bool route(uint32_t symbol_id, Side side, uint64_t quantity, uint64_t limit_price, RoutePlan& out,
+               uint32_t account_id = 0);
+    
+private:
+    struct VenueCost {
+        double fee_per_unit = 0.0;
+        uint64_t latency_ns = 0;
+    };
+    
+    const ConsolidatedBook& book_;
+    double latency_cost_per_us_;
+    VenueCost costs_[ConsolidatedBook::kMaxVenues];
+    
+    // Worker pool dispatch; the job is the plan being routed
+    std::vector<std::thread> workers_;
+    std::mutex dispatch_mutex_;
+    std::condition_variable dispatch_cv_;
+    std::condition_variable done_cv_;
+    uint64_t generation_ = 0;
+    size_t pending_ = 0;
+    bool shutdown_ = false;
+    RoutePlan* job_plan_ = nullptr;
+    uint32_t job_symbol_ = 0;
+    Side job_side_ = Side::BUY;
+    uint32_t job_account_ = 0;
+    
+    void worker_thread_function(size_t worker);
+    void submit_children(size_t worker);
+    
+    double effective_price(uint32_t venue, Side side, uint64_t price) const noexcept {
+        double adjustment = costs_[venue].fee_per_unit + latency_cost_per_us_ * (costs_[venue].latency_ns / 1000.0);
+        return side == Side::BUY ? price + adjustment : price - adjustment;
+    }
+};
+
+} // namespace lob
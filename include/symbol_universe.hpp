@@ -0,0 +1,37 @@
+#pragma once
+
+#include "limit_order_book.hpp"
+#include <iosfwd>
+#include <string>
+
+namespace lob {
+
+// Reference and flow parameters for one simulated instrument
+struct SymbolConfig {
+    uint32_t symbol_id;
+    uint64_t base_price;          // In ticks
+    uint64_t price_range;         // Generated prices stay within base_price +/- price_range
+    uint64_t min_quantity;
+    uint64_t max_quantity;
+    double volatility;
+    uint32_t orders_per_second;
+    uint64_t tick_size = 1;       // Prices are multiples of tick_size
+    uint64_t lot_size = 1;        // Quantities are multiples of lot_size
+};
+
+// Parse a symbol universe from CSV text, one symbol per line:
+//
+//   symbol_id,base_price,price_range,min_qty,max_qty,volatility,orders_per_second[,tick_size,lot_size]
+//
+// Blank lines and lines starting with '#' are ignored. On a malformed line
+// the error message names the line and false is returned.
+bool parse_symbol_universe(std::istream& input, std::vector<SymbolConfig>& symbols, std::string& error);
+
+// Load a symbol universe file; see parse_symbol_universe for the format
+bool load_symbol_universe(const std::string& path, std::vector<SymbolConfig>& symbols, std::string& error);
+
+// Partition symbol indices into num_groups groups of near-equal total order
+// rate (greedy longest-rate-first onto the least loaded group)
+std::vector<std::vector<size_t>> balance_symbol_groups(const std::vector<SymbolConfig>& symbols, size_t num_groups);
+
+} // namespace lob
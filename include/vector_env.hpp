@@ -0,0 +1,112 @@
+#pragma once
+
+#include "limit_order_book.hpp"
+
+namespace lob {
+
+// Action applied to a single environment in one step
+struct EnvAction {
+    enum class Kind : uint8_t {
+        NONE = 0,
+        SUBMIT = 1,
+        CANCEL = 2
+    };
+
+    Kind kind = Kind::NONE;
+    Side side = Side::BUY;
+    OrderType order_type = OrderType::LIMIT;
+    uint64_t quantity = 0;
+    uint64_t price = 0;
+    uint64_t order_id = 0;       // Target of a CANCEL
+};
+
+// Per-environment outcome of the last step
+struct EnvStepResult {
+    uint64_t order_id = 0;        // Id assigned to a submitted order, 0 otherwise
+    uint64_t filled_quantity = 0; // Quantity the submitted order filled on entry
+    bool accepted = false;
+};
+
+// N independent order books stepped in lockstep for RL-style training.
+//
+// Books live in one contiguous allocation and are sharded across a fixed
+// worker pool; each worker owns a contiguous range of environments, so no
+// book is touched by two threads within a step. Observations are written
+// into a preallocated row-major tensor of num_envs x observation_size()
+// floats laid out per environment as:
+//   [bid_px x depth][bid_qty x depth][ask_px x depth][ask_qty x depth]
+//   [trade_px x trade_history][trade_qty x trade_history]   (newest first)
+class VectorEnv {
+public:
+    struct Config {
+        size_t num_envs = 1;
+        uint32_t depth = 5;
+        uint32_t trade_history = 4;
+        size_t num_threads = std::thread::hardware_concurrency();
+        uint32_t symbol_id = 0;
+    };
+
+    explicit VectorEnv(const Config& config);
+    ~VectorEnv();
+
+    VectorEnv(const VectorEnv&) = delete;
+    VectorEnv& operator=(const VectorEnv&) = delete;
+
+    // Clear every book and observation in parallel
+    void reset();
+
+    // Clear a single environment (episodes may end at different times)
+    void reset_env(size_t env);
+
+    // Apply actions[0..num_envs) and refresh all observations
+    void step(const EnvAction* actions);
+    void step(const std::vector<EnvAction>& actions) { step(actions.data()); }
+
+    // Observation tensor access
+    const float* observations() const noexcept { return observations_.data(); }
+    const float* observation(size_t env) const noexcept { return observations_.data() + env * observation_size_; }
+    size_t observation_size() const noexcept { return observation_size_; }
+
+    const EnvStepResult* step_results() const noexcept { return step_results_.data(); }
+
+    OrderBook& book(size_t env) noexcept { return books_[env]; }
+    size_t num_envs() const noexcept { return config_.num_envs; }
+
+private:
+    struct TradePrint {
+        uint64_t price;
+        uint64_t quantity;
+    };
+
+    Config config_;
+    size_t observation_size_;
+
+    // Contiguous book storage (OrderBook is neither copyable nor movable)
+    std::allocator<OrderBook> book_allocator_;
+    OrderBook* books_;
+
+    std::vector<uint64_t> next_order_ids_;
+    std::vector<TradePrint> trade_history_;     // num_envs x trade_history ring slots
+    std::vector<uint64_t> trade_heads_;         // Total prints seen per env
+    std::vector<float> observations_;
+    std::vector<EnvStepResult> step_results_;
+    std::vector<std::pair<uint64_t, uint64_t>> level_scratch_;  // Per-worker depth buffers
+
+    // Worker pool dispatch
+    std::vector<std::thread> workers_;
+    std::function<void(size_t, size_t)> job_;
+    std::mutex dispatch_mutex_;
+    std::condition_variable dispatch_cv_;
+    std::condition_variable done_cv_;
+    uint64_t generation_ = 0;
+    size_t pending_ = 0;
+    bool shutdown_ = false;
+
+    void worker_thread_function(size_t worker);
+    void run_parallel(std::function<void(size_t, size_t)> job);
+    void clear_env(size_t env);
+    void apply_action(size_t env, const EnvAction& action);
+    void write_observation(size_t env, std::pair<uint64_t, uint64_t>* scratch);
+};
+
+} // namespace lob
@@ -0,0 +1,112 @@
+#include "../include/limit_order_book.hpp"
+
+namespace lob {
+
+BarAggregator::BarAggregator(std::vector<uint64_t> intervals_us, size_t ring_capacity)
+    : intervals_(std::move(intervals_us)), ring_capacity_(ring_capacity), scratch_(1024) {
+    // A zero interval would never close a bar
+    intervals_.erase(std::remove(intervals_.begin(), intervals_.end(), 0), intervals_.end());
+}
+
+void BarAggregator::attach(OrderBook& book) {
+    auto feed = std::make_unique<Feed>(book.get_symbol_id(), ring_capacity_);
+    feed->bars.resize(intervals_.size());
+    for (size_t i = 0; i < intervals_.size(); ++i) {
+        feed->bars[i].symbol_id = feed->symbol_id;
+        feed->bars[i].interval_us = intervals_[i];
+    }
+    book.add_listener(feed.get());
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    feeds_.push_back(std::move(feed));
+}
+
+void BarAggregator::subscribe(std::function<void(const Bar&)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    callbacks_.push_back(std::move(callback));
+}
+
+size_t BarAggregator::poll() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    size_t aggregated = 0;
+    for (auto& feed : feeds_) {
+        size_t count;
+        while ((count = feed->ring.pop_batch(scratch_.data(), scratch_.size())) > 0) {
+            for (size_t p = 0; p < count; ++p) {
+                const Print& print = scratch_[p];
+                for (size_t i = 0; i < intervals_.size(); ++i) {
+                    Bar& bar = feed->bars[i];
+                    uint64_t start = print.timestamp - print.timestamp % intervals_[i];
+                    
+                    // A print past the bar closes it; a late print folds into it
+                    if (bar.trade_count && start > bar.start_us) {
+                        emit(bar);
+                    }
+                    if (bar.trade_count == 0) {
+                        bar.start_us = start;
+                        bar.open = bar.high = bar.low = print.price;
+                    }
+                    bar.high = std::max(bar.high, print.price);
+                    bar.low = std::min(bar.low, print.price);
+                    bar.close = print.price;
+                    bar.volume += print.quantity;
+                    bar.trade_count++;
+                    bar.notional += static_cast<double>(print.price) * static_cast<double>(print.quantity);
+                }
+            }
+            aggregated += count;
+        }
+    }
+    return aggregated;
+}
+
+size_t BarAggregator::flush(uint64_t now_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    size_t emitted = 0;
+    for (auto& feed : feeds_) {
+        for (Bar& bar : feed->bars) {
+            if (bar.trade_count && now_us >= bar.start_us + bar.interval_us) {
+                emit(bar);
+                emitted++;
+            }
+        }
+    }
+    return emitted;
+}
+
+bool BarAggregator::current_bar(uint32_t symbol_id, size_t interval, Bar& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    for (const auto& feed : feeds_) {
+        if (feed->symbol_id == symbol_id && interval < feed->bars.size()) {
+            out = feed->bars[interval];
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t BarAggregator::get_dropped_prints() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    uint64_t dropped = 0;
+    for (const auto& feed : feeds_) {
+        dropped += feed->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+void BarAggregator::emit(Bar& bar) {
+    for (const auto& callback : callbacks_) {
+        callback(bar);
+    }
+    
+    Bar next;
+    next.symbol_id = bar.symbol_id;
+    next.interval_us = bar.interval_us;
+    bar = next;
+}
+
+} // namespace lob
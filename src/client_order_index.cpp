@@ -0,0 +1,55 @@
+#include "../include/limit_order_book.hpp"
+
+namespace lob {
+
+bool ClientOrderIndex::insert(const ClOrdId& id, uint64_t order_id, uint32_t symbol_id) {
+    // Keep load factor at or below one half
+    if ((size_ + 1) * 2 > slots_.size()) {
+        grow();
+    }
+    
+    uint64_t hash = id.hash();
+    size_t mask = slots_.size() - 1;
+    size_t i = hash & mask;
+    while (slots_[i].order_id != 0) {
+        if (slots_[i].hash == hash && slots_[i].id == id) {
+            return false;
+        }
+        i = (i + 1) & mask;
+    }
+    
+    slots_[i] = {id, hash, order_id, symbol_id};
+    size_++;
+    return true;
+}
+
+const ClientOrderIndex::Entry* ClientOrderIndex::find(const ClOrdId& id) const noexcept {
+    uint64_t hash = id.hash();
+    size_t mask = slots_.size() - 1;
+    size_t i = hash & mask;
+    while (slots_[i].order_id != 0) {
+        if (slots_[i].hash == hash && slots_[i].id == id) {
+            return &slots_[i];
+        }
+        i = (i + 1) & mask;
+    }
+    return nullptr;
+}
+
+void ClientOrderIndex::grow() {
+    std::vector<Entry> old_slots(slots_.size() * 2);
+    old_slots.swap(slots_);
+    
+    size_t mask = slots_.size() - 1;
+    for (const auto& entry : old_slots) {
+        if (entry.order_id != 0) {
+            size_t i = entry.hash & mask;
+            while (slots_[i].order_id != 0) {
+                i = (i + 1) & mask;
+            }
+            slots_[i] = entry;
+        }
+    }
+}
+
+} // namespace lob
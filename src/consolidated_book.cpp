@@ -0,0 +1,174 @@
+#include "../include/consolidated_book.hpp"
+
+namespace lob {
+
+ConsolidatedBook::ConsolidatedBook(uint32_t depth)
+    : depth_(std::min(depth, VenueDepth::kMaxDepth)) {}
+
+ConsolidatedBook::~ConsolidatedBook() {
+    for (const Subscription& subscription : subscriptions_) {
+        venues_[subscription.venue]->unregister_market_data_callback(subscription.symbol_id, subscription.token);
+    }
+}
+
+uint32_t ConsolidatedBook::add_venue(OrderBookSimulator& venue) {
+    if (venues_.size() >= kMaxVenues || !symbols_.empty()) {
+        return UINT32_MAX;
+    }
+    venues_.push_back(&venue);
+    return static_cast<uint32_t>(venues_.size() - 1);
+}
+
+void ConsolidatedBook::track_symbol(uint32_t symbol_id) {
+    if (venues_.empty() || symbols_.count(symbol_id)) {
+        return;
+    }
+    
+    auto state = std::make_unique<SymbolState>();
+    while (state->leaves < venues_.size()) {
+        state->leaves <<= 1;
+    }
+    state->tops.resize(state->leaves);
+    state->bid_tree.resize(2 * state->leaves);
+    state->ask_tree.resize(2 * state->leaves);
+    for (uint32_t leaf = 0; leaf < state->leaves; ++leaf) {
+        state->bid_tree[state->leaves + leaf] = leaf;
+        state->ask_tree[state->leaves + leaf] = leaf;
+    }
+    for (uint32_t node = state->leaves - 1; node > 0; --node) {
+        state->bid_tree[node] = state->bid_tree[2 * node];
+        state->ask_tree[node] = state->ask_tree[2 * node];
+    }
+    state->depth = std::make_unique<SeqLocked<VenueDepth>[]>(venues_.size());
+    
+    SymbolState* raw = state.get();
+    symbols_.emplace(symbol_id, std::move(state));
+    
+    for (uint32_t venue = 0; venue < venues_.size(); ++venue) {
+        uint64_t token = venues_[venue]->register_market_data_callback(
+            symbol_id, [this, symbol_id, raw, venue](const MarketDataSnapshot&) { refresh(symbol_id, *raw, venue); });
+        subscriptions_.push_back(Subscription{venue, symbol_id, token});
+        refresh(symbol_id, *raw, venue);
+    }
+}
+
+void ConsolidatedBook::subscribe(std::function<void(uint32_t, const Nbbo&)> callback) {
+    callbacks_.push_back(std::move(callback));
+}
+
+void ConsolidatedBook::refresh(uint32_t symbol_id, SymbolState& state, uint32_t venue) {
+    OrderBookSimulator& simulator = *venues_[venue];
+    SpinGuard guard(state.lock);
+    
+    // Read the venue's latest state under the lock, so concurrent updates
+    // from one venue can never leave an older view behind
+    state.tops[venue] = simulator.get_top_of_book(symbol_id);
+    if (depth_) {
+        std::pair<uint64_t, uint64_t> levels[VenueDepth::kMaxDepth];
+        VenueDepth depth;
+        depth.bid_count = simulator.copy_levels(symbol_id, Side::BUY, levels, depth_);
+        for (uint32_t i = 0; i < depth.bid_count; ++i) {
+            depth.bids[i] = {levels[i].first, levels[i].second};
+        }
+        depth.ask_count = simulator.copy_levels(symbol_id, Side::SELL, levels, depth_);
+        for (uint32_t i = 0; i < depth.ask_count; ++i) {
+            depth.asks[i] = {levels[i].first, levels[i].second};
+        }
+        state.depth[venue].store(depth);
+    }
+    
+    // Replay the tournament from this leaf to the root
+    for (uint32_t node = (state.leaves + venue) / 2; node > 0; node /= 2) {
+        uint32_t left = state.bid_tree[2 * node], right = state.bid_tree[2 * node + 1];
+        state.bid_tree[node] = better_bid(state.tops[right], state.tops[left]) ? right : left;
+        left = state.ask_tree[2 * node];
+        right = state.ask_tree[2 * node + 1];
+        state.ask_tree[node] = better_ask(state.tops[right], state.tops[left]) ? right : left;
+    }
+    
+    const TopOfBook& bid = state.tops[state.bid_tree[1]];
+    const TopOfBook& ask = state.tops[state.ask_tree[1]];
+    Nbbo nbbo;
+    nbbo.best_bid_price = bid.best_bid_price;
+    nbbo.best_bid_quantity = bid.best_bid_quantity;
+    nbbo.best_bid_venue = bid.best_bid_price ? state.bid_tree[1] : 0;
+    nbbo.best_ask_price = ask.best_ask_price;
+    nbbo.best_ask_quantity = ask.best_ask_quantity;
+    nbbo.best_ask_venue = ask.best_ask_price ? state.ask_tree[1] : 0;
+    
+    if (std::memcmp(&nbbo, &state.nbbo, sizeof(Nbbo)) == 0) {
+        return;
+    }
+    state.nbbo = nbbo;
+    state.published.store(nbbo);
+    state.updates.fetch_add(1, std::memory_order_relaxed);
+    
+    for (const auto& callback : callbacks_) {
+        callback(symbol_id, nbbo);
+    }
+}
+
+const ConsolidatedBook::SymbolState* ConsolidatedBook::find(uint32_t symbol_id) const {
+    auto it = symbols_.find(symbol_id);
+    return it != symbols_.end() ? it->second.get() : nullptr;
+}
+
+Nbbo ConsolidatedBook::get_nbbo(uint32_t symbol_id) const {
+    const SymbolState* state = find(symbol_id);
+    return state ? state->published.load() : Nbbo{};
+}
+
+bool ConsolidatedBook::get_venue_depth(uint32_t symbol_id, uint32_t venue, VenueDepth& out) const {
+    const SymbolState* state = find(symbol_id);
+    if (!state || venue >= venues_.size()) {
+        return false;
+    }
+    out = state->depth[venue].load();
+    return true;
+}
+
+size_t ConsolidatedBook::get_depth(uint32_t symbol_id, Side side, ConsolidatedLevel* out, size_t max_levels) const {
+    const SymbolState* state = find(symbol_id);
+    if (!state) {
+        return 0;
+    }
+    
+    VenueDepth depths[kMaxVenues];
+    uint32_t cursor[kMaxVenues] = {};
+    for (uint32_t venue = 0; venue < venues_.size(); ++venue) {
+        depths[venue] = state->depth[venue].load();
+    }
+    
+    // k-way merge; venue counts are small, so a linear scan per level
+    size_t count = 0;
+    while (count < max_levels) {
+        uint32_t best = UINT32_MAX;
+        uint64_t best_price = 0;
+        for (uint32_t venue = 0; venue < venues_.size(); ++venue) {
+            const VenueDepth& depth = depths[venue];
+            uint32_t levels = side == Side::BUY ? depth.bid_count : depth.ask_count;
+            if (cursor[venue] == levels) {
+                continue;
+            }
+            uint64_t price = (side == Side::BUY ? depth.bids : depth.asks)[cursor[venue]].price;
+            if (best == UINT32_MAX || (side == Side::BUY ? price > best_price : price < best_price)) {
+                best = venue;
+                best_price = price;
+            }
+        }
+        if (best == UINT32_MAX) {
+            break;
+        }
+        
+        const auto& level = (side == Side::BUY ? depths[best].bids : depths[best].asks)[cursor[best]++];
+        out[count++] = {level.price, level.quantity, best};
+    }
+    return count;
+}
+
+uint64_t ConsolidatedBook::get_nbbo_updates(uint32_t symbol_id) const {
+    const SymbolState* state = find(symbol_id);
+    return state ? state->updates.load(std::memory_order_relaxed) : 0;
+}
+
+} // namespace lob
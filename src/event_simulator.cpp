@@ -0,0 +1,85 @@
+#include "../include/event_simulator.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace lob {
+
+SimTime LatencyModel::sample(std::mt19937_64& rng) const {
+    switch (kind_) {
+        case Kind::UNIFORM:
+            return base_ns_ + (spread_ns_ ? rng() % (spread_ns_ + 1) : 0);
+        case Kind::EXPONENTIAL: {
+            // Inverse transform on a 53-bit uniform in (0, 1]
+            double u = static_cast<double>((rng() >> 11) + 1) * (1.0 / 9007199254740992.0);
+            return base_ns_ + static_cast<SimTime>(-std::log(u) * static_cast<double>(spread_ns_));
+        }
+        case Kind::CONSTANT:
+        default:
+            return base_ns_;
+    }
+}
+
+DiscreteEventSimulator::DiscreteEventSimulator(uint64_t seed) : rng_(seed) {}
+
+uint32_t DiscreteEventSimulator::add_agent(LatencyModel network, LatencyModel processing) {
+    agents_.push_back({network, processing});
+    return static_cast<uint32_t>(agents_.size() - 1);
+}
+
+void DiscreteEventSimulator::schedule_at(SimTime time, Action action) {
+    // Events can never be scheduled in the past
+    events_.push_back({std::max(time, now_), next_sequence_++, std::move(action)});
+    std::push_heap(events_.begin(), events_.end(), Later{});
+}
+
+void DiscreteEventSimulator::send_to_exchange(uint32_t agent, Action on_exchange, Action on_response) {
+    const Agent& a = agents_.at(agent);
+    SimTime arrival = a.network.sample(rng_) + a.processing.sample(rng_);
+
+    if (!on_response) {
+        schedule_after(arrival, std::move(on_exchange));
+        return;
+    }
+
+    schedule_after(arrival, [this, agent, on_exchange = std::move(on_exchange),
+                             on_response = std::move(on_response)]() mutable {
+        on_exchange();
+        schedule_after(agents_[agent].network.sample(rng_), std::move(on_response));
+    });
+}
+
+bool DiscreteEventSimulator::step() {
+    if (events_.empty()) {
+        return false;
+    }
+
+    std::pop_heap(events_.begin(), events_.end(), Later{});
+    Event event = std::move(events_.back());
+    events_.pop_back();
+
+    now_ = event.time;
+    event.action();
+    events_processed_++;
+
+    return true;
+}
+
+uint64_t DiscreteEventSimulator::run_until(SimTime end_time) {
+    uint64_t executed = 0;
+    while (!events_.empty() && events_.front().time <= end_time) {
+        step();
+        executed++;
+    }
+    now_ = std::max(now_, end_time);
+    return executed;
+}
+
+uint64_t DiscreteEventSimulator::run() {
+    uint64_t executed = 0;
+    while (step()) {
+        executed++;
+    }
+    return executed;
+}
+
+} // namespace lob
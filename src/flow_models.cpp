@@ -0,0 +1,259 @@
+#include "../include/flow_models.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace lob {
+
+namespace {
+
+// Exponential variate with the given rate (per second), in nanoseconds
+SimTime exponential_ns(Xoshiro256pp& rng, double rate_per_second) {
+    double u = static_cast<double>((rng() >> 11) + 1) * (1.0 / 9007199254740992.0);
+    return static_cast<SimTime>(-std::log(u) / rate_per_second * 1e9) + 1;
+}
+
+uint64_t uniform_quantity(Xoshiro256pp& rng, const OrderFlowParams& params) {
+    uint64_t quantity = params.min_quantity + rng() % (params.max_quantity - params.min_quantity + 1);
+    uint64_t lot = std::max<uint64_t>(1, params.lot_size);
+    return std::max(lot, quantity / lot * lot);
+}
+
+uint64_t clamp_price(const OrderFlowParams& params, uint64_t price) {
+    uint64_t tick = std::max<uint64_t>(1, params.tick_size);
+    uint64_t min_price = params.base_price > params.price_range ? params.base_price - params.price_range : tick;
+    uint64_t max_price = params.base_price + params.price_range;
+    price = std::max(std::max(min_price, tick), std::min(max_price, price));
+    return price / tick * tick;
+}
+
+// Reference price for a side whose queue is empty, inferred from the other side
+uint64_t resting_reference(const BookTop& book, Side side, uint64_t tick, uint64_t fallback) {
+    if (side == Side::BUY) {
+        if (book.best_bid_price) return book.best_bid_price;
+        return book.best_ask_price > tick ? book.best_ask_price - tick : fallback;
+    }
+    if (book.best_ask_price) return book.best_ask_price;
+    return book.best_bid_price ? book.best_bid_price + tick : fallback;
+}
+
+OrderCommand make_command(const OrderFlowParams& params, Side side, OrderType type,
+                          uint64_t quantity, uint64_t price) {
+    OrderCommand command;
+    command.quantity = quantity;
+    command.price = type == OrderType::LIMIT ? clamp_price(params, price) : 0;
+    command.symbol_id = params.symbol_id;
+    command.side = side;
+    command.order_type = type;
+    return command;
+}
+
+} // namespace
+
+PoissonFlowModel::PoissonFlowModel(const OrderFlowParams& params, double orders_per_second,
+                                   uint64_t seed, uint64_t stream)
+    : generator_(params, seed, stream),
+      rng_(seed ^ 0x5DEECE66DULL, stream),
+      mean_interarrival_ns_(1e9 / orders_per_second) {}
+
+FlowEvent PoissonFlowModel::next_event(SimTime now, const BookTop&) {
+    FlowEvent event;
+    event.time = now + exponential_ns(rng_, 1e9 / mean_interarrival_ns_);
+    event.command = generator_.next();
+    event.cancel = false;
+    return event;
+}
+
+FlowModelFactory PoissonFlowModel::factory() {
+    return [](const OrderFlowParams& params, double orders_per_second, uint64_t seed, uint64_t stream) {
+        return std::unique_ptr<FlowModel>(new PoissonFlowModel(params, orders_per_second, seed, stream));
+    };
+}
+
+HawkesFlowModel::HawkesFlowModel(const OrderFlowParams& params, const Parameters& hawkes,
+                                 uint64_t seed, uint64_t stream)
+    : params_(params), hawkes_(hawkes), rng_(seed, stream), last_time_(0),
+      reference_price_(params.base_price) {}
+
+HawkesFlowModel::Parameters HawkesFlowModel::symmetric(double orders_per_second, double branching_ratio,
+                                                       double decay_per_second, double market_share) {
+    Parameters parameters;
+    parameters.decay_per_second = decay_per_second;
+    
+    const std::array<double, kEventTypes> share = {
+        (1.0 - market_share) / 2, (1.0 - market_share) / 2, market_share / 2, market_share / 2};
+    
+    // Stationary rate = sum(mu) / (1 - n); every source excites each target in
+    // proportion to its share, so the branching matrix has spectral radius n
+    for (size_t target = 0; target < kEventTypes; ++target) {
+        parameters.baseline_per_second[target] = orders_per_second * (1.0 - branching_ratio) * share[target];
+        for (size_t source = 0; source < kEventTypes; ++source) {
+            parameters.excitation[target][source] = branching_ratio * decay_per_second * share[target];
+        }
+    }
+    
+    return parameters;
+}
+
+FlowModelFactory HawkesFlowModel::factory(double branching_ratio, double decay_per_second) {
+    return [branching_ratio, decay_per_second](const OrderFlowParams& params, double orders_per_second,
+                                               uint64_t seed, uint64_t stream) {
+        return std::unique_ptr<FlowModel>(new HawkesFlowModel(
+            params, symmetric(orders_per_second, branching_ratio, decay_per_second), seed, stream));
+    };
+}
+
+void HawkesFlowModel::decay(double dt_seconds) noexcept {
+    double factor = std::exp(-hawkes_.decay_per_second * dt_seconds);
+    for (auto& excitation : excitation_) {
+        excitation *= factor;
+    }
+}
+
+double HawkesFlowModel::intensity() const noexcept {
+    double total = 0.0;
+    for (size_t type = 0; type < kEventTypes; ++type) {
+        total += hawkes_.baseline_per_second[type] + excitation_[type];
+    }
+    return total;
+}
+
+FlowEvent HawkesFlowModel::next_event(SimTime now, const BookTop& book) {
+    if (now > last_time_) {
+        decay((now - last_time_) * 1e-9);
+        last_time_ = now;
+    }
+    
+    // Ogata thinning: the current intensity bounds the decaying intensity
+    SimTime time = last_time_;
+    double upper_bound = intensity();
+    double accepted_intensity;
+    while (true) {
+        SimTime wait = exponential_ns(rng_, upper_bound);
+        time += wait;
+        decay(wait * 1e-9);
+        accepted_intensity = intensity();
+        if (uniform() * upper_bound <= accepted_intensity) {
+            break;
+        }
+        upper_bound = accepted_intensity;
+    }
+    last_time_ = time;
+    
+    // Pick the event type in proportion to its intensity
+    double pick = uniform() * accepted_intensity;
+    size_t type = kEventTypes - 1;
+    for (size_t t = 0; t < kEventTypes; ++t) {
+        pick -= hawkes_.baseline_per_second[t] + excitation_[t];
+        if (pick <= 0.0) {
+            type = t;
+            break;
+        }
+    }
+    
+    // Excite every target type from this source
+    for (size_t target = 0; target < kEventTypes; ++target) {
+        excitation_[target] += hawkes_.excitation[target][type];
+    }
+    
+    if (book.best_bid_price && book.best_ask_price) {
+        reference_price_ = (book.best_bid_price + book.best_ask_price) / 2;
+    }
+    
+    FlowEvent event;
+    event.time = time;
+    event.cancel = false;
+    
+    Side side = (type == LIMIT_BUY || type == MARKET_BUY) ? Side::BUY : Side::SELL;
+    uint64_t quantity = uniform_quantity(rng_, params_);
+    if (type == MARKET_BUY || type == MARKET_SELL) {
+        event.command = make_command(params_, side, OrderType::MARKET, quantity, 0);
+    } else {
+        const uint64_t tick = std::max<uint64_t>(1, params_.tick_size);
+        uint64_t offset = rng_() % (hawkes_.max_price_offset + 1) * tick;
+        uint64_t best = resting_reference(book, side, tick,
+                                          side == Side::BUY ? reference_price_ - tick : reference_price_ + tick);
+        uint64_t price = side == Side::BUY ? (best > offset ? best - offset : 1) : best + offset;
+        event.command = make_command(params_, side, OrderType::LIMIT, quantity, price);
+    }
+    
+    return event;
+}
+
+QueueReactiveFlowModel::QueueReactiveFlowModel(const OrderFlowParams& params, const Parameters& queue,
+                                               uint64_t seed, uint64_t stream)
+    : params_(params), queue_(queue), rng_(seed, stream),
+      queue_unit_(std::max(1.0, (params.min_quantity + params.max_quantity) / 2.0)),
+      reference_price_(params.base_price) {}
+
+FlowModelFactory QueueReactiveFlowModel::factory() {
+    return factory(Parameters{});
+}
+
+FlowModelFactory QueueReactiveFlowModel::factory(const Parameters& queue) {
+    return [queue](const OrderFlowParams& params, double orders_per_second, uint64_t seed, uint64_t stream) {
+        // Scale the insert rate to the symbol's configured order rate
+        Parameters scaled = queue;
+        scaled.limit_rate_per_second = orders_per_second / 2;
+        return std::unique_ptr<FlowModel>(new QueueReactiveFlowModel(params, scaled, seed, stream));
+    };
+}
+
+FlowEvent QueueReactiveFlowModel::next_event(SimTime now, const BookTop& book) {
+    const double bid_units = book.best_bid_quantity / queue_unit_;
+    const double ask_units = book.best_ask_quantity / queue_unit_;
+    const double reference = queue_.reference_queue_units;
+    
+    // Intensities of: limit bid, limit ask, cancel bid, cancel ask, market buy, market sell
+    const double rates[6] = {
+        queue_.limit_rate_per_second * reference / (reference + bid_units),
+        queue_.limit_rate_per_second * reference / (reference + ask_units),
+        queue_.cancel_rate_per_second * bid_units,
+        queue_.cancel_rate_per_second * ask_units,
+        book.best_ask_quantity ? queue_.market_rate_per_second : 0.0,
+        book.best_bid_quantity ? queue_.market_rate_per_second : 0.0,
+    };
+    double total = 0.0;
+    for (double rate : rates) {
+        total += rate;
+    }
+    
+    double pick = uniform() * total;
+    size_t type = 5;
+    for (size_t t = 0; t < 6; ++t) {
+        pick -= rates[t];
+        if (pick <= 0.0) {
+            type = t;
+            break;
+        }
+    }
+    
+    if (book.best_bid_price && book.best_ask_price) {
+        reference_price_ = (book.best_bid_price + book.best_ask_price) / 2;
+    }
+    
+    FlowEvent event;
+    event.time = now + exponential_ns(rng_, total);
+    event.cancel = (type == 2 || type == 3);
+    
+    Side side = (type == 0 || type == 2 || type == 4) ? Side::BUY : Side::SELL;
+    uint64_t quantity = uniform_quantity(rng_, params_);
+    if (type >= 4) {
+        event.command = make_command(params_, side, OrderType::MARKET, quantity, 0);
+        return event;
+    }
+    
+    // Join the best queue, or improve it by a tick half the time when the spread allows
+    const uint64_t tick = std::max<uint64_t>(1, params_.tick_size);
+    uint64_t best = resting_reference(book, side, tick,
+                                      side == Side::BUY ? reference_price_ - tick : reference_price_ + tick);
+    uint64_t price = best;
+    if (!event.cancel && book.best_bid_price && book.best_ask_price &&
+        book.best_ask_price - book.best_bid_price > tick && (rng_() & 1)) {
+        price = side == Side::BUY ? best + tick : best - tick;
+    }
+    event.command = make_command(params_, side, OrderType::LIMIT, quantity, price);
+    
+    return event;
+}
+
+} // namespace lob
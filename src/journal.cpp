@@ -0,0 +1,404 @@
+#include "../include/journal.hpp"
+
+namespace lob {
+
+namespace {
+
+constexpr uint32_t kArchiveMagic = 0x4A424F4C;     // "LOBJ"
+constexpr uint32_t kArchiveVersion = 2;          // 2 added ClOrdIDs; 1 still reads
+
+// Tag byte: command (2 bits), side (1), order type (2), flags
+constexpr uint8_t kSameSymbol = 1u << 5;           // Symbol id omitted
+constexpr uint8_t kZeroPrice = 1u << 6;            // Price omitted, delta state kept
+constexpr uint8_t kClOrdId = 1u << 7;              // Length byte and ClOrdID bytes follow the terms
+
+struct BlockHeader {
+    uint32_t byte_count;
+    uint32_t record_count;
+};
+
+struct ArchiveFooter {
+    uint64_t index_offset;
+    uint64_t record_count;
+    uint32_t block_count;
+    uint32_t symbol_entry_count;
+    uint32_t magic;
+    uint32_t version;
+};
+
+inline uint64_t zigzag(uint64_t value, uint64_t base) noexcept {
+    int64_t delta = static_cast<int64_t>(value - base);
+    return (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+}
+
+inline uint64_t unzigzag(uint64_t encoded, uint64_t base) noexcept {
+    return base + ((encoded >> 1) ^ (0 - (encoded & 1)));
+}
+
+inline void put_varint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// Single-byte values, the common case for deltas, take the first branch
+inline bool get_varint(const uint8_t*& p, const uint8_t* end, uint64_t& value) noexcept {
+    if (p < end && *p < 0x80) {
+        value = *p++;
+        return true;
+    }
+
+    value = 0;
+    for (unsigned shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (byte < 0x80) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename T>
+bool write_raw(std::ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    return static_cast<bool>(file);
+}
+
+template <typename T>
+bool read_raw(std::ifstream& file, T* values, size_t count) {
+    file.read(reinterpret_cast<char*>(values), static_cast<std::streamsize>(sizeof(T) * count));
+    return static_cast<bool>(file);
+}
+
+} // namespace
+
+JournalArchiveWriter::JournalArchiveWriter(uint32_t block_records)
+    : block_records_(std::max<uint32_t>(1, block_records)) {}
+
+bool JournalArchiveWriter::open(const std::string& path) {
+    close();
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_) {
+        return false;
+    }
+
+    blocks_.clear();
+    symbol_entries_.clear();
+    records_ = 0;
+    offset_ = 0;
+    block_ = JournalBlockInfo{};
+
+    if (!write_raw(file_, kArchiveMagic) || !write_raw(file_, kArchiveVersion)) {
+        return false;
+    }
+    offset_ = 2 * sizeof(uint32_t);
+    return true;
+}
+
+bool JournalArchiveWriter::append(const JournalRecord& record) {
+    if (!file_.is_open()) {
+        return false;
+    }
+
+    if (block_.record_count == 0) {
+        buffer_.clear();
+        symbols_.clear();
+        last_state_ = nullptr;
+        last_sequence_ = 0;
+        block_.first_sequence = block_.last_sequence = record.sequence;
+        block_.first_timestamp = block_.last_timestamp = record.timestamp;
+    }
+
+    uint8_t tag = static_cast<uint8_t>(record.command) |
+                  static_cast<uint8_t>(static_cast<uint8_t>(record.side) << 2) |
+                  static_cast<uint8_t>(static_cast<uint8_t>(record.order_type) << 3);
+    bool has_order = record.command != JournalCommand::ADVANCE_TIME;
+    bool has_terms = record.command == JournalCommand::NEW_ORDER || record.command == JournalCommand::MODIFY;
+
+    if (last_state_ && record.symbol_id == last_symbol_) {
+        tag |= kSameSymbol;
+    } else {
+        auto [it, inserted] = symbols_.try_emplace(record.symbol_id);
+        if (inserted) {
+            symbol_entries_.push_back({record.symbol_id, static_cast<uint32_t>(blocks_.size()),
+                                       record.sequence, record.timestamp});
+        }
+        last_state_ = &it->second;
+        last_symbol_ = record.symbol_id;
+    }
+    if (has_terms && record.price == 0) {
+        tag |= kZeroPrice;
+    }
+    if (has_terms && record.cl_ord_id.length() > 0) {
+        tag |= kClOrdId;
+    }
+
+    SymbolState& state = *last_state_;
+    buffer_.push_back(tag);
+    if (!(tag & kSameSymbol)) {
+        put_varint(buffer_, record.symbol_id);
+    }
+    put_varint(buffer_, zigzag(record.sequence, last_sequence_));
+    put_varint(buffer_, zigzag(record.timestamp, state.timestamp));
+    if (has_order) {
+        put_varint(buffer_, zigzag(record.order_id, state.order_id));
+        state.order_id = record.order_id;
+    }
+    if (has_terms) {
+        put_varint(buffer_, record.quantity);
+        if (record.price != 0) {
+            put_varint(buffer_, zigzag(record.price, state.price));
+            state.price = record.price;
+        }
+        put_varint(buffer_, record.account_id);
+        put_varint(buffer_, record.session_id);
+        if (tag & kClOrdId) {
+            std::string_view id = record.cl_ord_id.view();
+            buffer_.push_back(static_cast<uint8_t>(id.size()));
+            buffer_.insert(buffer_.end(), id.begin(), id.end());
+        }
+    }
+    last_sequence_ = record.sequence;
+    state.timestamp = record.timestamp;
+
+    block_.first_sequence = std::min(block_.first_sequence, record.sequence);
+    block_.last_sequence = std::max(block_.last_sequence, record.sequence);
+    block_.first_timestamp = std::min(block_.first_timestamp, record.timestamp);
+    block_.last_timestamp = std::max(block_.last_timestamp, record.timestamp);
+    block_.record_count++;
+    records_++;
+
+    return block_.record_count < block_records_ || flush_block();
+}
+
+bool JournalArchiveWriter::flush_block() {
+    if (block_.record_count == 0) {
+        return true;
+    }
+
+    block_.offset = offset_;
+    block_.byte_count = static_cast<uint32_t>(buffer_.size());
+    BlockHeader header{block_.byte_count, block_.record_count};
+    write_raw(file_, header);
+    file_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+
+    offset_ += sizeof(header) + buffer_.size();
+    blocks_.push_back(block_);
+    block_ = JournalBlockInfo{};
+    return static_cast<bool>(file_);
+}
+
+bool JournalArchiveWriter::close() {
+    if (!file_.is_open()) {
+        return true;
+    }
+
+    bool ok = flush_block();
+
+    // Entries are appended in block order, so a stable sort by symbol
+    // leaves each symbol's blocks ascending
+    std::stable_sort(symbol_entries_.begin(), symbol_entries_.end(),
+                     [](const JournalSymbolEntry& a, const JournalSymbolEntry& b) {
+                         return a.symbol_id < b.symbol_id;
+                     });
+
+    ArchiveFooter footer{offset_, records_, static_cast<uint32_t>(blocks_.size()),
+                         static_cast<uint32_t>(symbol_entries_.size()), kArchiveMagic, kArchiveVersion};
+    file_.write(reinterpret_cast<const char*>(blocks_.data()),
+                static_cast<std::streamsize>(blocks_.size() * sizeof(JournalBlockInfo)));
+    file_.write(reinterpret_cast<const char*>(symbol_entries_.data()),
+                static_cast<std::streamsize>(symbol_entries_.size() * sizeof(JournalSymbolEntry)));
+    ok = write_raw(file_, footer) && ok;
+    offset_ += blocks_.size() * sizeof(JournalBlockInfo) + symbol_entries_.size() * sizeof(JournalSymbolEntry) +
+               sizeof(footer);
+
+    file_.close();
+    return ok && !file_.fail();
+}
+
+bool JournalArchiveReader::open(const std::string& path) {
+    file_.close();
+    file_.clear();
+    blocks_.clear();
+    symbol_entries_.clear();
+    record_count_ = 0;
+
+    file_.open(path, std::ios::binary);
+    uint32_t magic = 0;
+    if (!file_ || !read_raw(file_, &magic, 1) || magic != kArchiveMagic) {
+        return false;
+    }
+
+    ArchiveFooter footer;
+    file_.seekg(-static_cast<std::streamoff>(sizeof(footer)), std::ios::end);
+    if (!read_raw(file_, &footer, 1) || footer.magic != kArchiveMagic ||
+        footer.version == 0 || footer.version > kArchiveVersion) {
+        return false;
+    }
+
+    blocks_.resize(footer.block_count);
+    symbol_entries_.resize(footer.symbol_entry_count);
+    file_.seekg(static_cast<std::streamoff>(footer.index_offset));
+    if (!read_raw(file_, blocks_.data(), blocks_.size()) ||
+        !read_raw(file_, symbol_entries_.data(), symbol_entries_.size())) {
+        blocks_.clear();
+        symbol_entries_.clear();
+        return false;
+    }
+    record_count_ = footer.record_count;
+    return true;
+}
+
+size_t JournalArchiveReader::find_block(uint64_t sequence) const noexcept {
+    auto it = std::lower_bound(blocks_.begin(), blocks_.end(), sequence,
+                               [](const JournalBlockInfo& block, uint64_t value) {
+                                   return block.last_sequence < value;
+                               });
+    return static_cast<size_t>(it - blocks_.begin());
+}
+
+template <typename Key>
+size_t JournalArchiveReader::find_symbol_block(uint32_t symbol_id, uint64_t value, Key key) const noexcept {
+    auto by_symbol = [](const JournalSymbolEntry& entry, uint32_t symbol) { return entry.symbol_id < symbol; };
+    auto first = std::lower_bound(symbol_entries_.begin(), symbol_entries_.end(), symbol_id, by_symbol);
+    auto last = first;
+    while (last != symbol_entries_.end() && last->symbol_id == symbol_id) {
+        ++last;
+    }
+    if (first == last) {
+        return blocks_.size();
+    }
+
+    // Last entry whose first record is not after value
+    auto it = std::upper_bound(first, last, value,
+                               [&](uint64_t v, const JournalSymbolEntry& entry) { return v < key(entry); });
+    return (it == first ? first : it - 1)->block;
+}
+
+size_t JournalArchiveReader::find_block(uint32_t symbol_id, uint64_t sequence) const noexcept {
+    return find_symbol_block(symbol_id, sequence, [](const JournalSymbolEntry& e) { return e.first_sequence; });
+}
+
+size_t JournalArchiveReader::find_block_at_time(uint32_t symbol_id, uint64_t timestamp) const noexcept {
+    return find_symbol_block(symbol_id, timestamp, [](const JournalSymbolEntry& e) { return e.first_timestamp; });
+}
+
+size_t JournalArchiveReader::next_block(uint32_t symbol_id, size_t block) const noexcept {
+    auto it = std::upper_bound(symbol_entries_.begin(), symbol_entries_.end(), std::make_pair(symbol_id, block),
+                               [](const std::pair<uint32_t, size_t>& key, const JournalSymbolEntry& entry) {
+                                   return key.first != entry.symbol_id ? key.first < entry.symbol_id
+                                                                       : key.second < entry.block;
+                               });
+    return it != symbol_entries_.end() && it->symbol_id == symbol_id ? it->block : blocks_.size();
+}
+
+bool JournalArchiveReader::read_block(size_t index, std::vector<JournalRecord>& out) {
+    if (index >= blocks_.size()) {
+        return false;
+    }
+
+    const JournalBlockInfo& block = blocks_[index];
+    BlockHeader header;
+    file_.clear();
+    file_.seekg(static_cast<std::streamoff>(block.offset));
+    if (!read_raw(file_, &header, 1) || header.byte_count != block.byte_count ||
+        header.record_count != block.record_count) {
+        return false;
+    }
+
+    scratch_.resize(block.byte_count);
+    out.resize(block.record_count);
+    return read_raw(file_, scratch_.data(), scratch_.size()) &&
+           decode_block(scratch_.data(), scratch_.size(), block.record_count, out.data());
+}
+
+bool JournalArchiveReader::decode_block(const uint8_t* data, size_t size, uint32_t count, JournalRecord* out) {
+    struct SymbolState {
+        uint64_t timestamp = 0;
+        uint64_t order_id = 0;
+        uint64_t price = 0;
+    };
+    std::unordered_map<uint32_t, SymbolState> symbols;
+    SymbolState* state = nullptr;
+    uint32_t symbol_id = 0;
+    uint64_t sequence = 0;
+
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (p >= end) {
+            return false;
+        }
+        uint8_t tag = *p++;
+        uint64_t value;
+
+        if (!(tag & kSameSymbol)) {
+            if (!get_varint(p, end, value)) {
+                return false;
+            }
+            symbol_id = static_cast<uint32_t>(value);
+            state = &symbols[symbol_id];
+        } else if (!state) {
+            return false;
+        }
+
+        JournalRecord& record = out[i];
+        record.symbol_id = symbol_id;
+        record.command = static_cast<JournalCommand>(tag & 0x3);
+        record.side = static_cast<Side>((tag >> 2) & 0x1);
+        record.order_type = static_cast<OrderType>((tag >> 3) & 0x3);
+
+        if (!get_varint(p, end, value)) {
+            return false;
+        }
+        sequence = record.sequence = unzigzag(value, sequence);
+        if (!get_varint(p, end, value)) {
+            return false;
+        }
+        state->timestamp = record.timestamp = unzigzag(value, state->timestamp);
+
+        record.order_id = 0;
+        record.quantity = 0;
+        record.price = 0;
+        record.account_id = 0;
+        record.session_id = 0;
+        record.cl_ord_id = ClOrdId{};
+        if (record.command != JournalCommand::ADVANCE_TIME) {
+            if (!get_varint(p, end, value)) {
+                return false;
+            }
+            state->order_id = record.order_id = unzigzag(value, state->order_id);
+        }
+        if (record.command == JournalCommand::NEW_ORDER || record.command == JournalCommand::MODIFY) {
+            if (!get_varint(p, end, record.quantity)) {
+                return false;
+            }
+            if (!(tag & kZeroPrice)) {
+                if (!get_varint(p, end, value)) {
+                    return false;
+                }
+                state->price = record.price = unzigzag(value, state->price);
+            }
+            uint64_t account, session;
+            if (!get_varint(p, end, account) || !get_varint(p, end, session)) {
+                return false;
+            }
+            record.account_id = static_cast<uint32_t>(account);
+            record.session_id = static_cast<uint32_t>(session);
+            if (tag & kClOrdId) {
+                size_t length = p < end ? *p++ : 0;
+                if (static_cast<size_t>(end - p) < length ||
+                    !ClOrdId::from_string({reinterpret_cast<const char*>(p), length}, record.cl_ord_id)) {
+                    return false;
+                }
+                p += length;
+            }
+        }
+    }
+    return p == end;
+}
+
+} // namespace lob
@@ -0,0 +1,635 @@
+#include "../include/mapped_book_store.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lob {
+
+namespace {
+
+constexpr uint64_t kStoreMagic = 0x45524F54534B424CULL;     // "LBKSTORE"
+constexpr uint32_t kStoreVersion = 2;
+
+inline uint64_t mix(uint64_t x) noexcept {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+inline uint64_t rotl(uint64_t x, int k) noexcept { return (x << k) | (x >> (64 - k)); }
+
+inline size_t align64(size_t offset) noexcept { return (offset + 63) & ~size_t(63); }
+
+inline uint32_t buckets_for(uint32_t capacity) noexcept {
+    uint32_t buckets = 2;
+    while (buckets < 2 * static_cast<uint64_t>(capacity)) {
+        buckets <<= 1;
+    }
+    return buckets;
+}
+
+// Remove a handle from a linear-probing table by shifting later entries of
+// the same run back, so lookups never need tombstones
+template <typename Home>
+void erase_handle(uint32_t* table, uint32_t mask, uint32_t handle, Home home) noexcept {
+    uint32_t i = home(handle);
+    while (table[i] != handle) {
+        i = (i + 1) & mask;
+    }
+
+    uint32_t j = i;
+    while (true) {
+        j = (j + 1) & mask;
+        if (table[j] == 0) {
+            break;
+        }
+        uint32_t k = home(table[j]);
+        bool stays = i <= j ? (i < k && k <= j) : (i < k || k <= j);
+        if (!stays) {
+            table[i] = table[j];
+            i = j;
+        }
+    }
+    table[i] = 0;
+}
+
+} // namespace
+
+struct MappedBookStore::Header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t order_capacity;
+    uint32_t level_capacity;
+    uint32_t symbol_capacity;
+    uint32_t order_buckets;          // Index sizes, powers of two
+    uint32_t level_buckets;
+    uint32_t symbol_buckets;
+    uint32_t free_order;             // Free-list heads
+    uint32_t free_level;
+    uint32_t order_high;             // Slots handed out so far
+    uint32_t level_high;
+    uint32_t order_count;
+    uint32_t level_count;
+    uint32_t symbol_count;
+    uint32_t clean;                  // Set by commit(), cleared by the next update
+    uint32_t overflowed;
+    uint64_t last_order_id;          // Highest id accepted, resting or not
+    uint64_t checksum;               // Running sum over resting orders
+    uint64_t committed_sequence;
+    uint64_t committed_checksum;
+};
+
+struct MappedBookStore::StoredOrder {
+    uint64_t order_id;
+    uint64_t quantity;
+    uint64_t filled_quantity;
+    uint64_t price;
+    uint64_t timestamp;
+    ClOrdId cl_ord_id;
+    uint32_t symbol_id;
+    uint32_t account_id;
+    uint32_t session_id;
+    uint32_t level;                  // 0 while the slot is free
+    uint32_t prev;
+    uint32_t next;                   // Free-list link while the slot is free
+    Side side;
+    OrderType order_type;
+    OrderStatus status;
+
+    uint64_t term() const noexcept {
+        return mix(order_id ^ rotl(price, 21) ^ rotl(quantity - filled_quantity, 42) ^
+                   (static_cast<uint64_t>(symbol_id) << 1 | static_cast<uint64_t>(side)));
+    }
+};
+
+struct MappedBookStore::StoredLevel {
+    uint64_t price;
+    uint64_t total_quantity;
+    uint32_t symbol_id;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t count;                  // 0 while the slot is free
+    uint32_t next_free;
+    Side side;
+};
+
+struct MappedBookStore::StoredSymbol {
+    uint32_t symbol_id;
+    uint64_t clock_us;
+    uint64_t last_trade_price;
+    uint64_t last_trade_quantity;
+    uint64_t trade_count;
+    uint64_t total_volume;
+};
+
+namespace {
+
+struct Layout {
+    size_t orders;
+    size_t levels;
+    size_t symbols;
+    size_t order_index;
+    size_t level_index;
+    size_t symbol_index;
+    size_t bytes;
+};
+
+template <typename HeaderT, typename OrderT, typename LevelT, typename SymbolT>
+Layout layout_of(const HeaderT& header) noexcept {
+    Layout layout;
+    size_t offset = align64(sizeof(HeaderT));
+    layout.orders = offset;
+    offset = align64(offset + size_t(header.order_capacity) * sizeof(OrderT));
+    layout.levels = offset;
+    offset = align64(offset + size_t(header.level_capacity) * sizeof(LevelT));
+    layout.symbols = offset;
+    offset = align64(offset + size_t(header.symbol_capacity) * sizeof(SymbolT));
+    layout.order_index = offset;
+    offset = align64(offset + size_t(header.order_buckets) * sizeof(uint32_t));
+    layout.level_index = offset;
+    offset = align64(offset + size_t(header.level_buckets) * sizeof(uint32_t));
+    layout.symbol_index = offset;
+    layout.bytes = align64(offset + size_t(header.symbol_buckets) * sizeof(uint32_t));
+    return layout;
+}
+
+} // namespace
+
+MappedBookStore::MappedBookStore(int fd, void* base, size_t bytes)
+    : fd_(fd), base_(base), bytes_(bytes), header_(static_cast<Header*>(base)) {
+    Layout layout = layout_of<Header, StoredOrder, StoredLevel, StoredSymbol>(*header_);
+    char* bytes_base = static_cast<char*>(base);
+
+    // Handles are 1-based, so the arrays are addressed one slot early
+    orders_ = reinterpret_cast<StoredOrder*>(bytes_base + layout.orders) - 1;
+    levels_ = reinterpret_cast<StoredLevel*>(bytes_base + layout.levels) - 1;
+    symbols_ = reinterpret_cast<StoredSymbol*>(bytes_base + layout.symbols) - 1;
+    order_index_ = reinterpret_cast<uint32_t*>(bytes_base + layout.order_index);
+    level_index_ = reinterpret_cast<uint32_t*>(bytes_base + layout.level_index);
+    symbol_index_ = reinterpret_cast<uint32_t*>(bytes_base + layout.symbol_index);
+}
+
+MappedBookStore::~MappedBookStore() {
+    munmap(base_, bytes_);
+    close(fd_);
+}
+
+std::unique_ptr<MappedBookStore> MappedBookStore::create(const std::string& path, const Capacity& capacity) {
+    Header header{};
+    header.magic = kStoreMagic;
+    header.version = kStoreVersion;
+    header.order_capacity = std::max<uint32_t>(1, capacity.orders);
+    header.level_capacity = std::max<uint32_t>(1, capacity.levels);
+    header.symbol_capacity = std::max<uint32_t>(1, capacity.symbols);
+    header.order_buckets = buckets_for(header.order_capacity);
+    header.level_buckets = buckets_for(header.level_capacity);
+    header.symbol_buckets = buckets_for(header.symbol_capacity);
+    size_t bytes = layout_of<Header, StoredOrder, StoredLevel, StoredSymbol>(header).bytes;
+
+    // A fresh file reads as zeros: empty indexes, no slots in use
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        return nullptr;
+    }
+    void* base = ftruncate(fd, static_cast<off_t>(bytes)) == 0
+                     ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                     : MAP_FAILED;
+    if (base == MAP_FAILED) {
+        close(fd);
+        return nullptr;
+    }
+    std::memcpy(base, &header, sizeof(header));
+    return std::unique_ptr<MappedBookStore>(new MappedBookStore(fd, base, bytes));
+}
+
+std::unique_ptr<MappedBookStore> MappedBookStore::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDWR);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info;
+    void* base = fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(Header)
+                     ? mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                     : MAP_FAILED;
+    if (base == MAP_FAILED) {
+        close(fd);
+        return nullptr;
+    }
+
+    size_t bytes = static_cast<size_t>(info.st_size);
+    const Header& header = *static_cast<const Header*>(base);
+    bool layout_ok = header.magic == kStoreMagic && header.version == kStoreVersion &&
+                     header.order_buckets == buckets_for(header.order_capacity) &&
+                     header.level_buckets == buckets_for(header.level_capacity) &&
+                     header.symbol_buckets == buckets_for(header.symbol_capacity) &&
+                     layout_of<Header, StoredOrder, StoredLevel, StoredSymbol>(header).bytes == bytes;
+    if (!layout_ok) {
+        munmap(base, bytes);
+        close(fd);
+        return nullptr;
+    }
+
+    auto store = std::unique_ptr<MappedBookStore>(new MappedBookStore(fd, base, bytes));
+    if (!store->header_->clean || store->header_->overflowed || !store->validate()) {
+        return nullptr;
+    }
+    return store;
+}
+
+bool MappedBookStore::commit(uint64_t journal_sequence) {
+    SpinGuard guard(lock_);
+    if (header_->overflowed) {
+        return false;
+    }
+    header_->committed_sequence = journal_sequence;
+    header_->committed_checksum = header_->checksum;
+    header_->clean = 1;
+    msync(base_, bytes_, MS_ASYNC);
+    return true;
+}
+
+uint64_t MappedBookStore::committed_sequence() const noexcept {
+    return header_->committed_sequence;
+}
+
+size_t MappedBookStore::order_count() const noexcept {
+    return header_->order_count;
+}
+
+size_t MappedBookStore::level_count() const noexcept {
+    return header_->level_count;
+}
+
+uint64_t MappedBookStore::checksum() const noexcept {
+    return header_->checksum;
+}
+
+bool MappedBookStore::find_order(uint64_t order_id, Order& out) const {
+    SpinGuard guard(lock_);
+    uint32_t handle = find_order_slot(order_id);
+    if (!handle) {
+        return false;
+    }
+
+    const StoredOrder& stored = orders_[handle];
+    out = Order(stored.order_id, stored.symbol_id, stored.side, stored.order_type, stored.quantity,
+                stored.price, 0, stored.account_id);
+    out.filled_quantity = stored.filled_quantity;
+    out.timestamp = stored.timestamp;
+    out.session_id = stored.session_id;
+    out.cl_ord_id = stored.cl_ord_id;
+    out.status = stored.status;
+    return true;
+}
+
+void MappedBookStore::mark_dirty() noexcept {
+    if (header_->clean) {
+        header_->clean = 0;
+    }
+}
+
+uint32_t MappedBookStore::find_order_slot(uint64_t order_id) const noexcept {
+    uint32_t mask = header_->order_buckets - 1;
+    for (uint32_t i = mix(order_id) & mask; order_index_[i]; i = (i + 1) & mask) {
+        if (orders_[order_index_[i]].order_id == order_id) {
+            return order_index_[i];
+        }
+    }
+    return 0;
+}
+
+uint32_t MappedBookStore::find_level(uint32_t symbol_id, Side side, uint64_t price) const noexcept {
+    uint32_t mask = header_->level_buckets - 1;
+    uint64_t key = price ^ mix(static_cast<uint64_t>(symbol_id) << 1 | static_cast<uint64_t>(side));
+    for (uint32_t i = mix(key) & mask; level_index_[i]; i = (i + 1) & mask) {
+        const StoredLevel& level = levels_[level_index_[i]];
+        if (level.price == price && level.symbol_id == symbol_id && level.side == side) {
+            return level_index_[i];
+        }
+    }
+    return 0;
+}
+
+uint32_t MappedBookStore::find_symbol(uint32_t symbol_id) const noexcept {
+    uint32_t mask = header_->symbol_buckets - 1;
+    for (uint32_t i = mix(symbol_id) & mask; symbol_index_[i]; i = (i + 1) & mask) {
+        if (symbols_[symbol_index_[i]].symbol_id == symbol_id) {
+            return symbol_index_[i];
+        }
+    }
+    return 0;
+}
+
+uint32_t MappedBookStore::insert_level(uint32_t symbol_id, Side side, uint64_t price) noexcept {
+    uint32_t handle = header_->free_level;
+    if (handle) {
+        header_->free_level = levels_[handle].next_free;
+    } else if (header_->level_high < header_->level_capacity) {
+        handle = ++header_->level_high;
+    } else {
+        return 0;
+    }
+
+    levels_[handle] = StoredLevel{price, 0, symbol_id, 0, 0, 0, 0, side};
+    uint32_t mask = header_->level_buckets - 1;
+    uint64_t key = price ^ mix(static_cast<uint64_t>(symbol_id) << 1 | static_cast<uint64_t>(side));
+    uint32_t i = mix(key) & mask;
+    while (level_index_[i]) {
+        i = (i + 1) & mask;
+    }
+    level_index_[i] = handle;
+    header_->level_count++;
+    return handle;
+}
+
+uint32_t MappedBookStore::insert_symbol(uint32_t symbol_id) noexcept {
+    if (header_->symbol_count == header_->symbol_capacity) {
+        return 0;
+    }
+
+    uint32_t handle = ++header_->symbol_count;
+    symbols_[handle] = StoredSymbol{symbol_id, 0, 0, 0, 0, 0};
+    uint32_t mask = header_->symbol_buckets - 1;
+    uint32_t i = mix(symbol_id) & mask;
+    while (symbol_index_[i]) {
+        i = (i + 1) & mask;
+    }
+    symbol_index_[i] = handle;
+    return handle;
+}
+
+void MappedBookStore::on_accept(const Order& order) {
+    SpinGuard guard(lock_);
+    if (order.order_id > header_->last_order_id) {
+        mark_dirty();
+        header_->last_order_id = order.order_id;
+    }
+}
+
+void MappedBookStore::on_rest(const Order& order) {
+    SpinGuard guard(lock_);
+
+    // A book restored from this store rests orders it already holds
+    if (find_order_slot(order.order_id)) {
+        return;
+    }
+    mark_dirty();
+
+    uint32_t symbol = find_symbol(order.symbol_id);
+    if (!symbol) {
+        symbol = insert_symbol(order.symbol_id);
+    }
+    uint32_t level = find_level(order.symbol_id, order.side, order.price);
+    if (!level && symbol) {
+        level = insert_level(order.symbol_id, order.side, order.price);
+    }
+
+    uint32_t handle = header_->free_order;
+    if (handle) {
+        header_->free_order = orders_[handle].next;
+    } else if (header_->order_high < header_->order_capacity) {
+        handle = ++header_->order_high;
+    }
+    if (!handle || !level) {
+        // The image no longer mirrors the books; commit() refuses from here on
+        if (handle) {
+            orders_[handle].next = header_->free_order;
+            header_->free_order = handle;
+        }
+        if (level && levels_[level].count == 0) {
+            erase_handle(level_index_, header_->level_buckets - 1, level, [this](uint32_t h) {
+                const StoredLevel& l = levels_[h];
+                uint64_t key = l.price ^ mix(static_cast<uint64_t>(l.symbol_id) << 1 | static_cast<uint64_t>(l.side));
+                return static_cast<uint32_t>(mix(key) & (header_->level_buckets - 1));
+            });
+            levels_[level].next_free = header_->free_level;
+            header_->free_level = level;
+            header_->level_count--;
+        }
+        header_->overflowed = 1;
+        return;
+    }
+
+    StoredLevel& stored_level = levels_[level];
+    StoredOrder& stored = orders_[handle];
+    stored = StoredOrder{order.order_id, order.quantity, order.filled_quantity, order.price, order.timestamp,
+                         order.cl_ord_id, order.symbol_id, order.account_id, order.session_id, level,
+                         stored_level.tail, 0, order.side, order.order_type, order.status};
+
+    // Append to the level's FIFO
+    if (stored_level.tail) {
+        orders_[stored_level.tail].next = handle;
+    } else {
+        stored_level.head = handle;
+    }
+    stored_level.tail = handle;
+    stored_level.count++;
+    stored_level.total_quantity += order.remaining_quantity();
+
+    uint32_t mask = header_->order_buckets - 1;
+    uint32_t i = mix(order.order_id) & mask;
+    while (order_index_[i]) {
+        i = (i + 1) & mask;
+    }
+    order_index_[i] = handle;
+    header_->order_count++;
+    header_->checksum += stored.term();
+    symbols_[symbol].clock_us = std::max(symbols_[symbol].clock_us, order.timestamp);
+}
+
+void MappedBookStore::on_fill(const Order& order, uint64_t quantity, uint64_t) {
+    SpinGuard guard(lock_);
+    uint32_t handle = find_order_slot(order.order_id);
+    if (!handle) {
+        return;
+    }
+    mark_dirty();
+
+    StoredOrder& stored = orders_[handle];
+    header_->checksum -= stored.term();
+    stored.filled_quantity = order.filled_quantity;
+    stored.status = order.status;
+    levels_[stored.level].total_quantity -= quantity;
+    header_->checksum += stored.term();
+
+    if (stored.filled_quantity >= stored.quantity) {
+        remove_order(handle);
+    }
+}
+
+void MappedBookStore::on_cancel(const Order& order, uint64_t) {
+    SpinGuard guard(lock_);
+    uint32_t handle = find_order_slot(order.order_id);
+    if (handle) {
+        mark_dirty();
+        remove_order(handle);
+    }
+}
+
+void MappedBookStore::on_replace(const Order& original, const Order&) {
+    // The replacement shows up through on_rest if it rests
+    on_cancel(original, original.remaining_quantity());
+}
+
+void MappedBookStore::on_restore_drop(const Order& order) {
+    // Snapshot orders come back through on_rest
+    on_cancel(order, order.remaining_quantity());
+}
+
+void MappedBookStore::on_trade(const Trade& trade) {
+    SpinGuard guard(lock_);
+    uint32_t symbol = find_symbol(trade.symbol_id);
+    if (!symbol) {
+        symbol = insert_symbol(trade.symbol_id);
+        if (!symbol) {
+            header_->overflowed = 1;
+            return;
+        }
+    }
+    mark_dirty();
+
+    StoredSymbol& stored = symbols_[symbol];
+    stored.last_trade_price = trade.price;
+    stored.last_trade_quantity = trade.quantity;
+    stored.trade_count++;
+    stored.total_volume += trade.quantity;
+}
+
+void MappedBookStore::remove_order(uint32_t handle) noexcept {
+    StoredOrder& stored = orders_[handle];
+    StoredLevel& level = levels_[stored.level];
+    uint32_t level_handle = stored.level;
+
+    header_->checksum -= stored.term();
+    level.total_quantity -= stored.quantity - stored.filled_quantity;
+    if (stored.prev) {
+        orders_[stored.prev].next = stored.next;
+    } else {
+        level.head = stored.next;
+    }
+    if (stored.next) {
+        orders_[stored.next].prev = stored.prev;
+    } else {
+        level.tail = stored.prev;
+    }
+
+    if (--level.count == 0) {
+        uint32_t mask = header_->level_buckets - 1;
+        erase_handle(level_index_, mask, level_handle, [this, mask](uint32_t h) {
+            const StoredLevel& l = levels_[h];
+            uint64_t key = l.price ^ mix(static_cast<uint64_t>(l.symbol_id) << 1 | static_cast<uint64_t>(l.side));
+            return static_cast<uint32_t>(mix(key) & mask);
+        });
+        level.next_free = header_->free_level;
+        header_->free_level = level_handle;
+        header_->level_count--;
+    }
+
+    uint32_t mask = header_->order_buckets - 1;
+    erase_handle(order_index_, mask, handle, [this, mask](uint32_t h) {
+        return static_cast<uint32_t>(mix(orders_[h].order_id) & mask);
+    });
+    stored.level = 0;
+    stored.next = header_->free_order;
+    header_->free_order = handle;
+    header_->order_count--;
+}
+
+bool MappedBookStore::validate() const noexcept {
+    // Walk every live level's chain: links, counts and quantities must
+    // agree, and the orders must re-add to the committed checksum
+    uint64_t checksum = 0;
+    uint64_t orders = 0;
+    uint64_t levels = 0;
+    for (uint32_t handle = 1; handle <= header_->level_high; ++handle) {
+        const StoredLevel& level = levels_[handle];
+        if (level.count == 0) {
+            continue;
+        }
+        if (find_level(level.symbol_id, level.side, level.price) != handle) {
+            return false;
+        }
+
+        uint64_t count = 0;
+        uint64_t quantity = 0;
+        uint32_t prev = 0;
+        for (uint32_t order = level.head; order; order = orders_[order].next) {
+            const StoredOrder& stored = orders_[order];
+            if (order > header_->order_high || stored.level != handle || stored.prev != prev ||
+                ++count > level.count || find_order_slot(stored.order_id) != order) {
+                return false;
+            }
+            quantity += stored.quantity - stored.filled_quantity;
+            checksum += stored.term();
+            prev = order;
+        }
+        if (count != level.count || prev != level.tail || quantity != level.total_quantity) {
+            return false;
+        }
+        orders += count;
+        levels++;
+    }
+    return orders == header_->order_count && levels == header_->level_count &&
+           checksum == header_->checksum && checksum == header_->committed_checksum;
+}
+
+size_t MappedBookStore::restore_into(OrderBookSimulator& simulator) const {
+    std::unordered_map<uint32_t, std::vector<uint32_t>> levels_by_symbol;
+    {
+        SpinGuard guard(lock_);
+        for (uint32_t handle = 1; handle <= header_->level_high; ++handle) {
+            if (levels_[handle].count) {
+                levels_by_symbol[levels_[handle].symbol_id].push_back(handle);
+            }
+        }
+    }
+
+    size_t restored = 0;
+    for (uint32_t symbol = 1; symbol <= header_->symbol_count; ++symbol) {
+        const StoredSymbol& stored_symbol = symbols_[symbol];
+
+        // Start from the book's current settings, replacing its state
+        BookSnapshot snapshot = simulator.snapshot_book(stored_symbol.symbol_id);
+        snapshot.sequence = header_->committed_sequence;
+        snapshot.clock_us = stored_symbol.clock_us;
+        snapshot.last_trade_price = stored_symbol.last_trade_price;
+        snapshot.last_trade_quantity = stored_symbol.last_trade_quantity;
+        snapshot.trade_count = stored_symbol.trade_count;
+        snapshot.total_volume = stored_symbol.total_volume;
+        snapshot.next_trade_id = stored_symbol.trade_count + 1;
+        snapshot.orders.clear();
+
+        // Bids best first, then asks best first
+        std::vector<uint32_t>& levels = levels_by_symbol[stored_symbol.symbol_id];
+        std::sort(levels.begin(), levels.end(), [this](uint32_t a, uint32_t b) {
+            const StoredLevel& x = levels_[a];
+            const StoredLevel& y = levels_[b];
+            if (x.side != y.side) {
+                return x.side == Side::BUY;
+            }
+            return x.side == Side::BUY ? x.price > y.price : x.price < y.price;
+        });
+        for (uint32_t level : levels) {
+            for (uint32_t handle = levels_[level].head; handle; handle = orders_[handle].next) {
+                const StoredOrder& stored = orders_[handle];
+                Order order(stored.order_id, stored.symbol_id, stored.side, stored.order_type, stored.quantity,
+                            stored.price, 0, stored.account_id);
+                order.filled_quantity = stored.filled_quantity;
+                order.timestamp = stored.timestamp;
+                order.session_id = stored.session_id;
+                order.cl_ord_id = stored.cl_ord_id;
+                order.status = stored.status;
+                snapshot.orders.push_back(order);
+            }
+        }
+
+        restored += snapshot.orders.size();
+        simulator.restore_book(snapshot, header_->last_order_id);
+    }
+    return restored;
+}
+
+} // namespace lob
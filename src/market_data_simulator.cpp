@@ -1,10 +1,16 @@
 #include "../include/limit_order_book.hpp"
+#include "../include/event_simulator.hpp"
+#include "../include/order_flow.hpp"
+#include "../include/flow_models.hpp"
+#include "../include/symbol_universe.hpp"
 #include <iostream>
 #include <random>
 #include <thread>
 #include <chrono>
 #include <vector>
 #include <iomanip>
+#include <array>
+#include <string>
 
 namespace lob {
 
@@ -15,18 +21,13 @@ private:
     std::vector<std::thread> worker_threads_;
     
     // Market data generation parameters
-    struct SymbolConfig {
-        uint32_t symbol_id;
-        uint64_t base_price;
-        uint64_t price_range;
-        uint64_t min_quantity;
-        uint64_t max_quantity;
-        double volatility;
-        uint32_t orders_per_second;
-    };
-    
     std::vector<SymbolConfig> symbol_configs_;
-    std::mt19937_64 rng_;
+    
+    // Each generator thread derives its own stream from this seed
+    uint64_t seed_;
+    
+    // Order-flow model used in discrete-event mode
+    FlowModelFactory flow_model_factory_ = PoissonFlowModel::factory();
     
     // Statistics tracking
     std::atomic<uint64_t> total_orders_generated_{0};
@@ -34,11 +35,13 @@ private:
     std::atomic<uint64_t> total_volume_{0};
     
 public:
-    explicit MarketDataSimulator(OrderBookSimulator& simulator) 
-        : simulator_(simulator), rng_(std::chrono::high_resolution_clock::now().time_since_epoch().count()) {
+    explicit MarketDataSimulator(OrderBookSimulator& simulator, 
+                                 uint64_t seed = std::chrono::high_resolution_clock::now().time_since_epoch().count()) 
+        : simulator_(simulator), seed_(seed) {
         
         // Configure symbols
         setup_symbols();
+        register_symbol_rules();
     }
     
     ~MarketDataSimulator() {
@@ -55,6 +58,19 @@ public:
         };
     }
     
+    // Replace the symbol universe with the contents of a config file
+    bool load_symbols(const std::string& path) {
+        std::string error;
+        if (!load_symbol_universe(path, symbol_configs_, error)) {
+            std::cerr << "Failed to load symbol universe: " << error << "\n";
+            return false;
+        }
+        register_symbol_rules();
+        return true;
+    }
+    
+    size_t symbol_count() const noexcept { return symbol_configs_.size(); }
+    
     void start_simulation(size_t num_threads = 2) {
         if (running_.load()) {
             return;
@@ -62,16 +78,100 @@ public:
         
         running_.store(true);
         
-        // Start worker threads for each symbol
-        for (const auto& config : symbol_configs_) {
-            worker_threads_.emplace_back(&MarketDataSimulator::simulate_symbol, this, config);
+        // Fixed number of generator threads, each driving a group of symbols
+        // with near-equal total order rate
+        auto groups = balance_symbol_groups(symbol_configs_, num_threads);
+        for (auto& group : groups) {
+            worker_threads_.emplace_back(&MarketDataSimulator::simulate_group, this, std::move(group));
         }
         
         // Start statistics reporting thread
         worker_threads_.emplace_back(&MarketDataSimulator::report_statistics, this);
         
         std::cout << "Market data simulation started with " << symbol_configs_.size() 
-                  << " symbols and " << num_threads << " threads per symbol\n";
+                  << " symbols on " << groups.size() << " generator threads\n";
+    }
+    
+    // Select the order-flow model used by run_discrete_event (Poisson by default)
+    void set_flow_model(FlowModelFactory factory) {
+        flow_model_factory_ = std::move(factory);
+    }
+    
+    // Run every symbol in simulated time on the calling thread, as fast as the
+    // CPU allows. Each symbol is an agent whose flow model decides when and
+    // what it sends, conditioned on the book top it last saw; orders reach the
+    // book after the given latencies. Deterministic for a given seed. Returns
+    // the number of orders submitted.
+    uint64_t run_discrete_event(SimTime duration_ns, uint64_t seed,
+                                LatencyModel network = LatencyModel::constant(50000),
+                                LatencyModel processing = LatencyModel::constant(1000)) {
+        DiscreteEventSimulator des(seed);
+        uint64_t orders_submitted = 0;
+        
+        // Own resting limit orders per symbol and side, newest last, for cancel events
+        constexpr size_t max_tracked_orders = 4096;
+        std::vector<std::unique_ptr<FlowModel>> models;
+        std::vector<std::array<std::vector<uint64_t>, 2>> resting_orders(symbol_configs_.size());
+        for (size_t index = 0; index < symbol_configs_.size(); ++index) {
+            const SymbolConfig& config = symbol_configs_[index];
+            models.push_back(flow_model_factory_(flow_params(config), config.orders_per_second, seed, index));
+        }
+        
+        auto apply_event = [&](size_t index, const FlowEvent& event) {
+            const OrderCommand& order = event.command;
+            auto& resting = resting_orders[index][static_cast<size_t>(order.side)];
+            
+            if (event.cancel) {
+                // Most recent own order on that side that is still live
+                while (!resting.empty()) {
+                    uint64_t order_id = resting.back();
+                    resting.pop_back();
+                    if (simulator_.cancel_order(order_id)) {
+                        break;
+                    }
+                }
+                return;
+            }
+            
+            uint64_t order_id = simulator_.submit_order(order.symbol_id, order.side, order.order_type, 
+                                                        order.quantity, order.price);
+            orders_submitted++;
+            
+            if (order.order_type == OrderType::LIMIT) {
+                if (resting.size() == max_tracked_orders) {
+                    resting.erase(resting.begin(), resting.begin() + max_tracked_orders / 2);
+                }
+                resting.push_back(order_id);
+            }
+        };
+        
+        // Self-rescheduling event process per symbol
+        std::function<void(size_t)> schedule_next = [&](size_t index) {
+            auto snapshot = simulator_.get_market_data(symbol_configs_[index].symbol_id);
+            BookTop top;
+            top.best_bid_price = snapshot.best_bid_price;
+            top.best_bid_quantity = snapshot.best_bid_quantity;
+            top.best_ask_price = snapshot.best_ask_price;
+            top.best_ask_quantity = snapshot.best_ask_quantity;
+            
+            FlowEvent event = models[index]->next_event(des.now(), top);
+            des.schedule_at(event.time, [&, index, event]() {
+                des.send_to_exchange(static_cast<uint32_t>(index), [&, index, event]() {
+                    apply_event(index, event);
+                });
+                schedule_next(index);
+            });
+        };
+        
+        for (size_t index = 0; index < symbol_configs_.size(); ++index) {
+            des.add_agent(network, processing);
+            schedule_next(index);
+        }
+        
+        des.run_until(duration_ns);
+        total_orders_generated_.fetch_add(orders_submitted);
+        
+        return orders_submitted;
     }
     
     void stop_simulation() {
@@ -93,65 +193,70 @@ public:
     }
     
 private:
-    void simulate_symbol(const SymbolConfig& config) {
-        std::uniform_real_distribution<double> price_change_dist(-config.volatility, config.volatility);
-        std::uniform_int_distribution<uint64_t> quantity_dist(config.min_quantity, config.max_quantity);
-        std::uniform_int_distribution<int> side_dist(0, 1);
-        std::uniform_real_distribution<double> order_type_dist(0.0, 1.0);
+    // Engine-side tick, lot and static band rules matching the generator's
+    // price window, so generated flow is validated rather than trusted
+    void register_symbol_rules() {
+        for (const auto& config : symbol_configs_) {
+            SymbolRules rules;
+            rules.add_tick_band(0, config.tick_size);
+            rules.lot_size = config.lot_size;
+            rules.min_price = std::max(config.tick_size,
+                                       config.base_price > config.price_range ? config.base_price - config.price_range : 0);
+            rules.max_price = config.base_price + config.price_range;
+            simulator_.set_symbol_rules(config.symbol_id, rules);
+        }
+    }
+    
+    static OrderFlowParams flow_params(const SymbolConfig& config) {
+        OrderFlowParams params;
+        params.symbol_id = config.symbol_id;
+        params.base_price = config.base_price;
+        params.price_range = config.price_range;
+        params.min_quantity = config.min_quantity;
+        params.max_quantity = config.max_quantity;
+        params.volatility = config.volatility;
+        params.tick_size = config.tick_size;
+        params.lot_size = config.lot_size;
+        return params;
+    }
+    
+    void simulate_group(std::vector<size_t> symbol_indices) {
+        // Per-symbol generators with small batches keep memory bounded when a
+        // thread drives thousands of symbols; streams are keyed by symbol
+        // index so the flow does not depend on how symbols are grouped
+        constexpr size_t group_batch_size = 64;
+        std::vector<OrderFlowGenerator> generators;
+        std::vector<uint64_t> orders_submitted(symbol_indices.size(), 0);
+        generators.reserve(symbol_indices.size());
+        for (size_t index : symbol_indices) {
+            generators.emplace_back(flow_params(symbol_configs_[index]), seed_, index, group_batch_size);
+        }
         
-        uint64_t current_price = config.base_price;
-        auto last_order_time = std::chrono::high_resolution_clock::now();
+        // Pace against a schedule rather than per-order clock deltas: every
+        // wake-up submits all orders that have fallen due since the start
+        auto start_time = std::chrono::high_resolution_clock::now();
         
         while (running_.load()) {
-            auto now = std::chrono::high_resolution_clock::now();
-            auto time_since_last_order = std::chrono::duration_cast<std::chrono::milliseconds>(
-                now - last_order_time).count();
-            
-            // Calculate target interval between orders
-            double target_interval_ms = 1000.0 / config.orders_per_second;
+            auto elapsed = std::chrono::duration<double>(
+                std::chrono::high_resolution_clock::now() - start_time).count();
             
-            if (time_since_last_order >= target_interval_ms) {
-                // Generate order
-                Side side = static_cast<Side>(side_dist(rng_));
-                OrderType order_type = (order_type_dist(rng_) < 0.9) ? OrderType::LIMIT : OrderType::MARKET;
+            uint64_t submitted_this_pass = 0;
+            for (size_t i = 0; i < symbol_indices.size(); ++i) {
+                const SymbolConfig& config = symbol_configs_[symbol_indices[i]];
+                uint64_t orders_due = static_cast<uint64_t>(elapsed * config.orders_per_second);
                 
-                uint64_t quantity = quantity_dist(rng_);
-                uint64_t price = 0;
-                
-                if (order_type == OrderType::LIMIT) {
-                    // Apply price volatility
-                    double price_change = price_change_dist(rng_);
-                    double price_multiplier = 1.0 + price_change;
-                    
-                    if (side == Side::BUY) {
-                        // Buy orders slightly below current price
-                        price = static_cast<uint64_t>(current_price * price_multiplier * 0.999);
-                    } else {
-                        // Sell orders slightly above current price
-                        price = static_cast<uint64_t>(current_price * price_multiplier * 1.001);
-                    }
-                    
-                    // Ensure price stays within reasonable bounds
-                    uint64_t min_price = config.base_price - config.price_range;
-                    uint64_t max_price = config.base_price + config.price_range;
-                    price = std::max(min_price, std::min(max_price, price));
-                }
-                
-                // Submit order
-                uint64_t order_id = simulator_.submit_order(config.symbol_id, side, order_type, 
-                                                          quantity, price);
-                
-                total_orders_generated_.fetch_add(1);
-                last_order_time = now;
-                
-                // Update current price based on order flow
-                if (order_type == OrderType::LIMIT) {
-                    current_price = price;
+                while (orders_submitted[i] < orders_due) {
+                    const OrderCommand& command = generators[i].next();
+                    simulator_.submit_order(command.symbol_id, command.side, command.order_type, 
+                                          command.quantity, command.price);
+                    orders_submitted[i]++;
+                    submitted_this_pass++;
                 }
-            } else {
-                // Sleep for a short time to avoid busy waiting
-                std::this_thread::sleep_for(std::chrono::microseconds(100));
             }
+            total_orders_generated_.fetch_add(submitted_this_pass);
+            
+            // Sleep for a short time to avoid busy waiting
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
         }
     }
     
@@ -184,7 +289,7 @@ private:
 } // namespace lob
 
 // Example usage function
-void run_market_simulation_example() {
+void run_market_simulation_example(const std::string& symbols_path) {
     lob::OrderBookSimulator simulator(4);
     
     // Register callbacks for trade notifications
@@ -198,6 +303,9 @@ void run_market_simulation_example() {
     }
     
     lob::MarketDataSimulator market_sim(simulator);
+    if (!symbols_path.empty() && !market_sim.load_symbols(symbols_path)) {
+        return;
+    }
     
     std::cout << "Starting market data simulation...\n";
     std::cout << "Press Ctrl+C to stop\n\n";
@@ -219,7 +327,58 @@ void run_market_simulation_example() {
               << final_metrics.average_latency_ns / 1000.0 << " μs\n";
 }
 
-int main() {
-    run_market_simulation_example();
+// Simulate one hour of order flow in discrete-event time
+void run_discrete_event_example(const std::string& model, const std::string& symbols_path) {
+    lob::OrderBookSimulator simulator(1);
+    lob::MarketDataSimulator market_sim(simulator);
+    if (!symbols_path.empty() && !market_sim.load_symbols(symbols_path)) {
+        return;
+    }
+    
+    if (model == "hawkes") {
+        market_sim.set_flow_model(lob::HawkesFlowModel::factory());
+    } else if (model == "queue-reactive") {
+        market_sim.set_flow_model(lob::QueueReactiveFlowModel::factory());
+    }
+    
+    constexpr lob::SimTime one_hour_ns = 3600ULL * 1000000000ULL;
+    
+    auto start_time = std::chrono::high_resolution_clock::now();
+    uint64_t orders = market_sim.run_discrete_event(one_hour_ns, 42);
+    auto end_time = std::chrono::high_resolution_clock::now();
+    
+    double wall_seconds = std::chrono::duration<double>(end_time - start_time).count();
+    auto metrics = simulator.get_performance_metrics();
+    
+    std::cout << "\n=== Discrete-Event Simulation (1 simulated hour, " << model << " flow) ===\n";
+    std::cout << "Orders submitted: " << orders << "\n";
+    std::cout << "Trades: " << metrics.trade_count << "\n";
+    std::cout << "Wall time: " << std::fixed << std::setprecision(3) << wall_seconds << " s\n";
+    std::cout << "Speedup vs real time: " << std::setprecision(0) << 3600.0 / wall_seconds << "x\n";
+}
+
+// Usage: market_simulator [--symbols <file>] [--discrete-event [poisson|hawkes|queue-reactive]]
+int main(int argc, char** argv) {
+    std::string symbols_path;
+    std::string model;
+    bool discrete_event = false;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--symbols" && i + 1 < argc) {
+            symbols_path = argv[++i];
+        } else if (arg == "--discrete-event") {
+            discrete_event = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                model = argv[++i];
+            }
+        }
+    }
+    
+    if (discrete_event) {
+        run_discrete_event_example(model.empty() ? "poisson" : model, symbols_path);
+    } else {
+        run_market_simulation_example(symbols_path);
+    }
     return 0;
 }
@@ -1,4 +1,5 @@
 #include "../include/limit_order_book.hpp"
+#include <cmath>
 #include <iostream>
 
 namespace lob {
@@ -10,21 +11,29 @@ bool OrderBook::add_order(std::shared_ptr<Order> order) {
         orders_[order->order_id] = order;
     }
     
-    // Process based on order type
-    switch (order->order_type) {
-        case OrderType::LIMIT:
-            process_limit_order(order);
-            break;
-        case OrderType::MARKET:
+    if (order->order_type != OrderType::LIMIT && !is_market_type(order->order_type) &&
+        order->order_type != OrderType::STOP) {
+        order->status = OrderStatus::REJECTED;
+        return false;
+    }
+    
+    {
+        std::unique_lock<std::shared_mutex> lock(book_mutex_);
+        advance_clock(order->timestamp);
+        journal_command(JournalCommand::NEW_ORDER, order.get());
+        
+        for (auto* listener : listeners_) {
+            listener->on_accept(*order);
+        }
+        
+        // Process based on order type (stops are treated as limits for now)
+        if (is_market_type(order->order_type)) {
             process_market_order(order);
-            break;
-        case OrderType::STOP:
-            // For simplicity, treat as limit order for now
+        } else {
             process_limit_order(order);
-            break;
-        default:
-            order->status = OrderStatus::REJECTED;
-            return false;
+        }
+        
+        publish_top_of_book();
     }
     
     // Notify market data subscribers
@@ -34,12 +43,31 @@ bool OrderBook::add_order(std::shared_ptr<Order> order) {
 }
 
 void OrderBook::process_limit_order(std::shared_ptr<Order> order) {
-    std::unique_lock<std::shared_mutex> lock(book_mutex_);
+    // Orders collect for the reopening auction during a halt
+    if (bands_.state == TradingState::HALTED) {
+        order->status = OrderStatus::NEW;
+        add_to_book(order);
+        return;
+    }
     
     // Try to match against opposite side
     auto& opposite_side = (order->side == Side::BUY) ? asks_ : bids_;
+    bool matched = try_match_order(order, opposite_side);
     
-    if (try_match_order(order, opposite_side)) {
+    // A remainder that still crosses was stopped by a price band; resting
+    // it would cross the book
+    if (!order->is_filled() && !opposite_side.empty()) {
+        uint64_t best = (order->side == Side::BUY) ? opposite_side.begin()->first : std::prev(opposite_side.end())->first;
+        if ((order->side == Side::BUY) ? (best <= order->price) : (best >= order->price)) {
+            order->status = OrderStatus::CANCELLED;
+            for (auto* listener : listeners_) {
+                listener->on_cancel(*order, order->remaining_quantity());
+            }
+            return;
+        }
+    }
+    
+    if (matched) {
         // Order was fully or partially matched
         if (order->is_filled()) {
             order->status = OrderStatus::FILLED;
@@ -56,91 +84,271 @@ void OrderBook::process_limit_order(std::shared_ptr<Order> order) {
 }
 
 void OrderBook::process_market_order(std::shared_ptr<Order> order) {
-    std::unique_lock<std::shared_mutex> lock(book_mutex_);
-    
-    // Try to match against opposite side
     auto& opposite_side = (order->side == Side::BUY) ? asks_ : bids_;
+    uint64_t last_price = 0;
     
-    if (try_match_order(order, opposite_side)) {
-        if (order->is_filled()) {
-            order->status = OrderStatus::FILLED;
-        } else {
-            order->status = OrderStatus::PARTIALLY_FILLED;
+    // Halted books only accept orders that can wait for the auction
+    if (bands_.state != TradingState::HALTED && !opposite_side.empty()) {
+        uint64_t best = (order->side == Side::BUY) ? opposite_side.begin()->first : std::prev(opposite_side.end())->first;
+        uint64_t collar = market_collar(order->side, best);
+        
+        // One walk outward from the best level, bounded by the collar and
+        // the price bands; no limit price to compare against
+        while (order->remaining_quantity() > 0 && !opposite_side.empty()) {
+            auto it = (order->side == Side::BUY) ? opposite_side.begin() : std::prev(opposite_side.end());
+            uint64_t price = it->first;
+            bool beyond_collar = collar && ((order->side == Side::BUY) ? price > collar : price < collar);
+            if (beyond_collar || !within_band(price)) {
+                break;
+            }
+            
+            match_at_level(order, *it->second, price);
+            last_price = price;
+            if (!it->second->is_empty()) {
+                break;
+            }
+            opposite_side.erase(it);
         }
-    } else {
-        // No liquidity available
-        order->status = OrderStatus::REJECTED;
+    }
+    
+    if (order->is_filled()) {
+        order->status = OrderStatus::FILLED;
+        return;
+    }
+    
+    // A market-to-limit remainder rests as a limit order at the last fill
+    // price, so modify, fill and cancel treat it like any resting limit;
+    // without a fill there is no price to convert at
+    if (order->order_type == OrderType::MARKET_TO_LIMIT && order->filled_quantity > 0) {
+        order->order_type = OrderType::LIMIT;
+        order->price = last_price;
+        order->status = OrderStatus::PARTIALLY_FILLED;
+        for (auto* listener : listeners_) {
+            listener->on_convert(*order);
+        }
+        add_to_book(order);
+        return;
+    }
+    
+    // Market orders never rest; any remainder is dropped
+    order->status = order->filled_quantity > 0 ? OrderStatus::PARTIALLY_FILLED : OrderStatus::REJECTED;
+    for (auto* listener : listeners_) {
+        listener->on_cancel(*order, order->remaining_quantity());
     }
 }
 
-bool OrderBook::try_match_order(std::shared_ptr<Order> order, 
-                               std::map<uint64_t, std::unique_ptr<PriceLevel>>& opposite_side) {
-    if (opposite_side.empty()) {
-        return false;
+uint64_t OrderBook::market_collar(Side side, uint64_t opposite_best) const noexcept {
+    uint64_t offset = UINT64_MAX;
+    if (market_protection_.collar_ticks) {
+        offset = market_protection_.collar_ticks * market_protection_.tick_size;
+    }
+    if (market_protection_.collar_bps) {
+        offset = std::min(offset, opposite_best * market_protection_.collar_bps / 10000);
+    }
+    if (offset == UINT64_MAX) {
+        return 0;
     }
     
-    // For buy orders, match against lowest ask prices
-    // For sell orders, match against highest bid prices
-    auto it = (order->side == Side::BUY) ? 
-        opposite_side.begin() : std::prev(opposite_side.end());
+    // 0 means no collar, so a sell collar bottoms out at 1
+    return side == Side::BUY ? opposite_best + offset : opposite_best - std::min(opposite_best - 1, offset);
+}
+
+void OrderBook::set_market_protection(const MarketProtection& protection) {
+    std::unique_lock<std::shared_mutex> lock(book_mutex_);
+    market_protection_ = protection;
+    market_protection_.tick_size = std::max<uint64_t>(1, protection.tick_size);
+}
+
+void OrderBook::set_journal(JournalSink sink) {
+    std::unique_lock<std::shared_mutex> lock(book_mutex_);
+    journal_ = std::move(sink);
+}
+
+void OrderBook::journal_command(JournalCommand command, const Order* order) {
+    if (!journal_) {
+        return;
+    }
     
-    while (it != opposite_side.end() && order->remaining_quantity() > 0) {
-        auto& [price, price_level] = *it;
-        
-        // Check if price is acceptable
-        bool price_acceptable = (order->side == Side::BUY) ? 
-            (price <= order->price) : (price >= order->price);
-        
-        if (!price_acceptable) {
-            break;
+    // Stamped with the book clock so replay sees the same time sequence
+    JournalRecord record;
+    record.sequence = ++journal_sequence_;
+    record.timestamp = clock_us_;
+    record.symbol_id = symbol_id_;
+    record.command = command;
+    if (order) {
+        record.order_id = order->order_id;
+        record.quantity = order->quantity;
+        record.price = order->price;
+        record.account_id = order->account_id;
+        record.session_id = order->session_id;
+        record.cl_ord_id = order->cl_ord_id;
+        record.side = order->side;
+        record.order_type = order->order_type;
+    }
+    journal_(record);
+    journal_sequence_ = record.sequence;
+}
+
+BookSnapshot OrderBook::snapshot() const {
+    BookSnapshot snapshot;
+    std::shared_lock<std::shared_mutex> lock(book_mutex_);
+    
+    snapshot.symbol_id = symbol_id_;
+    snapshot.sequence = journal_sequence_;
+    snapshot.clock_us = clock_us_;
+    snapshot.next_trade_id = next_trade_id_.load();
+    snapshot.total_volume = total_volume_.load();
+    snapshot.trade_count = trade_count_.load();
+    snapshot.last_trade_price = last_trade_price_.load();
+    snapshot.last_trade_quantity = last_trade_quantity_.load();
+    snapshot.market_protection = market_protection_;
+    snapshot.band_config = band_config_;
+    snapshot.band_reference = band_reference_;
+    snapshot.bands = bands_;
+    snapshot.feature_config = feature_config_;
+    snapshot.features = features_;
+    snapshot.feature_top = feature_top_;
+    snapshot.spread_variance = spread_variance_;
+    snapshot.mid_variance = mid_variance_;
+    
+    for (auto it = bids_.rbegin(); it != bids_.rend(); ++it) {
+        it->second->copy_orders(snapshot.orders);
+    }
+    for (const auto& [price, level] : asks_) {
+        level->copy_orders(snapshot.orders);
+    }
+    return snapshot;
+}
+
+void OrderBook::restore(const BookSnapshot& snapshot) {
+    std::vector<std::shared_ptr<Order>> orders;
+    orders.reserve(snapshot.orders.size());
+    for (const Order& order : snapshot.orders) {
+        orders.push_back(std::make_shared<Order>(order));
+        orders.back()->session_prev = nullptr;
+        orders.back()->session_next = nullptr;
+    }
+    
+    {
+        std::unique_lock<std::shared_mutex> lock(book_mutex_);
+        std::vector<Order> dropped;
+        for (const auto& [price, level] : bids_) {
+            level->copy_orders(dropped);
         }
-        
-        // Try to match against orders at this price level
-        while (order->remaining_quantity() > 0) {
-            auto matching_order = price_level->get_best_order();
-            if (!matching_order) {
-                break;
-            }
-            
-            uint64_t trade_quantity = std::min(order->remaining_quantity(), 
-                                             matching_order->remaining_quantity());
+        for (const auto& [price, level] : asks_) {
+            level->copy_orders(dropped);
+        }
+        {
+            std::unique_lock<std::shared_mutex> orders_lock(orders_mutex_);
             
-            // Execute the trade
-            execute_trade(order, matching_order, trade_quantity);
+            // Listeners release what the resting orders held before they go
+            for (const Order& copy : dropped) {
+                auto it = orders_.find(copy.order_id);
+                if (it != orders_.end()) {
+                    for (auto* listener : listeners_) {
+                        listener->on_restore_drop(*it->second);
+                    }
+                }
+            }
             
-            // Remove fully filled orders from the book
-            if (matching_order->is_filled()) {
-                price_level->remove_order(matching_order->order_id);
-                matching_order->status = OrderStatus::FILLED;
+            orders_.clear();
+            for (const auto& order : orders) {
+                orders_[order->order_id] = order;
             }
         }
+        bids_.clear();
+        asks_.clear();
         
-        // Remove empty price levels
-        if (price_level->is_empty()) {
-            it = opposite_side.erase(it);
-            if (opposite_side.empty()) break;
-        } else {
-            if (order->side == Side::BUY) {
-                ++it;
-            } else {
-                if (it == opposite_side.begin()) break;
-                --it;
+        // Snapshot order is priority order, so appending rebuilds each queue
+        for (const auto& order : orders) {
+            for (auto* listener : listeners_) {
+                listener->on_restore(*order);
             }
+            add_to_book(order);
+        }
+        
+        journal_sequence_ = snapshot.sequence;
+        clock_us_ = snapshot.clock_us;
+        next_trade_id_.store(snapshot.next_trade_id);
+        total_volume_.store(snapshot.total_volume);
+        trade_count_.store(snapshot.trade_count);
+        last_trade_price_.store(snapshot.last_trade_price);
+        last_trade_quantity_.store(snapshot.last_trade_quantity);
+        market_protection_ = snapshot.market_protection;
+        band_config_ = snapshot.band_config;
+        band_reference_ = snapshot.band_reference;
+        bands_ = snapshot.bands;
+        published_bands_.store(bands_);
+        feature_config_ = snapshot.feature_config;
+        features_ = snapshot.features;
+        feature_top_ = snapshot.feature_top;
+        spread_variance_ = snapshot.spread_variance;
+        mid_variance_ = snapshot.mid_variance;
+        published_features_.store(features_);
+        publish_top_of_book();
+    }
+    
+    notify_market_data();
+}
+
+bool OrderBook::try_match_order(std::shared_ptr<Order> order, 
+                               std::map<uint64_t, std::unique_ptr<PriceLevel>>& opposite_side) {
+    // For buy orders, match against lowest ask prices
+    // For sell orders, match against highest bid prices
+    while (order->remaining_quantity() > 0 && !opposite_side.empty()) {
+        auto it = (order->side == Side::BUY) ? opposite_side.begin() : std::prev(opposite_side.end());
+        uint64_t price = it->first;
+        
+        bool price_acceptable = (order->side == Side::BUY) ? (price <= order->price) : (price >= order->price);
+        if (!price_acceptable || !within_band(price)) {
+            break;
+        }
+        
+        match_at_level(order, *it->second, price);
+        
+        // A level left non-empty means the order is done
+        if (!it->second->is_empty()) {
+            break;
         }
+        opposite_side.erase(it);
     }
     
     return order->filled_quantity > 0;
 }
 
+void OrderBook::match_at_level(const std::shared_ptr<Order>& order, PriceLevel& level, uint64_t price) {
+    while (order->remaining_quantity() > 0) {
+        auto matching_order = level.get_best_order();
+        if (!matching_order) {
+            break;
+        }
+        
+        uint64_t trade_quantity = std::min(order->remaining_quantity(), 
+                                         matching_order->remaining_quantity());
+        
+        // Execute the trade
+        execute_trade(order, matching_order, trade_quantity, price);
+        level.reduce_quantity(trade_quantity);
+        
+        // Remove fully filled orders from the book
+        if (matching_order->is_filled()) {
+            level.remove_order(matching_order->order_id);
+            matching_order->status = OrderStatus::FILLED;
+        } else {
+            matching_order->status = OrderStatus::PARTIALLY_FILLED;
+        }
+    }
+}
+
 void OrderBook::execute_trade(std::shared_ptr<Order> order1, std::shared_ptr<Order> order2, 
-                            uint64_t quantity) {
+                            uint64_t quantity, uint64_t price) {
     // Determine buy and sell orders
     auto buy_order = (order1->side == Side::BUY) ? order1 : order2;
     auto sell_order = (order1->side == Side::SELL) ? order1 : order2;
     
-    // Create trade record
+    // Create trade record (the resting price, or the auction price)
     Trade trade(next_trade_id_.fetch_add(1), buy_order->order_id, sell_order->order_id,
-               symbol_id_, quantity, sell_order->price);
+               symbol_id_, quantity, price);
     
     // Update order quantities
     order1->filled_quantity += quantity;
@@ -149,6 +357,22 @@ void OrderBook::execute_trade(std::shared_ptr<Order> order1, std::shared_ptr<Ord
     // Update statistics
     total_volume_.fetch_add(quantity);
     trade_count_.fetch_add(1);
+    last_trade_price_.store(trade.price, std::memory_order_relaxed);
+    last_trade_quantity_.store(quantity, std::memory_order_relaxed);
+    
+    // Continuous trades move the band reference; auction prints reset it
+    if (band_config_.band_bps && bands_.state != TradingState::HALTED) {
+        band_reference_.add(clock_us_, price);
+        set_reference_price(band_reference_.mean(clock_us_));
+    }
+    
+    for (auto* listener : listeners_) {
+        listener->on_fill(*order1, quantity, trade.price);
+        listener->on_fill(*order2, quantity, trade.price);
+    }
+    for (auto* listener : listeners_) {
+        listener->on_trade(trade);
+    }
     
     // Notify trade subscribers
     notify_trade(trade);
@@ -164,74 +388,543 @@ void OrderBook::add_to_book(std::shared_ptr<Order> order) {
     }
     
     side[price]->add_order(order);
+    for (auto* listener : listeners_) {
+        listener->on_rest(*order);
+    }
 }
 
-bool OrderBook::cancel_order(uint64_t order_id) {
-    std::shared_ptr<Order> order;
+void OrderBook::publish_top_of_book() {
+    TopOfBook top;
     
-    // Find the order
+    if (!bids_.empty()) {
+        auto best_bid_it = std::prev(bids_.end());
+        top.best_bid_price = best_bid_it->first;
+        top.best_bid_quantity = best_bid_it->second->get_total_quantity();
+    }
+    
+    if (!asks_.empty()) {
+        auto best_ask_it = asks_.begin();
+        top.best_ask_price = best_ask_it->first;
+        top.best_ask_quantity = best_ask_it->second->get_total_quantity();
+    }
+    
+    top_of_book_.store(top);
+    
+    if (feature_config_.depth) {
+        update_features(top);
+    }
+    if (band_config_.band_bps) {
+        update_limit_state(top);
+    }
+}
+
+void OrderBook::set_features(const BookFeaturesConfig& config) {
+    std::unique_lock<std::shared_mutex> lock(book_mutex_);
+    
+    feature_config_ = config;
+    feature_config_.depth = std::min(config.depth, BookFeaturesConfig::kMaxDepth);
+    features_ = BookFeatures{};
+    feature_top_ = TopOfBook{};
+    spread_variance_ = 0.0;
+    mid_variance_ = 0.0;
+    if (feature_config_.depth) {
+        update_features(top_of_book_.load());
+    } else {
+        published_features_.store(features_);
+    }
+}
+
+void OrderBook::update_features(const TopOfBook& top) {
+    constexpr uint32_t kLanes = 4;
+    constexpr uint32_t kMaxDepth = BookFeaturesConfig::kMaxDepth;
+    
+    // Zero-padded level arrays; padding contributes nothing to the sums
+    alignas(32) double bid_price[kMaxDepth] = {};
+    alignas(32) double bid_quantity[kMaxDepth] = {};
+    alignas(32) double ask_price[kMaxDepth] = {};
+    alignas(32) double ask_quantity[kMaxDepth] = {};
+    
+    uint32_t levels = 0;
+    for (auto it = bids_.rbegin(); levels < feature_config_.depth && it != bids_.rend(); ++it, ++levels) {
+        bid_price[levels] = static_cast<double>(it->first);
+        bid_quantity[levels] = static_cast<double>(it->second->get_total_quantity());
+    }
+    levels = 0;
+    for (auto it = asks_.begin(); levels < feature_config_.depth && it != asks_.end(); ++it, ++levels) {
+        ask_price[levels] = static_cast<double>(it->first);
+        ask_quantity[levels] = static_cast<double>(it->second->get_total_quantity());
+    }
+    
+    // Independent accumulators per lane, so the reductions compile to SIMD
+    // under -march=native without reassociating floating point sums
+    double bid_depth[kLanes] = {}, bid_notional[kLanes] = {};
+    double ask_depth[kLanes] = {}, ask_notional[kLanes] = {};
+    for (uint32_t i = 0; i < kMaxDepth; i += kLanes) {
+        for (uint32_t lane = 0; lane < kLanes; ++lane) {
+            bid_depth[lane] += bid_quantity[i + lane];
+            bid_notional[lane] += bid_price[i + lane] * bid_quantity[i + lane];
+            ask_depth[lane] += ask_quantity[i + lane];
+            ask_notional[lane] += ask_price[i + lane] * ask_quantity[i + lane];
+        }
+    }
+    double total_bid = (bid_depth[0] + bid_depth[1]) + (bid_depth[2] + bid_depth[3]);
+    double total_ask = (ask_depth[0] + ask_depth[1]) + (ask_depth[2] + ask_depth[3]);
+    double bid_vwap = total_bid > 0 ? ((bid_notional[0] + bid_notional[1]) + (bid_notional[2] + bid_notional[3])) / total_bid : 0.0;
+    double ask_vwap = total_ask > 0 ? ((ask_notional[0] + ask_notional[1]) + (ask_notional[2] + ask_notional[3])) / total_ask : 0.0;
+    
+    double top_bid = static_cast<double>(top.best_bid_quantity);
+    double top_ask = static_cast<double>(top.best_ask_quantity);
+    features_.imbalance = top_bid + top_ask > 0 ? (top_bid - top_ask) / (top_bid + top_ask) : 0.0;
+    features_.depth_imbalance = total_bid + total_ask > 0 ? (total_bid - total_ask) / (total_bid + total_ask) : 0.0;
+    
+    bool two_sided = top.best_bid_price && top.best_ask_price;
+    double bid = static_cast<double>(top.best_bid_price);
+    double ask = static_cast<double>(top.best_ask_price);
+    features_.microprice = two_sided ? (bid * top_ask + ask * top_bid) / (top_bid + top_ask) : 0.0;
+    features_.depth_weighted_mid = two_sided ? (bid_vwap + ask_vwap) / 2 : 0.0;
+    
+    // Rolling statistics advance once per two-sided BBO change
+    bool changed = top.best_bid_price != feature_top_.best_bid_price ||
+                   top.best_ask_price != feature_top_.best_ask_price;
+    if (two_sided && changed) {
+        double alpha = feature_config_.ewma_alpha;
+        double spread = ask - bid;
+        if (features_.bbo_changes == 0) {
+            features_.spread_mean = spread;
+        } else {
+            double deviation = spread - features_.spread_mean;
+            features_.spread_mean += alpha * deviation;
+            spread_variance_ = (1 - alpha) * (spread_variance_ + alpha * deviation * deviation);
+        }
+        if (feature_top_.best_bid_price && feature_top_.best_ask_price) {
+            double mid_change = (bid + ask - static_cast<double>(feature_top_.best_bid_price) -
+                                 static_cast<double>(feature_top_.best_ask_price)) / 2;
+            mid_variance_ = (1 - alpha) * mid_variance_ + alpha * mid_change * mid_change;
+        }
+        features_.spread_volatility = std::sqrt(spread_variance_);
+        features_.mid_volatility = std::sqrt(mid_variance_);
+        features_.bbo_changes++;
+    }
+    feature_top_ = top;
+    
+    published_features_.store(features_);
+}
+
+void OrderBook::set_price_bands(const PriceBandConfig& config) {
+    bool uncrossed = false;
     {
-        std::shared_lock<std::shared_mutex> lock(orders_mutex_);
-        auto it = orders_.find(order_id);
-        if (it == orders_.end()) {
-            return false;
+        std::unique_lock<std::shared_mutex> lock(book_mutex_);
+        
+        // A halted book may be crossed, and nothing else would uncross it
+        // once the halt is gone, so it reopens through the auction first
+        if (bands_.state == TradingState::HALTED) {
+            run_volatility_auction();
+            uncrossed = true;
+        }
+        
+        band_config_ = config;
+        band_reference_.reset(config.reference_window_us);
+        bands_ = PriceBands{};
+        set_reference_price(config.band_bps ? config.initial_reference_price : 0);
+        published_bands_.store(bands_);
+        if (uncrossed) {
+            publish_top_of_book();
+        }
+    }
+    
+    if (uncrossed) {
+        notify_market_data();
+    }
+}
+
+void OrderBook::advance_time(uint64_t now_us) {
+    bool changed;
+    {
+        std::unique_lock<std::shared_mutex> lock(book_mutex_);
+        uint64_t previous = clock_us_;
+        changed = advance_clock(now_us);
+        if (clock_us_ > previous) {
+            journal_command(JournalCommand::ADVANCE_TIME, nullptr);
+        }
+        if (changed) {
+            publish_top_of_book();
         }
-        order = it->second;
     }
     
-    if (order->status == OrderStatus::FILLED || order->status == OrderStatus::CANCELLED) {
+    if (changed) {
+        notify_market_data();
+    }
+}
+
+bool OrderBook::advance_clock(uint64_t now_us) {
+    clock_us_ = std::max(clock_us_, now_us);
+    
+    if (bands_.state == TradingState::CONTINUOUS || clock_us_ < bands_.state_deadline_us) {
         return false;
     }
     
-    // Remove from book if it's not fully filled
-    if (order->filled_quantity < order->quantity) {
-        std::unique_lock<std::shared_mutex> lock(book_mutex_);
+    // Deadlines chain from the previous one, so a long gap between events
+    // can pass through the halt and the auction at once
+    if (bands_.state == TradingState::LIMIT_STATE) {
+        bands_.state = TradingState::HALTED;
+        bands_.state_deadline_us += band_config_.halt_us;
+        published_bands_.store(bands_);
+        if (clock_us_ < bands_.state_deadline_us) {
+            return true;
+        }
+    }
+    
+    run_volatility_auction();
+    return true;
+}
+
+void OrderBook::set_reference_price(uint64_t reference_price) {
+    if (reference_price == bands_.reference_price) {
+        return;
+    }
+    
+    uint64_t half_width = reference_price * band_config_.band_bps / 10000;
+    bands_.reference_price = reference_price;
+    bands_.lower = reference_price > half_width ? reference_price - half_width : 0;
+    bands_.upper = reference_price ? reference_price + half_width : 0;
+    published_bands_.store(bands_);
+}
+
+void OrderBook::update_limit_state(const TopOfBook& top) {
+    if (bands_.upper == 0 || bands_.state == TradingState::HALTED) {
+        return;
+    }
+    
+    bool at_band = (top.best_bid_price && top.best_bid_price >= bands_.upper) ||
+                   (top.best_ask_price && top.best_ask_price <= bands_.lower);
+    if (at_band == (bands_.state == TradingState::LIMIT_STATE)) {
+        return;
+    }
+    
+    bands_.state = at_band ? TradingState::LIMIT_STATE : TradingState::CONTINUOUS;
+    bands_.state_deadline_us = at_band ? clock_us_ + band_config_.limit_state_us : 0;
+    published_bands_.store(bands_);
+}
+
+void OrderBook::run_volatility_auction() {
+    uint64_t auction_price = 0;
+    
+    if (!bids_.empty() && !asks_.empty() && std::prev(bids_.end())->first >= asks_.begin()->first) {
+        // Crossed region, both sides ascending
+        uint64_t best_bid = std::prev(bids_.end())->first;
+        uint64_t best_ask = asks_.begin()->first;
+        std::vector<std::pair<uint64_t, uint64_t>> bid_levels;
+        std::vector<std::pair<uint64_t, uint64_t>> ask_levels;
+        uint64_t total_demand = 0;
+        for (auto it = bids_.lower_bound(best_ask); it != bids_.end(); ++it) {
+            bid_levels.emplace_back(it->first, it->second->get_total_quantity());
+            total_demand += it->second->get_total_quantity();
+        }
+        for (auto it = asks_.begin(); it != asks_.end() && it->first <= best_bid; ++it) {
+            ask_levels.emplace_back(it->first, it->second->get_total_quantity());
+        }
         
-        auto& side = (order->side == Side::BUY) ? bids_ : asks_;
-        auto it = side.find(order->price);
+        // Maximize executed volume, then minimize imbalance, then stay
+        // nearest the old reference
+        uint64_t best_volume = 0;
+        uint64_t best_imbalance = 0;
+        uint64_t best_distance = 0;
+        uint64_t demand_below = 0;   // Bids priced under the candidate
+        uint64_t supply = 0;         // Asks priced at or under the candidate
+        size_t b = 0, a = 0;
+        while (b < bid_levels.size() || a < ask_levels.size()) {
+            uint64_t price = std::min(b < bid_levels.size() ? bid_levels[b].first : UINT64_MAX,
+                                      a < ask_levels.size() ? ask_levels[a].first : UINT64_MAX);
+            for (; a < ask_levels.size() && ask_levels[a].first == price; ++a) {
+                supply += ask_levels[a].second;
+            }
+            
+            uint64_t demand = total_demand - demand_below;
+            uint64_t volume = std::min(demand, supply);
+            uint64_t imbalance = demand > supply ? demand - supply : supply - demand;
+            uint64_t reference = bands_.reference_price;
+            uint64_t distance = price > reference ? price - reference : reference - price;
+            if (volume > best_volume ||
+                (volume == best_volume && (imbalance < best_imbalance ||
+                                           (imbalance == best_imbalance && distance < best_distance)))) {
+                auction_price = price;
+                best_volume = volume;
+                best_imbalance = imbalance;
+                best_distance = distance;
+            }
+            
+            for (; b < bid_levels.size() && bid_levels[b].first == price; ++b) {
+                demand_below += bid_levels[b].second;
+            }
+        }
         
-        if (it != side.end()) {
-            it->second->remove_order(order_id);
+        // Uncross in price-time priority at the single auction price
+        while (!bids_.empty() && !asks_.empty()) {
+            auto bid_it = std::prev(bids_.end());
+            auto ask_it = asks_.begin();
+            if (bid_it->first < auction_price || ask_it->first > auction_price) {
+                break;
+            }
             
-            // Remove empty price levels
-            if (it->second->is_empty()) {
-                side.erase(it);
+            auto buy = bid_it->second->get_best_order();
+            auto sell = ask_it->second->get_best_order();
+            if (!buy || !sell) {
+                break;
             }
+            uint64_t quantity = std::min(buy->remaining_quantity(), sell->remaining_quantity());
+            execute_trade(buy, sell, quantity, auction_price);
+            bid_it->second->reduce_quantity(quantity);
+            ask_it->second->reduce_quantity(quantity);
+            
+            auto settle = [](auto& side, auto it, const std::shared_ptr<Order>& order) {
+                if (order->is_filled()) {
+                    it->second->remove_order(order->order_id);
+                    order->status = OrderStatus::FILLED;
+                } else {
+                    order->status = OrderStatus::PARTIALLY_FILLED;
+                }
+                if (it->second->is_empty()) {
+                    side.erase(it);
+                }
+            };
+            settle(bids_, bid_it, buy);
+            settle(asks_, ask_it, sell);
         }
     }
     
-    order->status = OrderStatus::CANCELLED;
+    // Reopen around the auction price, or the old reference if nothing crossed
+    uint64_t reference = auction_price ? auction_price : bands_.reference_price;
+    band_reference_.reset(band_config_.reference_window_us);
+    if (auction_price) {
+        band_reference_.add(clock_us_, auction_price);
+    }
+    bands_.state = TradingState::CONTINUOUS;
+    bands_.state_deadline_us = 0;
+    bands_.reference_price = 0;
+    set_reference_price(reference);
+    published_bands_.store(bands_);
+}
+
+bool OrderBook::cancel_order(uint64_t order_id) {
+    std::shared_ptr<Order> order = find_order(order_id);
+    if (!order || order->order_type == OrderType::MARKET) {
+        return false;
+    }
+    
+    {
+        std::unique_lock<std::shared_mutex> lock(book_mutex_);
+        
+        if (!cancel_locked(*order)) {
+            return false;
+        }
+        
+        publish_top_of_book();
+    }
+    
     notify_market_data();
     
     return true;
 }
 
-bool OrderBook::modify_order(uint64_t order_id, uint64_t new_quantity, uint64_t new_price) {
-    std::shared_ptr<Order> order;
+size_t OrderBook::cancel_orders(const std::vector<uint64_t>& order_ids) {
+    std::vector<std::shared_ptr<Order>> orders;
+    orders.reserve(order_ids.size());
+    for (uint64_t order_id : order_ids) {
+        std::shared_ptr<Order> order = find_order(order_id);
+        if (order && order->order_type != OrderType::MARKET) {
+            orders.push_back(std::move(order));
+        }
+    }
     
-    // Find the order
+    size_t cancelled = 0;
     {
-        std::shared_lock<std::shared_mutex> lock(orders_mutex_);
-        auto it = orders_.find(order_id);
-        if (it == orders_.end()) {
-            return false;
+        std::unique_lock<std::shared_mutex> lock(book_mutex_);
+        
+        for (const auto& order : orders) {
+            cancelled += cancel_locked(*order);
+        }
+        
+        if (cancelled == 0) {
+            return 0;
         }
-        order = it->second;
+        publish_top_of_book();
     }
     
-    if (order->status == OrderStatus::FILLED || order->status == OrderStatus::CANCELLED) {
+    notify_market_data();
+    
+    return cancelled;
+}
+
+bool OrderBook::cancel_locked(Order& order) {
+    if (order.status == OrderStatus::FILLED || order.status == OrderStatus::CANCELLED ||
+        order.status == OrderStatus::REJECTED) {
         return false;
     }
     
-    // Cancel the existing order and create a new one
-    cancel_order(order_id);
+    journal_command(JournalCommand::CANCEL, &order);
+    remove_from_book(order);
+    order.status = OrderStatus::CANCELLED;
+    for (auto* listener : listeners_) {
+        listener->on_cancel(order, order.remaining_quantity());
+    }
+    return true;
+}
+
+bool OrderBook::modify_order(uint64_t order_id, uint64_t new_quantity, uint64_t new_price, uint64_t timestamp,
+                             const ClOrdId* cl_ord_id) {
+    // Find the order
+    std::shared_ptr<Order> order = find_order(order_id);
+    if (!order || order->order_type == OrderType::MARKET) {
+        return false;
+    }
     
     // Create new order with modified parameters
     auto new_order = std::make_shared<Order>(order_id, order->symbol_id, order->side,
                                            order->order_type, new_quantity, 
-                                           new_price > 0 ? new_price : order->price);
+                                           new_price > 0 ? new_price : order->price,
+                                           order->stop_price, order->account_id);
+    new_order->session_id = order->session_id;
+    new_order->cl_ord_id = cl_ord_id ? *cl_ord_id : order->cl_ord_id;
+    if (timestamp) {
+        new_order->timestamp = timestamp;
+    }
+    
+    {
+        std::unique_lock<std::shared_mutex> lock(book_mutex_);
+        advance_clock(new_order->timestamp);
+        
+        // Fails if the original already traded out or was cancelled
+        if (order->status == OrderStatus::FILLED || order->status == OrderStatus::CANCELLED ||
+            order->status == OrderStatus::REJECTED) {
+            return false;
+        }
+        
+        journal_command(JournalCommand::MODIFY, new_order.get());
+        remove_from_book(*order);
+        order->status = OrderStatus::CANCELLED;
+        for (auto* listener : listeners_) {
+            listener->on_replace(*order, *new_order);
+        }
+        
+        {
+            std::unique_lock<std::shared_mutex> orders_lock(orders_mutex_);
+            orders_[order_id] = new_order;
+        }
+        
+        process_limit_order(new_order);
+        publish_top_of_book();
+    }
+    
+    notify_market_data();
+    
+    return true;
+}
+
+void OrderBook::replace_quotes_locked(const std::vector<uint64_t>& cancel_ids,
+                                      const std::vector<std::shared_ptr<Order>>& quotes) {
+    std::vector<std::shared_ptr<Order>> cancelled;
+    cancelled.reserve(cancel_ids.size());
+    
+    for (uint64_t order_id : cancel_ids) {
+        std::shared_ptr<Order> order = find_order(order_id);
+        if (!order || order->status == OrderStatus::FILLED || order->status == OrderStatus::CANCELLED ||
+            order->status == OrderStatus::REJECTED) {
+            continue;
+        }
+        
+        // Levels emptied here are usually refilled by the new quotes, so
+        // they are only erased once those are in
+        journal_command(JournalCommand::CANCEL, order.get());
+        remove_from_book(*order, false);
+        order->status = OrderStatus::CANCELLED;
+        for (auto* listener : listeners_) {
+            listener->on_cancel(*order, order->remaining_quantity());
+        }
+        cancelled.push_back(std::move(order));
+    }
+    
+    // Replaced quotes are never addressed again, so their ids are dropped
+    // from the order map instead of accumulating
+    {
+        std::unique_lock<std::shared_mutex> orders_lock(orders_mutex_);
+        for (uint64_t order_id : cancel_ids) {
+            orders_.erase(order_id);
+        }
+        for (const auto& quote : quotes) {
+            orders_[quote->order_id] = quote;
+        }
+    }
+    
+    for (const auto& quote : quotes) {
+        advance_clock(quote->timestamp);
+        journal_command(JournalCommand::NEW_ORDER, quote.get());
+        for (auto* listener : listeners_) {
+            listener->on_accept(*quote);
+        }
+        process_limit_order(quote);
+    }
+    
+    for (const auto& order : cancelled) {
+        auto& side = (order->side == Side::BUY) ? bids_ : asks_;
+        auto it = side.find(order->price);
+        if (it != side.end() && it->second->is_empty()) {
+            side.erase(it);
+        }
+    }
+    
+    publish_top_of_book();
+}
+
+void OrderBook::remove_from_book(const Order& order, bool erase_empty_level) {
+    if (order.is_filled()) {
+        return;
+    }
+    
+    auto& side = (order.side == Side::BUY) ? bids_ : asks_;
+    auto it = side.find(order.price);
+    
+    if (it != side.end()) {
+        it->second->remove_order(order.order_id);
+        
+        // Remove empty price levels
+        if (erase_empty_level && it->second->is_empty()) {
+            side.erase(it);
+        }
+    }
+}
+
+std::shared_ptr<Order> OrderBook::find_order(uint64_t order_id) const {
+    std::shared_lock<std::shared_mutex> lock(orders_mutex_);
+    auto it = orders_.find(order_id);
+    return it != orders_.end() ? it->second : nullptr;
+}
+
+void OrderBook::reset() {
+    {
+        std::unique_lock<std::shared_mutex> lock(book_mutex_);
+        bids_.clear();
+        asks_.clear();
+        clock_us_ = 0;
+        band_reference_.reset(band_config_.reference_window_us);
+        bands_ = PriceBands{};
+        set_reference_price(band_config_.band_bps ? band_config_.initial_reference_price : 0);
+        published_bands_.store(bands_);
+        features_ = BookFeatures{};
+        feature_top_ = TopOfBook{};
+        spread_variance_ = 0.0;
+        mid_variance_ = 0.0;
+        publish_top_of_book();
+    }
+    {
+        std::unique_lock<std::shared_mutex> lock(orders_mutex_);
+        orders_.clear();
+    }
     
-    return add_order(new_order);
+    next_trade_id_.store(1);
+    total_volume_.store(0);
+    trade_count_.store(0);
+    last_trade_price_.store(0);
+    last_trade_quantity_.store(0);
 }
 
 MarketDataSnapshot OrderBook::get_market_data() const {
@@ -256,6 +949,8 @@ MarketDataSnapshot OrderBook::get_market_data() const {
         snapshot.best_ask_quantity = best_ask_it->second->get_total_quantity();
     }
     
+    snapshot.last_trade_price = last_trade_price_.load(std::memory_order_relaxed);
+    snapshot.last_trade_quantity = last_trade_quantity_.load(std::memory_order_relaxed);
     snapshot.volume = total_volume_.load();
     
     return snapshot;
@@ -287,27 +982,102 @@ std::vector<std::pair<uint64_t, uint64_t>> OrderBook::get_ask_levels(uint32_t de
     return levels;
 }
 
-void OrderBook::register_market_data_callback(std::function<void(const MarketDataSnapshot&)> callback) {
+uint32_t OrderBook::copy_levels(Side side, std::pair<uint64_t, uint64_t>* out, uint32_t depth) const {
+    std::shared_lock<std::shared_mutex> lock(book_mutex_);
+    
+    uint32_t count = 0;
+    if (side == Side::BUY) {
+        for (auto it = bids_.rbegin(); count < depth && it != bids_.rend(); ++it) {
+            out[count++] = {it->first, it->second->get_total_quantity()};
+        }
+    } else {
+        for (auto it = asks_.begin(); count < depth && it != asks_.end(); ++it) {
+            out[count++] = {it->first, it->second->get_total_quantity()};
+        }
+    }
+    
+    return count;
+}
+
+MatchSimulation OrderBook::simulate_match(Side side, uint64_t quantity, uint64_t limit_price) const {
+    MatchSimulation result;
+    
+    std::shared_lock<std::shared_mutex> lock(book_mutex_);
+    
+    // Walk the opposite side in price priority, exactly as the matcher would
+    auto walk = [&](auto begin, auto end) {
+        uint64_t notional = 0;
+        for (auto it = begin; it != end && result.filled_quantity < quantity; ++it) {
+            uint64_t price = it->first;
+            if (limit_price != 0) {
+                bool price_acceptable = (side == Side::BUY) ? (price <= limit_price) : (price >= limit_price);
+                if (!price_acceptable) {
+                    break;
+                }
+            }
+            
+            uint64_t filled = it->second->simulate_fills(price, quantity - result.filled_quantity, result.fills);
+            if (filled > 0) {
+                result.filled_quantity += filled;
+                result.levels_consumed++;
+                notional += filled * price;
+            }
+        }
+        if (result.filled_quantity > 0) {
+            result.average_price = static_cast<double>(notional) / result.filled_quantity;
+        }
+    };
+    
+    if (side == Side::BUY) {
+        walk(asks_.begin(), asks_.end());
+    } else {
+        walk(bids_.rbegin(), bids_.rend());
+    }
+    
+    result.remaining_quantity = quantity - result.filled_quantity;
+    return result;
+}
+
+uint64_t OrderBook::register_market_data_callback(std::function<void(const MarketDataSnapshot&)> callback) {
     std::lock_guard<std::mutex> lock(callbacks_mutex_);
-    market_data_callbacks_.push_back(callback);
+    uint64_t token = next_callback_token_++;
+    market_data_callbacks_.emplace_back(token, std::move(callback));
+    return token;
 }
 
-void OrderBook::register_trade_callback(std::function<void(const Trade&)> callback) {
+void OrderBook::unregister_market_data_callback(uint64_t token) {
+    // Callbacks run under callbacks_mutex_, so none is in flight past here
     std::lock_guard<std::mutex> lock(callbacks_mutex_);
+    auto it = std::find_if(market_data_callbacks_.begin(), market_data_callbacks_.end(),
+                           [token](const auto& entry) { return entry.first == token; });
+    if (it != market_data_callbacks_.end()) {
+        market_data_callbacks_.erase(it);
+    }
+}
+
+void OrderBook::register_trade_callback(std::function<void(const Trade&)> callback) {
+    std::lock_guard<std::mutex> lock(trade_callbacks_mutex_);
     trade_callbacks_.push_back(callback);
 }
 
+void OrderBook::add_listener(OrderEventListener* listener) {
+    listeners_.push_back(listener);
+}
+
 void OrderBook::notify_market_data() {
-    std::shared_lock<std::mutex> lock(callbacks_mutex_);
-    
+    // Snapshot before taking callbacks_mutex_, and trades use their own
+    // mutex: trades are published under the book lock, while market data
+    // callbacks may take it (e.g. to copy depth)
     auto snapshot = get_market_data();
-    for (const auto& callback : market_data_callbacks_) {
+    
+    std::lock_guard<std::mutex> lock(callbacks_mutex_);
+    for (const auto& [token, callback] : market_data_callbacks_) {
         callback(snapshot);
     }
 }
 
 void OrderBook::notify_trade(const Trade& trade) {
-    std::shared_lock<std::mutex> lock(callbacks_mutex_);
+    std::lock_guard<std::mutex> lock(trade_callbacks_mutex_);
     
     for (const auto& callback : trade_callbacks_) {
         callback(trade);
@@ -3,7 +3,12 @@
 
 namespace lob {
 
-OrderBookSimulator::OrderBookSimulator(size_t num_threads) {
+OrderBookSimulator::OrderBookSimulator(size_t num_threads)
+    : sessions_(new std::atomic<ClientSession*>[kMaxSessions]) {
+    for (size_t i = 0; i < kMaxSessions; ++i) {
+        sessions_[i].store(nullptr, std::memory_order_relaxed);
+    }
+    
     // Start worker threads
     for (size_t i = 0; i < num_threads; ++i) {
         worker_threads_.emplace_back(&OrderBookSimulator::worker_thread_function, this);
@@ -14,6 +19,10 @@ OrderBookSimulator::OrderBookSimulator(size_t num_threads) {
 
 OrderBookSimulator::~OrderBookSimulator() {
     stop_simulation();
+    
+    for (size_t i = 0; i < kMaxSessions; ++i) {
+        delete sessions_[i].load(std::memory_order_relaxed);
+    }
 }
 
 void OrderBookSimulator::worker_thread_function() {
@@ -44,34 +53,81 @@ void OrderBookSimulator::worker_thread_function() {
     }
 }
 
-uint64_t OrderBookSimulator::submit_order(uint32_t symbol_id, Side side, OrderType type, 
-                                        uint64_t quantity, uint64_t price, uint64_t stop_price) {
-    // Generate unique order ID
-    uint64_t order_id = next_order_id_.fetch_add(1);
-    
-    // Create order
-    auto order = std::make_shared<Order>(order_id, symbol_id, side, type, quantity, price, stop_price);
-    
-    // Get or create order book for this symbol
+OrderBook* OrderBookSimulator::get_or_create_book(uint32_t symbol_id) {
     {
         std::shared_lock<std::shared_mutex> lock(books_mutex_);
         auto it = order_books_.find(symbol_id);
-        if (it == order_books_.end()) {
-            lock.unlock();
-            std::unique_lock<std::shared_mutex> unique_lock(books_mutex_);
-            // Double-check after acquiring unique lock
-            it = order_books_.find(symbol_id);
-            if (it == order_books_.end()) {
-                order_books_[symbol_id] = std::make_unique<OrderBook>(symbol_id);
-                it = order_books_.find(symbol_id);
-            }
+        if (it != order_books_.end()) {
+            return it->second.get();
+        }
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(books_mutex_);
+    // Double-check after acquiring unique lock
+    auto& order_book = order_books_[symbol_id];
+    if (!order_book) {
+        order_book = std::make_unique<OrderBook>(symbol_id);
+        order_book->add_listener(&risk_engine_);
+        order_book->add_listener(&position_keeper_);
+        order_book->add_listener(&order_states_);
+        order_book->add_listener(&report_router_);
+        if (bars_) {
+            bars_->attach(*order_book);
+        }
+        if (tape_capacity_) {
+            auto& tape = tapes_[symbol_id];
+            tape = std::make_unique<TradeTape>(tape_capacity_);
+            order_book->add_listener(tape.get());
+        }
+        if (journal_) {
+            attach_journal(*order_book);
+        }
+        for (auto* listener : book_listeners_) {
+            order_book->add_listener(listener);
         }
     }
+    return order_book.get();
+}
+
+uint64_t OrderBookSimulator::submit_order(uint32_t symbol_id, Side side, OrderType type, 
+                                        uint64_t quantity, uint64_t price, uint64_t stop_price,
+                                        uint32_t account_id) {
+    return place_order(symbol_id, side, type, quantity, price, stop_price, account_id, 0);
+}
+
+uint64_t OrderBookSimulator::place_order(uint32_t symbol_id, Side side, OrderType type,
+                                         uint64_t quantity, uint64_t price, uint64_t stop_price,
+                                         uint32_t account_id, uint32_t session_id, const ClOrdId& cl_ord_id) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    
+    // Get or create order book for this symbol
+    OrderBook* order_book = get_or_create_book(symbol_id);
+    
+    // Reference data, then the pre-trade risk stage, both against the book's last trade price
+    if (!validate_order(symbol_id, type, quantity, price, order_book->get_last_trade_price())) {
+        return 0;
+    }
+    if (risk_engine_.check_and_reserve(account_id, type, quantity, price, 
+                                       order_book->get_last_trade_price()) != RiskRejectReason::NONE) {
+        return 0;
+    }
+    
+    // Generate unique order ID
+    uint64_t order_id = next_order_id_.fetch_add(1);
+    
+    // Create order
+    auto order = std::make_shared<Order>(order_id, symbol_id, side, type, quantity, price, stop_price, account_id);
+    order->session_id = session_id;
+    order->cl_ord_id = cl_ord_id;
     
     // Submit order to the order book (this is thread-safe)
-    auto order_book = order_books_[symbol_id].get();
     order_book->add_order(order);
     
+    // Update performance metrics
+    auto end_time = std::chrono::high_resolution_clock::now();
+    total_latency_ns_.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count());
+    orders_processed_.fetch_add(1);
+    
     return order_id;
 }
 
@@ -94,14 +150,437 @@ bool OrderBookSimulator::modify_order(uint64_t order_id, uint64_t new_quantity,
     std::shared_lock<std::shared_mutex> lock(books_mutex_);
     
     for (auto& [symbol_id, order_book] : order_books_) {
-        if (order_book->modify_order(order_id, new_quantity, new_price)) {
-            return true;
+        if (order_book->find_order(order_id)) {
+            return modify_in_book(*order_book, order_id, new_quantity, new_price);
         }
     }
     
     return false;
 }
 
+bool OrderBookSimulator::modify_in_book(OrderBook& order_book, uint64_t order_id,
+                                        uint64_t new_quantity, uint64_t new_price, const ClOrdId* cl_ord_id) {
+    auto order = order_book.find_order(order_id);
+    if (!order) {
+        return false;
+    }
+    
+    // The replacement is checked with the original's remaining exposure
+    // credited, since cancelling it releases that exposure
+    uint64_t price = new_price > 0 ? new_price : order->price;
+    if (!validate_order(order->symbol_id, order->order_type, new_quantity, price, order_book.get_last_trade_price())) {
+        return false;
+    }
+    
+    uint64_t credit = is_market_type(order->order_type) ? 0 : order->remaining_quantity() * order->price;
+    if (risk_engine_.check_and_reserve(order->account_id, order->order_type, new_quantity, price,
+                                       order_book.get_last_trade_price(), credit) != RiskRejectReason::NONE) {
+        return false;
+    }
+    
+    if (order_book.modify_order(order_id, new_quantity, new_price, 0, cl_ord_id)) {
+        return true;
+    }
+    
+    if (!is_market_type(order->order_type)) {
+        risk_engine_.release(order->account_id, new_quantity * price);
+    }
+    return false;
+}
+
+bool OrderBookSimulator::validate_order(uint32_t symbol_id, OrderType type, uint64_t quantity,
+                                        uint64_t price, uint64_t reference_price) {
+    if (symbol_rules_.get(symbol_id).validate(type, quantity, price, reference_price) == ValidationResult::OK) {
+        return true;
+    }
+    validation_rejects_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+OrderBookSimulator::ClientSession* OrderBookSimulator::get_or_create_session(uint32_t session_id,
+                                                                             size_t report_capacity) {
+    if (session_id >= kMaxSessions) {
+        return nullptr;
+    }
+    
+    ClientSession* session = sessions_[session_id].load(std::memory_order_acquire);
+    if (!session) {
+        ClientSession* created = new ClientSession(report_capacity);
+        if (sessions_[session_id].compare_exchange_strong(session, created, std::memory_order_acq_rel)) {
+            session = created;
+            uint32_t high_water = session_high_water_.load(std::memory_order_relaxed);
+            while (high_water < session_id &&
+                   !session_high_water_.compare_exchange_weak(high_water, session_id, std::memory_order_acq_rel)) {
+            }
+        } else {
+            delete created;
+        }
+    }
+    return session;
+}
+
+OrderBookSimulator::ClientSession* OrderBookSimulator::find_session(uint32_t session_id) const noexcept {
+    return session_id < kMaxSessions ? sessions_[session_id].load(std::memory_order_acquire) : nullptr;
+}
+
+bool OrderBookSimulator::open_session(uint32_t session_id, size_t report_capacity) {
+    if (session_id == 0 || session_id >= kMaxSessions || find_session(session_id)) {
+        return false;
+    }
+    return get_or_create_session(session_id, report_capacity) != nullptr;
+}
+
+bool OrderBookSimulator::mass_quote(uint32_t session_id, const QuoteEntry* quotes, size_t count,
+                                    uint32_t account_id) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    
+    ClientSession* session = session_id != 0 ? get_or_create_session(session_id) : nullptr;
+    if (!session) {
+        return false;
+    }
+    std::lock_guard<std::mutex> session_lock(session->mutex);
+    
+    struct SymbolBatch {
+        OrderBook* book = nullptr;
+        std::vector<uint64_t> cancel_ids;
+        std::vector<std::shared_ptr<Order>> orders;
+    };
+    
+    // Ordered by symbol, which is also the book lock order
+    std::map<uint32_t, SymbolBatch> batches;
+    for (size_t i = 0; i < count; ++i) {
+        SymbolBatch& batch = batches[quotes[i].symbol_id];
+        if (!batch.book) {
+            batch.book = get_or_create_book(quotes[i].symbol_id);
+        }
+    }
+    
+    // Exposure of the quotes being replaced is credited to every check
+    uint64_t credit = 0;
+    for (auto& [symbol_id, batch] : batches) {
+        auto it = session->quotes.find(symbol_id);
+        if (it == session->quotes.end()) {
+            continue;
+        }
+        batch.cancel_ids = it->second;
+        for (uint64_t order_id : batch.cancel_ids) {
+            if (auto order = batch.book->find_order(order_id)) {
+                credit += order->remaining_quantity() * order->price;
+            }
+        }
+    }
+    
+    size_t reserved = 0;
+    for (; reserved < count; ++reserved) {
+        const QuoteEntry& quote = quotes[reserved];
+        if (quote.quantity == 0) {
+            continue;
+        }
+        uint64_t reference_price = batches[quote.symbol_id].book->get_last_trade_price();
+        if (!validate_order(quote.symbol_id, OrderType::LIMIT, quote.quantity, quote.price, reference_price)) {
+            break;
+        }
+        if (risk_engine_.check_and_reserve(account_id, OrderType::LIMIT, quote.quantity, quote.price,
+                                           reference_price, credit) != RiskRejectReason::NONE) {
+            break;
+        }
+    }
+    
+    // All legs or none
+    if (reserved != count) {
+        for (size_t i = 0; i < reserved; ++i) {
+            risk_engine_.release(account_id, quotes[i].quantity * quotes[i].price);
+        }
+        return false;
+    }
+    
+    size_t placed = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (quotes[i].quantity == 0) {
+            continue;
+        }
+        auto order = std::make_shared<Order>(next_order_id_.fetch_add(1), quotes[i].symbol_id, quotes[i].side,
+                                           OrderType::LIMIT, quotes[i].quantity, quotes[i].price, 0, account_id);
+        order->session_id = session_id;
+        batches[quotes[i].symbol_id].orders.push_back(std::move(order));
+        placed++;
+    }
+    
+    {
+        std::vector<std::unique_lock<std::shared_mutex>> locks;
+        locks.reserve(batches.size());
+        for (auto& [symbol_id, batch] : batches) {
+            locks.push_back(batch.book->lock_for_update());
+        }
+        
+        for (auto& [symbol_id, batch] : batches) {
+            batch.book->replace_quotes_locked(batch.cancel_ids, batch.orders);
+        }
+    }
+    
+    for (auto& [symbol_id, batch] : batches) {
+        batch.book->notify_market_data();
+        
+        auto& ids = session->quotes[symbol_id];
+        ids.clear();
+        for (const auto& order : batch.orders) {
+            ids.push_back(order->order_id);
+        }
+    }
+    
+    auto end_time = std::chrono::high_resolution_clock::now();
+    total_latency_ns_.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count());
+    orders_processed_.fetch_add(placed);
+    
+    return true;
+}
+
+size_t OrderBookSimulator::poll_execution_reports(uint32_t session_id, ExecutionReport* out, size_t max_count) {
+    ClientSession* session = find_session(session_id);
+    return session ? session->reports.pop_batch(out, max_count) : 0;
+}
+
+uint64_t OrderBookSimulator::get_dropped_reports(uint32_t session_id) const {
+    ClientSession* session = find_session(session_id);
+    return session ? session->dropped_reports.load(std::memory_order_relaxed) : 0;
+}
+
+void OrderBookSimulator::ReportRouter::publish(const Order& order, ExecType type,
+                                               uint64_t last_quantity, uint64_t last_price,
+                                               const Order* unlink, const Order* link) {
+    ClientSession* session = simulator_.find_session(order.session_id);
+    if (!session) {
+        return;
+    }
+    
+    ExecutionReport report;
+    report.order_id = order.order_id;
+    report.price = order.price;
+    report.last_quantity = last_quantity;
+    report.last_price = last_price;
+    report.cumulative_quantity = order.filled_quantity;
+    report.leaves_quantity = (type == ExecType::CANCEL || type == ExecType::REJECT) ? 0 : order.remaining_quantity();
+    report.symbol_id = order.symbol_id;
+    report.type = type;
+    report.side = order.side;
+    
+    // Books for different symbols can report to one session at once; the
+    // spinlock makes them a single producer
+    SpinGuard guard(session->report_lock);
+    if (unlink) {
+        session->unlink(*unlink);
+    }
+    if (link) {
+        session->link(*link);
+    }
+    if (!session->reports.try_push(report)) {
+        session->dropped_reports.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void OrderBookSimulator::ReportRouter::on_accept(const Order& order) {
+    if (order.session_id != 0) {
+        // Market orders never rest, so only limit orders join the live list
+        publish(order, ExecType::ACK, 0, 0, nullptr, order.order_type != OrderType::MARKET ? &order : nullptr);
+    }
+}
+
+void OrderBookSimulator::ReportRouter::on_fill(const Order& order, uint64_t quantity, uint64_t price) {
+    if (order.session_id != 0) {
+        bool filled = order.is_filled();
+        publish(order, filled ? ExecType::FILL : ExecType::PARTIAL_FILL, quantity, price, filled ? &order : nullptr);
+    }
+}
+
+void OrderBookSimulator::ReportRouter::on_cancel(const Order& order, uint64_t) {
+    // Market orders that found no liquidity are reported as rejected
+    if (order.session_id != 0) {
+        publish(order, order.status == OrderStatus::REJECTED ? ExecType::REJECT : ExecType::CANCEL, 0, 0, &order);
+    }
+}
+
+void OrderBookSimulator::ReportRouter::on_replace(const Order& original, const Order& replacement) {
+    if (replacement.session_id != 0) {
+        publish(replacement, ExecType::REPLACE, 0, 0, &original, &replacement);
+    }
+}
+
+void OrderBookSimulator::ReportRouter::on_restore_drop(const Order& order) {
+    if (ClientSession* session = simulator_.find_session(order.session_id)) {
+        SpinGuard guard(session->report_lock);
+        session->unlink(order);
+    }
+}
+
+void OrderBookSimulator::ReportRouter::on_restore(const Order& order) {
+    if (ClientSession* session = order.session_id != 0 ? simulator_.find_session(order.session_id) : nullptr) {
+        SpinGuard guard(session->report_lock);
+        session->link(order);
+    }
+}
+
+size_t OrderBookSimulator::purge_session(ClientSession& session) {
+    // Snapshot the live list grouped by book; cancels below unlink entries
+    // through the router, so the list itself is not walked unlocked
+    std::map<uint32_t, std::vector<uint64_t>> by_symbol;
+    {
+        SpinGuard guard(session.report_lock);
+        for (Order* order = session.live_head; order; order = order->session_next) {
+            by_symbol[order->symbol_id].push_back(order->order_id);
+        }
+    }
+    
+    size_t cancelled = 0;
+    for (const auto& [symbol_id, order_ids] : by_symbol) {
+        if (OrderBook* order_book = find_book(symbol_id)) {
+            cancelled += order_book->cancel_orders(order_ids);
+        }
+    }
+    
+    session.quotes.clear();
+    return cancelled;
+}
+
+size_t OrderBookSimulator::disconnect_session(uint32_t session_id) {
+    ClientSession* session = find_session(session_id);
+    if (!session) {
+        return 0;
+    }
+    
+    std::lock_guard<std::mutex> lock(session->mutex);
+    session->last_heartbeat_ns.store(0, std::memory_order_relaxed);
+    return purge_session(*session);
+}
+
+void OrderBookSimulator::session_heartbeat(uint32_t session_id) {
+    ClientSession* session = session_id != 0 ? get_or_create_session(session_id) : nullptr;
+    if (session) {
+        int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        session->last_heartbeat_ns.store(now, std::memory_order_relaxed);
+    }
+}
+
+size_t OrderBookSimulator::expire_sessions(std::chrono::nanoseconds timeout) {
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    
+    size_t cancelled = 0;
+    uint32_t high_water = session_high_water_.load(std::memory_order_acquire);
+    for (uint32_t session_id = 1; session_id <= high_water; ++session_id) {
+        ClientSession* session = find_session(session_id);
+        if (!session) {
+            continue;
+        }
+        
+        int64_t last = session->last_heartbeat_ns.load(std::memory_order_relaxed);
+        if (last != 0 && now - last > timeout.count()) {
+            cancelled += disconnect_session(session_id);
+        }
+    }
+    return cancelled;
+}
+
+size_t OrderBookSimulator::get_live_order_count(uint32_t session_id) const {
+    ClientSession* session = find_session(session_id);
+    if (!session) {
+        return 0;
+    }
+    
+    SpinGuard guard(session->report_lock);
+    return session->live_count;
+}
+
+OrderBook* OrderBookSimulator::find_book(uint32_t symbol_id) const {
+    // Books live as long as the simulator, so the pointer outlives the lock
+    std::shared_lock<std::shared_mutex> lock(books_mutex_);
+    auto it = order_books_.find(symbol_id);
+    return it != order_books_.end() ? it->second.get() : nullptr;
+}
+
+uint64_t OrderBookSimulator::submit_client_order(uint32_t session_id, std::string_view cl_ord_id, uint32_t symbol_id,
+                                                 Side side, OrderType type, uint64_t quantity, uint64_t price,
+                                                 uint64_t stop_price, uint32_t account_id) {
+    ClOrdId id;
+    if (!ClOrdId::from_string(cl_ord_id, id)) {
+        return 0;
+    }
+    
+    ClientSession* session = session_id != 0 ? get_or_create_session(session_id) : nullptr;
+    if (!session) {
+        return 0;
+    }
+    
+    // The session lock orders the duplicate check with the insert
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (session->index.find(id)) {
+        return 0;
+    }
+    
+    uint64_t order_id = place_order(symbol_id, side, type, quantity, price, stop_price, account_id, session_id, id);
+    if (order_id != 0) {
+        session->index.insert(id, order_id, symbol_id);
+    }
+    return order_id;
+}
+
+bool OrderBookSimulator::cancel_client_order(uint32_t session_id, std::string_view cl_ord_id) {
+    ClOrdId id;
+    ClientSession* session = find_session(session_id);
+    if (!session || !ClOrdId::from_string(cl_ord_id, id)) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(session->mutex);
+    const ClientOrderIndex::Entry* entry = session->index.find(id);
+    if (!entry) {
+        return false;
+    }
+    
+    OrderBook* order_book = find_book(entry->symbol_id);
+    return order_book && order_book->cancel_order(entry->order_id);
+}
+
+bool OrderBookSimulator::modify_client_order(uint32_t session_id, std::string_view orig_cl_ord_id,
+                                             std::string_view new_cl_ord_id,
+                                             uint64_t new_quantity, uint64_t new_price) {
+    ClOrdId orig_id, new_id;
+    ClientSession* session = find_session(session_id);
+    if (!session || !ClOrdId::from_string(orig_cl_ord_id, orig_id) ||
+        !ClOrdId::from_string(new_cl_ord_id, new_id)) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(session->mutex);
+    const ClientOrderIndex::Entry* entry = session->index.find(orig_id);
+    if (!entry || session->index.find(new_id)) {
+        return false;
+    }
+    
+    // Copy out before insert can rehash the table
+    uint64_t order_id = entry->order_id;
+    uint32_t symbol_id = entry->symbol_id;
+    OrderBook* order_book = find_book(symbol_id);
+    if (!order_book || !modify_in_book(*order_book, order_id, new_quantity, new_price, &new_id)) {
+        return false;
+    }
+    
+    session->index.insert(new_id, order_id, symbol_id);
+    return true;
+}
+
+uint64_t OrderBookSimulator::find_client_order(uint32_t session_id, std::string_view cl_ord_id) const {
+    ClOrdId id;
+    ClientSession* session = find_session(session_id);
+    if (!session || !ClOrdId::from_string(cl_ord_id, id)) {
+        return 0;
+    }
+    
+    std::lock_guard<std::mutex> lock(session->mutex);
+    const ClientOrderIndex::Entry* entry = session->index.find(id);
+    return entry ? entry->order_id : 0;
+}
+
 MarketDataSnapshot OrderBookSimulator::get_market_data(uint32_t symbol_id) const {
     std::shared_lock<std::shared_mutex> lock(books_mutex_);
     
@@ -136,24 +615,273 @@ std::vector<std::pair<uint64_t, uint64_t>> OrderBookSimulator::get_ask_levels(ui
     return {};
 }
 
-void OrderBookSimulator::register_market_data_callback(uint32_t symbol_id, 
-                                                     std::function<void(const MarketDataSnapshot&)> callback) {
+BarAggregator& OrderBookSimulator::enable_bars(std::vector<uint64_t> intervals_us) {
+    std::unique_lock<std::shared_mutex> lock(books_mutex_);
+    if (!bars_) {
+        bars_ = std::make_unique<BarAggregator>(std::move(intervals_us));
+        for (auto& [symbol_id, order_book] : order_books_) {
+            bars_->attach(*order_book);
+        }
+    }
+    return *bars_;
+}
+
+void OrderBookSimulator::set_journal(std::function<void(const JournalRecord&)> sink) {
+    std::unique_lock<std::shared_mutex> lock(books_mutex_);
+    journal_ = std::move(sink);
+    for (auto& [symbol_id, order_book] : order_books_) {
+        attach_journal(*order_book);
+    }
+}
+
+void OrderBookSimulator::attach_journal(OrderBook& order_book) {
+    if (!journal_) {
+        order_book.set_journal(nullptr);
+        return;
+    }
+    
+    // Restamped under the book lock, so one symbol's sequence numbers increase
+    order_book.set_journal([this](JournalRecord& record) {
+        record.sequence = journal_sequence_.fetch_add(1, std::memory_order_relaxed) + 1;
+        journal_(record);
+    });
+}
+
+bool OrderBookSimulator::apply_journal_record(const JournalRecord& record) {
+    OrderBook* order_book = get_or_create_book(record.symbol_id);
+    bool applied = true;
+    
+    switch (record.command) {
+        case JournalCommand::NEW_ORDER: {
+            if (!is_market_type(record.order_type)) {
+                risk_engine_.reserve(record.account_id, record.quantity * record.price);
+            }
+            auto order = std::make_shared<Order>(record.order_id, record.symbol_id, record.side, record.order_type,
+                                                 record.quantity, record.price, 0, record.account_id);
+            order->session_id = record.session_id;
+            order->cl_ord_id = record.cl_ord_id;
+            order->timestamp = record.timestamp;
+            
+            // The session must exist before the book accepts the order so
+            // the order joins its live list, as it did on the primary
+            ClientSession* session = record.session_id != 0 ? get_or_create_session(record.session_id) : nullptr;
+            if (!session) {
+                applied = order_book->add_order(order);
+                break;
+            }
+            std::lock_guard<std::mutex> lock(session->mutex);
+            applied = order_book->add_order(order);
+            if (record.cl_ord_id.length() > 0) {
+                session->index.insert(record.cl_ord_id, record.order_id, record.symbol_id);
+            }
+            break;
+        }
+        case JournalCommand::CANCEL:
+            applied = order_book->cancel_order(record.order_id);
+            break;
+        case JournalCommand::MODIFY:
+            if (!is_market_type(record.order_type)) {
+                risk_engine_.reserve(record.account_id, record.quantity * record.price);
+            }
+            applied = order_book->modify_order(record.order_id, record.quantity, record.price, record.timestamp,
+                                               &record.cl_ord_id);
+            if (!applied && !is_market_type(record.order_type)) {
+                risk_engine_.release(record.account_id, record.quantity * record.price);
+            }
+            if (applied && record.session_id != 0 && record.cl_ord_id.length() > 0) {
+                ClientSession* session = get_or_create_session(record.session_id);
+                std::lock_guard<std::mutex> lock(session->mutex);
+                session->index.insert(record.cl_ord_id, record.order_id, record.symbol_id);
+            }
+            break;
+        case JournalCommand::ADVANCE_TIME:
+            order_book->advance_time(record.timestamp);
+            break;
+    }
+    
+    // Ids and sequence numbers issued after a takeover continue past the primary's
+    advance_counters(record.order_id, record.sequence);
+    return applied;
+}
+
+void OrderBookSimulator::advance_counters(uint64_t order_id, uint64_t sequence) noexcept {
+    uint64_t next_id = next_order_id_.load(std::memory_order_relaxed);
+    while (next_id <= order_id && !next_order_id_.compare_exchange_weak(next_id, order_id + 1)) {
+    }
+    uint64_t current = journal_sequence_.load(std::memory_order_relaxed);
+    while (current < sequence && !journal_sequence_.compare_exchange_weak(current, sequence)) {
+    }
+}
+
+void OrderBookSimulator::restore_book(const BookSnapshot& snapshot, uint64_t last_order_id) {
+    // Restored orders rejoin their sessions' live lists, so the sessions
+    // must exist before the book reinstates them. Each order's current
+    // ClOrdID is indexed again; ids it was amended away from are not kept.
+    uint64_t max_order_id = last_order_id;
+    for (const Order& order : snapshot.orders) {
+        if (order.session_id != 0) {
+            ClientSession* session = get_or_create_session(order.session_id);
+            if (order.cl_ord_id.length() > 0) {
+                std::lock_guard<std::mutex> lock(session->mutex);
+                session->index.insert(order.cl_ord_id, order.order_id, order.symbol_id);
+            }
+        }
+        max_order_id = std::max(max_order_id, order.order_id);
+    }
+    
+    // Book listeners move reservations and session links across
+    get_or_create_book(snapshot.symbol_id)->restore(snapshot);
+    advance_counters(max_order_id, snapshot.sequence);
+}
+
+void OrderBookSimulator::add_book_listener(OrderEventListener* listener) {
+    std::unique_lock<std::shared_mutex> lock(books_mutex_);
+    book_listeners_.push_back(listener);
+    for (auto& [symbol_id, order_book] : order_books_) {
+        order_book->add_listener(listener);
+    }
+}
+
+BookSnapshot OrderBookSimulator::snapshot_book(uint32_t symbol_id) const {
+    OrderBook* order_book = find_book(symbol_id);
+    if (!order_book) {
+        BookSnapshot empty;
+        empty.symbol_id = symbol_id;
+        return empty;
+    }
+    return order_book->snapshot();
+}
+
+void OrderBookSimulator::enable_trade_tapes(size_t capacity) {
+    std::unique_lock<std::shared_mutex> lock(books_mutex_);
+    if (tape_capacity_ || capacity == 0) {
+        return;
+    }
+    
+    tape_capacity_ = capacity;
+    for (auto& [symbol_id, order_book] : order_books_) {
+        auto& tape = tapes_[symbol_id];
+        tape = std::make_unique<TradeTape>(capacity);
+        order_book->add_listener(tape.get());
+    }
+}
+
+const TradeTape* OrderBookSimulator::get_trade_tape(uint32_t symbol_id) const {
     std::shared_lock<std::shared_mutex> lock(books_mutex_);
+    auto it = tapes_.find(symbol_id);
+    return it != tapes_.end() ? it->second.get() : nullptr;
+}
+
+PriceBands OrderBookSimulator::get_price_bands(uint32_t symbol_id) const {
+    OrderBook* order_book = find_book(symbol_id);
+    return order_book ? order_book->get_price_bands() : PriceBands{};
+}
+
+BookFeatures OrderBookSimulator::get_book_features(uint32_t symbol_id) const {
+    OrderBook* order_book = find_book(symbol_id);
+    return order_book ? order_book->get_features() : BookFeatures{};
+}
+
+void OrderBookSimulator::advance_time(uint64_t now_us) {
+    std::vector<OrderBook*> books;
+    {
+        std::shared_lock<std::shared_mutex> lock(books_mutex_);
+        books.reserve(order_books_.size());
+        for (const auto& [symbol_id, order_book] : order_books_) {
+            books.push_back(order_book.get());
+        }
+    }
     
-    auto it = order_books_.find(symbol_id);
-    if (it != order_books_.end()) {
-        it->second->register_market_data_callback(callback);
+    for (OrderBook* order_book : books) {
+        order_book->advance_time(now_us);
     }
 }
 
-void OrderBookSimulator::register_trade_callback(uint32_t symbol_id, 
-                                               std::function<void(const Trade&)> callback) {
+TopOfBook OrderBookSimulator::get_top_of_book(uint32_t symbol_id) const {
+    OrderBook* order_book = find_book(symbol_id);
+    return order_book ? order_book->get_top_of_book() : TopOfBook{};
+}
+
+uint32_t OrderBookSimulator::copy_levels(uint32_t symbol_id, Side side, std::pair<uint64_t, uint64_t>* out,
+                                         uint32_t depth) const {
+    OrderBook* order_book = find_book(symbol_id);
+    return order_book ? order_book->copy_levels(side, out, depth) : 0;
+}
+
+MatchSimulation OrderBookSimulator::simulate_match(uint32_t symbol_id, Side side, 
+                                                  uint64_t quantity, uint64_t limit_price) const {
     std::shared_lock<std::shared_mutex> lock(books_mutex_);
     
     auto it = order_books_.find(symbol_id);
     if (it != order_books_.end()) {
-        it->second->register_trade_callback(callback);
+        return it->second->simulate_match(side, quantity, limit_price);
+    }
+    
+    MatchSimulation result;
+    result.remaining_quantity = quantity;
+    return result;
+}
+
+PositionSnapshot OrderBookSimulator::mark_position(uint32_t account_id, uint32_t symbol_id,
+                                                   const PositionState& state) const {
+    PositionSnapshot snapshot;
+    snapshot.account_id = account_id;
+    snapshot.symbol_id = symbol_id;
+    snapshot.state = state;
+    
+    if (state.position == 0) {
+        return snapshot;
     }
+    
+    {
+        std::shared_lock<std::shared_mutex> lock(books_mutex_);
+        auto it = order_books_.find(symbol_id);
+        if (it != order_books_.end()) {
+            // Mark at the price the position could be closed at
+            TopOfBook top = it->second->get_top_of_book();
+            snapshot.mark_price = state.position > 0 ? top.best_bid_price : top.best_ask_price;
+            if (snapshot.mark_price == 0) {
+                snapshot.mark_price = it->second->get_last_trade_price();
+            }
+        }
+    }
+    
+    if (snapshot.mark_price != 0) {
+        snapshot.unrealized_pnl = (static_cast<double>(snapshot.mark_price) - state.average_cost) *
+                                  static_cast<double>(state.position);
+    }
+    return snapshot;
+}
+
+PositionSnapshot OrderBookSimulator::get_position(uint32_t account_id, uint32_t symbol_id) const {
+    PositionState state;
+    position_keeper_.get_position(account_id, symbol_id, state);
+    return mark_position(account_id, symbol_id, state);
+}
+
+std::vector<PositionSnapshot> OrderBookSimulator::get_account_positions(uint32_t account_id) const {
+    std::vector<PositionSnapshot> positions;
+    for (const auto& entry : position_keeper_.get_account_positions(account_id)) {
+        positions.push_back(mark_position(account_id, entry.first, entry.second));
+    }
+    return positions;
+}
+
+uint64_t OrderBookSimulator::register_market_data_callback(uint32_t symbol_id, 
+                                                         std::function<void(const MarketDataSnapshot&)> callback) {
+    // Subscribing before the first order creates the book
+    return get_or_create_book(symbol_id)->register_market_data_callback(std::move(callback));
+}
+
+void OrderBookSimulator::unregister_market_data_callback(uint32_t symbol_id, uint64_t token) {
+    if (OrderBook* order_book = find_book(symbol_id)) {
+        order_book->unregister_market_data_callback(token);
+    }
+}
+
+void OrderBookSimulator::register_trade_callback(uint32_t symbol_id, 
+                                               std::function<void(const Trade&)> callback) {
+    get_or_create_book(symbol_id)->register_trade_callback(callback);
 }
 
 OrderBookSimulator::PerformanceMetrics OrderBookSimulator::get_performance_metrics() const {
@@ -162,6 +890,8 @@ OrderBookSimulator::PerformanceMetrics OrderBookSimulator::get_performance_metri
     metrics.orders_processed = orders_processed_.load();
     metrics.total_volume = 0;
     metrics.trade_count = 0;
+    metrics.risk_rejects = risk_engine_.get_reject_count();
+    metrics.validation_rejects = validation_rejects_.load(std::memory_order_relaxed);
     
     // Aggregate metrics from all order books
     std::shared_lock<std::shared_mutex> lock(books_mutex_);
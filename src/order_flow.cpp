@@ -0,0 +1,113 @@
+#include "../include/order_flow.hpp"
+#include <algorithm>
+
+namespace lob {
+
+Xoshiro256ppX4::Xoshiro256ppX4(uint64_t seed, uint64_t stream) noexcept {
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+        uint64_t x = seed ^ ((stream * kLanes + lane) * 0xD1B54A32D192ED03ULL);
+        s0_[lane] = Xoshiro256pp::splitmix64(x);
+        s1_[lane] = Xoshiro256pp::splitmix64(x);
+        s2_[lane] = Xoshiro256pp::splitmix64(x);
+        s3_[lane] = Xoshiro256pp::splitmix64(x);
+    }
+}
+
+void Xoshiro256ppX4::fill(uint64_t* out, size_t count) noexcept {
+    for (size_t i = 0; i + kLanes <= count; i += kLanes) {
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            uint64_t sum = s0_[lane] + s3_[lane];
+            out[i + lane] = ((sum << 23) | (sum >> 41)) + s0_[lane];
+            
+            uint64_t t = s1_[lane] << 17;
+            s2_[lane] ^= s0_[lane];
+            s3_[lane] ^= s1_[lane];
+            s1_[lane] ^= s2_[lane];
+            s0_[lane] ^= s3_[lane];
+            s2_[lane] ^= t;
+            s3_[lane] = (s3_[lane] << 45) | (s3_[lane] >> 19);
+        }
+    }
+}
+
+OrderFlowGenerator::OrderFlowGenerator(const OrderFlowParams& params, uint64_t seed, uint64_t stream,
+                                       size_t batch_size)
+    : params_(params),
+      rng_(seed, stream),
+      current_price_(params.base_price),
+      min_price_(params.base_price > params.price_range ? params.base_price - params.price_range : 0),
+      max_price_(params.base_price + params.price_range),
+      limit_threshold_(static_cast<uint64_t>(params.limit_ratio * 2147483648.0)),
+      quantity_scale_(static_cast<double>(params.max_quantity - params.min_quantity + 1) / 4294967296.0),
+      random_words_((2 * batch_size + 3) / 4 * 4),
+      multipliers_(batch_size),
+      batch_(batch_size),
+      batch_index_(batch_size),
+      batch_size_(batch_size) {
+    // Keep the price band on the tick grid
+    params_.tick_size = std::max<uint64_t>(1, params_.tick_size);
+    params_.lot_size = std::max<uint64_t>(1, params_.lot_size);
+    min_price_ = (min_price_ + params_.tick_size - 1) / params_.tick_size * params_.tick_size;
+    max_price_ = max_price_ / params_.tick_size * params_.tick_size;
+}
+
+void OrderFlowGenerator::generate(OrderCommand* out, size_t count) noexcept {
+    const uint64_t* words = random_words_.data();
+    double* multipliers = multipliers_.data();
+    
+    for (size_t offset = 0; offset < count; offset += batch_size_) {
+        size_t n = std::min(batch_size_, count - offset);
+        OrderCommand* commands = out + offset;
+        
+        // Two words per order, rounded up to whole lanes
+        rng_.fill(random_words_.data(), (2 * n + 3) / 4 * 4);
+        
+        // Independent per-order fields: side, type, quantity, price multiplier
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t w0 = words[2 * i];
+            uint64_t w1 = words[2 * i + 1];
+            
+            Side side = static_cast<Side>(w0 >> 63);
+            bool is_limit = ((w0 >> 32) & 0x7FFFFFFFULL) < limit_threshold_;
+            double u = static_cast<double>(w1 >> 11) * (1.0 / 9007199254740992.0);
+            
+            commands[i].symbol_id = params_.symbol_id;
+            commands[i].side = side;
+            commands[i].order_type = is_limit ? OrderType::LIMIT : OrderType::MARKET;
+            commands[i].quantity = params_.min_quantity +
+                static_cast<uint64_t>(static_cast<double>(w0 & 0xFFFFFFFFULL) * quantity_scale_);
+            
+            // Buy orders slightly below the reference price, sells slightly above
+            multipliers[i] = (1.0 + (2.0 * u - 1.0) * params_.volatility) *
+                             (side == Side::BUY ? 0.999 : 1.001);
+        }
+        
+        // Round quantities to whole lots (skipped for unit lots)
+        if (params_.lot_size > 1) {
+            for (size_t i = 0; i < n; ++i) {
+                commands[i].quantity = std::max(params_.lot_size,
+                                                commands[i].quantity / params_.lot_size * params_.lot_size);
+            }
+        }
+        
+        // Sequential reference-price walk on the tick grid
+        const uint64_t tick = params_.tick_size;
+        uint64_t current_price = current_price_;
+        for (size_t i = 0; i < n; ++i) {
+            if (commands[i].order_type == OrderType::LIMIT) {
+                uint64_t price = static_cast<uint64_t>(current_price * multipliers[i]);
+                if (tick > 1) {
+                    price = price / tick * tick;
+                }
+                price = std::max(min_price_, std::min(max_price_, price));
+                commands[i].price = price;
+                current_price = price;
+            } else {
+                commands[i].price = 0;
+            }
+        }
+        current_price_ = current_price;
+    }
+}
+
+} // namespace lob
@@ -0,0 +1,116 @@
+#include "../include/limit_order_book.hpp"
+
+namespace lob {
+
+OrderStateStore::OrderStateStore() : chunks_(new std::atomic<Record*>[kMaxChunks]) {
+    for (size_t i = 0; i < kMaxChunks; ++i) {
+        chunks_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+OrderStateStore::~OrderStateStore() {
+    for (size_t i = 0; i < kMaxChunks; ++i) {
+        delete[] chunks_[i].load(std::memory_order_relaxed);
+    }
+}
+
+OrderStateStore::Record* OrderStateStore::record(uint64_t order_id) {
+    uint64_t chunk_index = order_id >> kChunkBits;
+    if (chunk_index >= kMaxChunks) {
+        return nullptr;
+    }
+    
+    Record* chunk = chunks_[chunk_index].load(std::memory_order_acquire);
+    if (!chunk) {
+        // Books for different symbols may race to create the same chunk
+        Record* created = new Record[kChunkSize];
+        if (chunks_[chunk_index].compare_exchange_strong(chunk, created, std::memory_order_acq_rel)) {
+            chunk = created;
+        } else {
+            delete[] created;
+        }
+    }
+    return &chunk[order_id & (kChunkSize - 1)];
+}
+
+bool OrderStateStore::get(uint64_t order_id, OrderState& state) const noexcept {
+    uint64_t chunk_index = order_id >> kChunkBits;
+    if (chunk_index >= kMaxChunks) {
+        return false;
+    }
+    
+    const Record* chunk = chunks_[chunk_index].load(std::memory_order_acquire);
+    if (!chunk) {
+        return false;
+    }
+    
+    OrderState published = chunk[order_id & (kChunkSize - 1)].published.load();
+    if (published.order_id != order_id) {
+        return false;
+    }
+    state = published;
+    return true;
+}
+
+void OrderStateStore::on_accept(const Order& order) {
+    Record* r = record(order.order_id);
+    if (!r) {
+        return;
+    }
+    
+    // A replace re-enters under the same id and starts a fresh record
+    r->working = OrderState{};
+    r->working.order_id = order.order_id;
+    r->working.remaining_quantity = order.remaining_quantity();
+    r->fill_notional = 0.0;
+    r->published.store(r->working);
+}
+
+void OrderStateStore::on_fill(const Order& order, uint64_t quantity, uint64_t price) {
+    Record* r = record(order.order_id);
+    if (!r) {
+        return;
+    }
+    
+    OrderState& state = r->working;
+    r->fill_notional += static_cast<double>(quantity) * static_cast<double>(price);
+    state.order_id = order.order_id;
+    state.filled_quantity = order.filled_quantity;
+    state.remaining_quantity = order.remaining_quantity();
+    state.average_price = r->fill_notional / static_cast<double>(order.filled_quantity);
+    state.status = order.is_filled() ? OrderStatus::FILLED : OrderStatus::PARTIALLY_FILLED;
+    r->published.store(state);
+}
+
+void OrderStateStore::on_cancel(const Order& order, uint64_t) {
+    Record* r = record(order.order_id);
+    if (!r) {
+        return;
+    }
+    
+    // Market orders that found no liquidity are reported as rejected
+    r->working.order_id = order.order_id;
+    r->working.remaining_quantity = 0;
+    r->working.status = order.status == OrderStatus::REJECTED ? OrderStatus::REJECTED : OrderStatus::CANCELLED;
+    r->published.store(r->working);
+}
+
+void OrderStateStore::on_restore(const Order& order) {
+    Record* r = record(order.order_id);
+    if (!r) {
+        return;
+    }
+    
+    // A snapshot keeps no fill prices; resting fills execute at the order's
+    // own price, so that stands in for the average
+    r->working = OrderState{};
+    r->working.order_id = order.order_id;
+    r->working.filled_quantity = order.filled_quantity;
+    r->working.remaining_quantity = order.remaining_quantity();
+    r->working.average_price = order.filled_quantity > 0 ? static_cast<double>(order.price) : 0.0;
+    r->working.status = order.status;
+    r->fill_notional = static_cast<double>(order.filled_quantity) * static_cast<double>(order.price);
+    r->published.store(r->working);
+}
+
+} // namespace lob
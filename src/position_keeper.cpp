@@ -0,0 +1,108 @@
+#include "../include/limit_order_book.hpp"
+#include <algorithm>
+
+namespace lob {
+
+PositionKeeper::PositionKeeper() : shards_(new Shard[kShards]) {}
+
+PositionKeeper::PositionRecord& PositionKeeper::find_or_insert(uint64_t key) {
+    Shard& shard = shards_[shard_index(key)];
+    {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.records.find(key);
+        if (it != shard.records.end()) {
+            return *it->second;
+        }
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto& record = shard.records[key];
+    if (!record) {
+        record = std::make_unique<PositionRecord>();
+    }
+    return *record;
+}
+
+void PositionKeeper::on_fill(const Order& order, uint64_t quantity, uint64_t price) {
+    if (order.account_id == 0 || quantity == 0) {
+        return;
+    }
+    
+    PositionRecord& record = find_or_insert(position_key(order.account_id, order.symbol_id));
+    PositionState& state = record.working;
+    
+    int64_t signed_quantity = order.side == Side::BUY ? static_cast<int64_t>(quantity)
+                                                      : -static_cast<int64_t>(quantity);
+    double fill_price = static_cast<double>(price);
+    
+    if (order.side == Side::BUY) {
+        state.bought_quantity += quantity;
+    } else {
+        state.sold_quantity += quantity;
+    }
+    
+    if (state.position == 0 || (state.position > 0) == (signed_quantity > 0)) {
+        // Opening or adding: volume-weighted average entry
+        double open = static_cast<double>(std::abs(state.position));
+        state.average_cost = (state.average_cost * open + fill_price * static_cast<double>(quantity)) /
+                             (open + static_cast<double>(quantity));
+        state.position += signed_quantity;
+    } else {
+        // Reducing: realize the closed part, flip opens at the fill price
+        int64_t closed = std::min<int64_t>(std::abs(state.position), static_cast<int64_t>(quantity));
+        double direction = state.position > 0 ? 1.0 : -1.0;
+        state.realized_pnl += static_cast<double>(closed) * (fill_price - state.average_cost) * direction;
+        state.position += signed_quantity;
+        
+        if (state.position == 0) {
+            state.average_cost = 0.0;
+        } else if ((state.position > 0) == (signed_quantity > 0)) {
+            state.average_cost = fill_price;
+        }
+    }
+    
+    record.published.store(state);
+}
+
+bool PositionKeeper::get_position(uint32_t account_id, uint32_t symbol_id, PositionState& state) const {
+    uint64_t key = position_key(account_id, symbol_id);
+    const Shard& shard = shards_[shard_index(key)];
+    
+    const PositionRecord* record = nullptr;
+    {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.records.find(key);
+        if (it == shard.records.end()) {
+            return false;
+        }
+        record = it->second.get();
+    }
+    
+    // Records are never freed, so the seqlock read needs no shard lock
+    state = record->published.load();
+    return true;
+}
+
+std::vector<std::pair<uint32_t, PositionState>> PositionKeeper::get_account_positions(uint32_t account_id) const {
+    std::vector<std::pair<uint32_t, const PositionRecord*>> records;
+    for (size_t i = 0; i < kShards; ++i) {
+        std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+        for (const auto& entry : shards_[i].records) {
+            if (static_cast<uint32_t>(entry.first >> 32) == account_id) {
+                records.emplace_back(static_cast<uint32_t>(entry.first), entry.second.get());
+            }
+        }
+    }
+    
+    std::sort(records.begin(), records.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    
+    std::vector<std::pair<uint32_t, PositionState>> positions;
+    positions.reserve(records.size());
+    for (const auto& entry : records) {
+        positions.emplace_back(entry.first, entry.second->published.load());
+    }
+    return positions;
+}
+
+} // namespace lob
@@ -6,7 +6,7 @@ namespace lob {
 void PriceLevel::add_order(std::shared_ptr<Order> order) {
     std::lock_guard<std::mutex> lock(level_mutex_);
     orders_.push_back(order);
-    total_quantity_.fetch_add(order->quantity);
+    total_quantity_.fetch_add(order->remaining_quantity());
 }
 
 void PriceLevel::remove_order(uint64_t order_id) {
@@ -18,7 +18,7 @@ void PriceLevel::remove_order(uint64_t order_id) {
         });
     
     if (it != orders_.end()) {
-        total_quantity_.fetch_sub((*it)->quantity);
+        total_quantity_.fetch_sub((*it)->remaining_quantity());
         orders_.erase(it);
     }
 }
@@ -37,11 +37,48 @@ std::shared_ptr<Order> PriceLevel::get_best_order() {
     return nullptr;
 }
 
+uint64_t PriceLevel::simulate_fills(uint64_t price, uint64_t quantity,
+                                    std::vector<SimulatedFill>& fills) const {
+    std::lock_guard<std::mutex> lock(level_mutex_);
+    
+    uint64_t filled = 0;
+    for (const auto& order : orders_) {
+        if (filled == quantity) {
+            break;
+        }
+        if (order->status == OrderStatus::FILLED || order->status == OrderStatus::CANCELLED) {
+            continue;
+        }
+        
+        uint64_t fill_quantity = std::min(quantity - filled, order->remaining_quantity());
+        if (fill_quantity > 0) {
+            fills.push_back({order->order_id, price, fill_quantity});
+            filled += fill_quantity;
+        }
+    }
+    
+    return filled;
+}
+
+void PriceLevel::reduce_quantity(uint64_t quantity) noexcept {
+    total_quantity_.fetch_sub(quantity);
+}
+
 size_t PriceLevel::get_order_count() const {
     std::lock_guard<std::mutex> lock(level_mutex_);
     return orders_.size();
 }
 
+void PriceLevel::copy_orders(std::vector<Order>& out) const {
+    std::lock_guard<std::mutex> lock(level_mutex_);
+    
+    for (const auto& order : orders_) {
+        if (order->status != OrderStatus::FILLED && order->status != OrderStatus::CANCELLED) {
+            out.push_back(*order);
+        }
+    }
+}
+
 bool PriceLevel::is_empty() const {
     return total_quantity_.load() == 0;
 }
@@ -0,0 +1,243 @@
+#include "../include/replay.hpp"
+#include <istream>
+#include <ostream>
+
+namespace lob {
+
+namespace {
+
+constexpr uint32_t kSnapshotMagic = 0x324B424C;    // "LBK2", orders with ClOrdIDs
+
+// Resting order fields; the session links are rebuilt by the engine
+struct SnapshotOrder {
+    uint64_t order_id;
+    uint64_t quantity;
+    uint64_t filled_quantity;
+    uint64_t price;
+    uint64_t stop_price;
+    uint64_t timestamp;
+    ClOrdId cl_ord_id;
+    uint32_t symbol_id;
+    uint32_t account_id;
+    uint32_t session_id;
+    Side side;
+    OrderType order_type;
+    OrderStatus status;
+};
+
+template <typename T>
+void put(std::ostream& out, const T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "raw snapshot field");
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool get(std::istream& in, T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "raw snapshot field");
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return static_cast<bool>(in);
+}
+
+} // namespace
+
+bool write_book_snapshot(std::ostream& out, const BookSnapshot& snapshot) {
+    put(out, kSnapshotMagic);
+    put(out, snapshot.symbol_id);
+    put(out, snapshot.sequence);
+    put(out, snapshot.clock_us);
+    put(out, snapshot.next_trade_id);
+    put(out, snapshot.total_volume);
+    put(out, snapshot.trade_count);
+    put(out, snapshot.last_trade_price);
+    put(out, snapshot.last_trade_quantity);
+    put(out, snapshot.market_protection);
+    put(out, snapshot.band_config);
+    put(out, snapshot.band_reference);
+    put(out, snapshot.bands);
+    put(out, snapshot.feature_config);
+    put(out, snapshot.features);
+    put(out, snapshot.feature_top);
+    put(out, snapshot.spread_variance);
+    put(out, snapshot.mid_variance);
+    put(out, static_cast<uint64_t>(snapshot.orders.size()));
+    for (const Order& order : snapshot.orders) {
+        put(out, SnapshotOrder{order.order_id, order.quantity, order.filled_quantity, order.price,
+                               order.stop_price, order.timestamp, order.cl_ord_id, order.symbol_id,
+                               order.account_id, order.session_id, order.side, order.order_type, order.status});
+    }
+    return static_cast<bool>(out);
+}
+
+bool read_book_snapshot(std::istream& in, BookSnapshot& snapshot) {
+    uint32_t magic = 0;
+    uint64_t count = 0;
+    if (!get(in, magic) || magic != kSnapshotMagic ||
+        !get(in, snapshot.symbol_id) || !get(in, snapshot.sequence) || !get(in, snapshot.clock_us) ||
+        !get(in, snapshot.next_trade_id) || !get(in, snapshot.total_volume) || !get(in, snapshot.trade_count) ||
+        !get(in, snapshot.last_trade_price) || !get(in, snapshot.last_trade_quantity) ||
+        !get(in, snapshot.market_protection) || !get(in, snapshot.band_config) ||
+        !get(in, snapshot.band_reference) || !get(in, snapshot.bands) || !get(in, snapshot.feature_config) ||
+        !get(in, snapshot.features) || !get(in, snapshot.feature_top) || !get(in, snapshot.spread_variance) ||
+        !get(in, snapshot.mid_variance) || !get(in, count)) {
+        return false;
+    }
+
+    snapshot.orders.clear();
+    snapshot.orders.reserve(static_cast<size_t>(std::min<uint64_t>(count, 1u << 20)));
+    for (uint64_t i = 0; i < count; ++i) {
+        SnapshotOrder fields;
+        if (!get(in, fields)) {
+            return false;
+        }
+        Order order(fields.order_id, fields.symbol_id, fields.side, fields.order_type, fields.quantity,
+                    fields.price, fields.stop_price, fields.account_id);
+        order.filled_quantity = fields.filled_quantity;
+        order.timestamp = fields.timestamp;
+        order.session_id = fields.session_id;
+        order.cl_ord_id = fields.cl_ord_id;
+        order.status = fields.status;
+        snapshot.orders.push_back(order);
+    }
+    return true;
+}
+
+ReplaySession::ReplaySession(JournalArchiveReader& archive, uint32_t symbol_id,
+                             std::function<void(OrderBook&)> configure)
+    : archive_(archive), symbol_id_(symbol_id), configure_(std::move(configure)) {
+    restart(nullptr);
+}
+
+void ReplaySession::add_snapshot(BookSnapshot snapshot) {
+    auto it = std::lower_bound(snapshots_.begin(), snapshots_.end(), snapshot.sequence,
+                               [](const BookSnapshot& s, uint64_t sequence) { return s.sequence < sequence; });
+    if (it != snapshots_.end() && it->sequence == snapshot.sequence) {
+        *it = std::move(snapshot);
+    } else {
+        snapshots_.insert(it, std::move(snapshot));
+    }
+}
+
+void ReplaySession::restart(const BookSnapshot* snapshot) {
+    book_ = std::make_unique<OrderBook>(symbol_id_);
+    if (configure_) {
+        configure_(*book_);
+    }
+    position_ = 0;
+    time_ = 0;
+    if (snapshot) {
+        book_->restore(*snapshot);
+        position_ = snapshot->sequence;
+        time_ = snapshot->clock_us;
+    }
+
+    // The block holding the first record after the snapshot
+    block_ = archive_.find_block(symbol_id_, position_ + 1);
+    block_loaded_ = false;
+    read_error_ = false;
+    since_checkpoint_ = 0;
+}
+
+bool ReplaySession::seek(uint64_t sequence) {
+    auto it = std::upper_bound(snapshots_.begin(), snapshots_.end(), sequence,
+                               [](uint64_t value, const BookSnapshot& s) { return value < s.sequence; });
+    const BookSnapshot* snapshot = it == snapshots_.begin() ? nullptr : &*(it - 1);
+
+    // Replay forward from here unless a snapshot gets closer
+    if (sequence < position_ || (snapshot && snapshot->sequence > position_)) {
+        restart(snapshot);
+    }
+
+    const JournalRecord* record;
+    while ((record = peek()) && record->sequence <= sequence) {
+        step();
+    }
+    return !read_error_;
+}
+
+bool ReplaySession::seek_to_time(uint64_t timestamp) {
+    // A symbol's clock never decreases along its sequence
+    auto it = std::upper_bound(snapshots_.begin(), snapshots_.end(), timestamp,
+                               [](uint64_t value, const BookSnapshot& s) { return value < s.clock_us; });
+    const BookSnapshot* snapshot = it == snapshots_.begin() ? nullptr : &*(it - 1);
+
+    if (timestamp < time_ || (snapshot && snapshot->sequence > position_)) {
+        restart(snapshot);
+    }
+
+    const JournalRecord* record;
+    while ((record = peek()) && record->timestamp <= timestamp) {
+        step();
+    }
+    return !read_error_;
+}
+
+const JournalRecord* ReplaySession::peek() {
+    while (block_ < archive_.block_count()) {
+        if (!block_loaded_) {
+            if (!archive_.read_block(block_, records_)) {
+                read_error_ = true;
+                return nullptr;
+            }
+            block_loaded_ = true;
+            index_ = 0;
+        }
+
+        // Skip other symbols and records already in the restored snapshot
+        for (; index_ < records_.size(); ++index_) {
+            const JournalRecord& record = records_[index_];
+            if (record.symbol_id == symbol_id_ && record.sequence > position_) {
+                return &record;
+            }
+        }
+
+        block_ = archive_.next_block(symbol_id_, block_);
+        block_loaded_ = false;
+    }
+    return nullptr;
+}
+
+const JournalRecord* ReplaySession::step() {
+    const JournalRecord* record = peek();
+    if (!record) {
+        return nullptr;
+    }
+
+    apply(*record);
+    position_ = record->sequence;
+    time_ = record->timestamp;
+    records_applied_++;
+    index_++;
+
+    if (checkpoint_interval_ && ++since_checkpoint_ >= checkpoint_interval_) {
+        BookSnapshot snapshot = book_->snapshot();
+        snapshot.sequence = position_;
+        add_snapshot(std::move(snapshot));
+        since_checkpoint_ = 0;
+    }
+    return record;
+}
+
+void ReplaySession::apply(const JournalRecord& record) {
+    switch (record.command) {
+        case JournalCommand::NEW_ORDER: {
+            auto order = std::make_shared<Order>(record.order_id, record.symbol_id, record.side, record.order_type,
+                                                 record.quantity, record.price, 0, record.account_id);
+            order->session_id = record.session_id;
+            order->cl_ord_id = record.cl_ord_id;
+            order->timestamp = record.timestamp;
+            book_->add_order(order);
+            break;
+        }
+        case JournalCommand::CANCEL:
+            book_->cancel_order(record.order_id);
+            break;
+        case JournalCommand::MODIFY:
+            book_->modify_order(record.order_id, record.quantity, record.price, record.timestamp, &record.cl_ord_id);
+            break;
+        case JournalCommand::ADVANCE_TIME:
+            book_->advance_time(record.timestamp);
+            break;
+    }
+}
+
+} // namespace lob
@@ -0,0 +1,232 @@
+#include "../include/replication.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lob {
+
+namespace {
+
+constexpr uint64_t kRingMagic = 0x474E4952424F4CULL;     // "LOBRING"
+
+uint64_t now_ns() noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+// Lives at the start of the mapping, followed by the slots
+struct JournalRing::Header {
+    uint64_t magic;
+    uint64_t capacity;
+    alignas(64) std::atomic<uint64_t> head;          // Written by the consumer
+    alignas(64) std::atomic<uint64_t> tail;          // Written by the producer
+    alignas(64) std::atomic<uint64_t> heartbeat_ns;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint32_t> closed;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring counters must be address-free");
+static_assert(std::is_trivially_copyable<JournalRing::Slot>::value, "slots are shared raw memory");
+
+JournalRing::JournalRing(int fd, void* base, size_t bytes)
+    : fd_(fd), base_(base), bytes_(bytes),
+      header_(static_cast<Header*>(base)),
+      slots_(reinterpret_cast<Slot*>(static_cast<char*>(base) + sizeof(Header))),
+      mask_(header_->capacity - 1) {}
+
+JournalRing::~JournalRing() {
+    munmap(base_, bytes_);
+    close(fd_);
+}
+
+std::unique_ptr<JournalRing> JournalRing::create(const std::string& path, size_t capacity) {
+    uint64_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    size_t bytes = sizeof(Header) + size * sizeof(Slot);
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        return nullptr;
+    }
+    void* base = ftruncate(fd, static_cast<off_t>(bytes)) == 0
+                     ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                     : MAP_FAILED;
+    if (base == MAP_FAILED) {
+        close(fd);
+        return nullptr;
+    }
+
+    Header* header = new (base) Header{};
+    header->capacity = size;
+    header->heartbeat_ns.store(now_ns(), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = kRingMagic;
+    return std::unique_ptr<JournalRing>(new JournalRing(fd, base, bytes));
+}
+
+std::unique_ptr<JournalRing> JournalRing::attach(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDWR);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info;
+    void* base = fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(Header)
+                     ? mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                     : MAP_FAILED;
+    if (base == MAP_FAILED) {
+        close(fd);
+        return nullptr;
+    }
+
+    // The size must match the capacity the primary wrote
+    const Header* header = static_cast<const Header*>(base);
+    size_t bytes = static_cast<size_t>(info.st_size);
+    if (header->magic != kRingMagic || header->capacity == 0 ||
+        (header->capacity & (header->capacity - 1)) != 0 ||
+        sizeof(Header) + header->capacity * sizeof(Slot) != bytes) {
+        munmap(base, bytes);
+        close(fd);
+        return nullptr;
+    }
+
+    auto ring = std::unique_ptr<JournalRing>(new JournalRing(fd, base, bytes));
+    ring->cached_tail_ = ring->header_->head.load(std::memory_order_acquire);
+    return ring;
+}
+
+bool JournalRing::try_push(const JournalRecord& record, uint64_t now_ns) noexcept {
+    uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+    if (tail - cached_head_ > mask_) {
+        cached_head_ = header_->head.load(std::memory_order_acquire);
+        if (tail - cached_head_ > mask_) {
+            return false;
+        }
+    }
+    slots_[tail & mask_] = Slot{record, now_ns};
+    header_->tail.store(tail + 1, std::memory_order_release);
+    header_->heartbeat_ns.store(now_ns, std::memory_order_relaxed);
+    return true;
+}
+
+void JournalRing::heartbeat(uint64_t now_ns) noexcept {
+    header_->heartbeat_ns.store(now_ns, std::memory_order_relaxed);
+}
+
+void JournalRing::count_drop() noexcept {
+    header_->dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void JournalRing::close_stream() noexcept {
+    header_->closed.store(1, std::memory_order_release);
+}
+
+bool JournalRing::try_pop(Slot& out) noexcept {
+    uint64_t head = header_->head.load(std::memory_order_relaxed);
+    if (cached_tail_ == head) {
+        cached_tail_ = header_->tail.load(std::memory_order_acquire);
+        if (cached_tail_ == head) {
+            return false;
+        }
+    }
+    out = slots_[head & mask_];
+    header_->head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+uint64_t JournalRing::heartbeat_ns() const noexcept {
+    return header_->heartbeat_ns.load(std::memory_order_relaxed);
+}
+
+uint64_t JournalRing::dropped() const noexcept {
+    return header_->dropped.load(std::memory_order_relaxed);
+}
+
+bool JournalRing::closed() const noexcept {
+    return header_->closed.load(std::memory_order_acquire) != 0;
+}
+
+void JournalPublisher::publish(const JournalRecord& record) {
+    SpinGuard guard(lock_);
+    if (!ring_.try_push(record, now_ns())) {
+        ring_.count_drop();
+    }
+}
+
+void JournalPublisher::heartbeat() {
+    ring_.heartbeat(now_ns());
+}
+
+HotStandby::HotStandby(JournalRing& ring, OrderBookSimulator& replica) : ring_(ring), replica_(replica) {}
+
+size_t HotStandby::poll(size_t max_records) {
+    JournalRing::Slot slot;
+    size_t applied = 0;
+    while (applied < max_records && ring_.try_pop(slot)) {
+        replica_.apply_journal_record(slot.record);
+        applied++;
+
+        uint64_t lag = now_ns() - slot.publish_ns;
+        last_lag_ns_.store(lag, std::memory_order_relaxed);
+        if (lag > max_lag_ns_.load(std::memory_order_relaxed)) {
+            max_lag_ns_.store(lag, std::memory_order_relaxed);
+        }
+    }
+    records_applied_.fetch_add(applied, std::memory_order_relaxed);
+    return applied;
+}
+
+void HotStandby::start(uint64_t failover_timeout_ns, std::function<void()> on_promote) {
+    if (running_.exchange(true) || promoted()) {
+        return;
+    }
+    thread_ = std::thread(&HotStandby::follow, this, failover_timeout_ns, std::move(on_promote));
+}
+
+void HotStandby::stop() {
+    running_.store(false, std::memory_order_release);
+    if (thread_.joinable() && thread_.get_id() != std::this_thread::get_id()) {
+        thread_.join();
+    }
+}
+
+bool HotStandby::primary_failed(uint64_t timeout_ns) const noexcept {
+    // Heartbeat first: one stored after now was read would wrap the difference
+    uint64_t heartbeat = ring_.heartbeat_ns();
+    uint64_t now = now_ns();
+    return ring_.closed() || (heartbeat < now && now - heartbeat > timeout_ns);
+}
+
+bool HotStandby::promote() {
+    stop();
+    poll();
+    promoted_.store(true, std::memory_order_release);
+    return !diverged();
+}
+
+void HotStandby::follow(uint64_t failover_timeout_ns, std::function<void()> on_promote) {
+    constexpr size_t kBatch = 256;
+
+    while (running_.load(std::memory_order_acquire)) {
+        if (poll(kBatch) > 0) {
+            continue;
+        }
+        if (failover_timeout_ns && primary_failed(failover_timeout_ns)) {
+            // Records published before the primary went quiet are still applied
+            poll();
+            promoted_.store(true, std::memory_order_release);
+            running_.store(false, std::memory_order_release);
+            if (on_promote) {
+                on_promote();
+            }
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+} // namespace lob
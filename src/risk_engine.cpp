@@ -0,0 +1,163 @@
+#include "../include/limit_order_book.hpp"
+
+namespace lob {
+
+namespace {
+
+size_t slot_hash(uint32_t account_id) noexcept {
+    // Shard index already consumed the low bits
+    return (static_cast<uint64_t>(account_id / RiskEngine::kShards) * 0x9E3779B97F4A7C15ULL) >> 32;
+}
+
+} // namespace
+
+RiskEngine::RiskEngine() : shards_(new Shard[kShards]) {
+    for (size_t i = 0; i < kShards; ++i) {
+        shards_[i].slots.resize(16);
+    }
+}
+
+RiskEngine::AccountState& RiskEngine::find_or_insert(Shard& shard, uint32_t account_id) {
+    // Keep load factor at or below one half
+    if ((shard.size + 1) * 2 > shard.slots.size()) {
+        std::vector<AccountState> old_slots(shard.slots.size() * 2);
+        old_slots.swap(shard.slots);
+        for (const auto& state : old_slots) {
+            if (state.occupied) {
+                size_t mask = shard.slots.size() - 1;
+                size_t i = slot_hash(state.account_id) & mask;
+                while (shard.slots[i].occupied) {
+                    i = (i + 1) & mask;
+                }
+                shard.slots[i] = state;
+            }
+        }
+    }
+    
+    size_t mask = shard.slots.size() - 1;
+    size_t i = slot_hash(account_id) & mask;
+    while (shard.slots[i].occupied) {
+        if (shard.slots[i].account_id == account_id) {
+            return shard.slots[i];
+        }
+        i = (i + 1) & mask;
+    }
+    
+    shard.slots[i].occupied = true;
+    shard.slots[i].account_id = account_id;
+    shard.size++;
+    return shard.slots[i];
+}
+
+const RiskEngine::AccountState* RiskEngine::find(const Shard& shard, uint32_t account_id) noexcept {
+    size_t mask = shard.slots.size() - 1;
+    size_t i = slot_hash(account_id) & mask;
+    while (shard.slots[i].occupied) {
+        if (shard.slots[i].account_id == account_id) {
+            return &shard.slots[i];
+        }
+        i = (i + 1) & mask;
+    }
+    return nullptr;
+}
+
+void RiskEngine::set_account_limits(uint32_t account_id, const RiskLimits& limits) {
+    Shard& shard = shards_[shard_index(account_id)];
+    SpinGuard guard(shard.lock);
+    
+    AccountState& state = find_or_insert(shard, account_id);
+    state.limits = limits;
+    state.has_limits = true;
+}
+
+RiskRejectReason RiskEngine::check_and_reserve(uint32_t account_id, OrderType type, uint64_t quantity,
+                                               uint64_t price, uint64_t reference_price,
+                                               uint64_t credit_notional) {
+    Shard& shard = shards_[shard_index(account_id)];
+    RiskRejectReason reason = RiskRejectReason::NONE;
+    
+    {
+        SpinGuard guard(shard.lock);
+        AccountState& state = find_or_insert(shard, account_id);
+        const RiskLimits& limits = state.has_limits ? state.limits : default_limits_;
+        
+        bool is_market = is_market_type(type);
+        uint64_t check_price = is_market ? reference_price : price;
+        uint64_t notional = quantity * check_price;
+        uint64_t open_after = state.open_notional - std::min(state.open_notional, credit_notional) + notional;
+        
+        // Fat-finger collar around the reference price (skipped until one exists)
+        uint64_t distance = price > reference_price ? price - reference_price : reference_price - price;
+        
+        if (limits.max_order_quantity && quantity > limits.max_order_quantity) {
+            reason = RiskRejectReason::MAX_ORDER_QUANTITY;
+        } else if (limits.price_collar_bps && !is_market && reference_price &&
+                   distance * 10000 > reference_price * limits.price_collar_bps) {
+            reason = RiskRejectReason::PRICE_COLLAR;
+        } else if (limits.max_order_notional && notional > limits.max_order_notional) {
+            reason = RiskRejectReason::MAX_ORDER_NOTIONAL;
+        } else if (limits.max_open_notional && open_after > limits.max_open_notional) {
+            reason = RiskRejectReason::OPEN_NOTIONAL_LIMIT;
+        } else if (!is_market) {
+            state.open_notional += notional;
+        }
+    }
+    
+    if (reason != RiskRejectReason::NONE) {
+        reject_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return reason;
+}
+
+void RiskEngine::release(uint32_t account_id, uint64_t notional) {
+    Shard& shard = shards_[shard_index(account_id)];
+    SpinGuard guard(shard.lock);
+    
+    AccountState& state = find_or_insert(shard, account_id);
+    state.open_notional -= std::min(state.open_notional, notional);
+}
+
+void RiskEngine::reserve(uint32_t account_id, uint64_t notional) {
+    Shard& shard = shards_[shard_index(account_id)];
+    SpinGuard guard(shard.lock);
+    
+    find_or_insert(shard, account_id).open_notional += notional;
+}
+
+uint64_t RiskEngine::get_open_notional(uint32_t account_id) const {
+    const Shard& shard = shards_[shard_index(account_id)];
+    SpinGuard guard(shard.lock);
+    
+    const AccountState* state = find(shard, account_id);
+    return state ? state->open_notional : 0;
+}
+
+void RiskEngine::on_convert(const Order& order) {
+    // Market types reserve nothing at entry; the rested remainder does
+    reserve(order.account_id, order.remaining_quantity() * order.price);
+}
+
+void RiskEngine::on_restore_drop(const Order& order) {
+    on_cancel(order, order.remaining_quantity());
+}
+
+void RiskEngine::on_restore(const Order& order) {
+    if (!is_market_type(order.order_type)) {
+        reserve(order.account_id, order.remaining_quantity() * order.price);
+    }
+}
+
+void RiskEngine::on_fill(const Order& order, uint64_t quantity, uint64_t) {
+    // Reservations are taken at the order's limit price
+    if (!is_market_type(order.order_type)) {
+        release(order.account_id, quantity * order.price);
+    }
+}
+
+void RiskEngine::on_cancel(const Order& order, uint64_t quantity) {
+    if (!is_market_type(order.order_type)) {
+        release(order.account_id, quantity * order.price);
+    }
+}
+
+} // namespace lob
@@ -0,0 +1,48 @@
+#include "../include/limit_order_book.hpp"
+
+namespace lob {
+
+void RollingPriceAverage::reset(uint64_t window_us) noexcept {
+    bucket_us_ = std::max<uint64_t>(1, window_us / kBuckets);
+    head_ = 0;
+    std::fill(std::begin(price_sum_), std::end(price_sum_), 0);
+    std::fill(std::begin(count_), std::end(count_), 0);
+    total_sum_ = 0;
+    total_count_ = 0;
+}
+
+void RollingPriceAverage::expire(uint64_t time_us) noexcept {
+    uint64_t bucket = time_us / bucket_us_;
+    
+    // Prints stamped behind the newest bucket are counted in it
+    if (bucket <= head_) {
+        return;
+    }
+    
+    uint64_t steps = std::min<uint64_t>(bucket - head_, kBuckets);
+    for (uint64_t i = 1; i <= steps; ++i) {
+        size_t slot = (head_ + i) % kBuckets;
+        total_sum_ -= price_sum_[slot];
+        total_count_ -= count_[slot];
+        price_sum_[slot] = 0;
+        count_[slot] = 0;
+    }
+    head_ = bucket;
+}
+
+void RollingPriceAverage::add(uint64_t time_us, uint64_t price) noexcept {
+    expire(time_us);
+    
+    size_t slot = head_ % kBuckets;
+    price_sum_[slot] += price;
+    count_[slot]++;
+    total_sum_ += price;
+    total_count_++;
+}
+
+uint64_t RollingPriceAverage::mean(uint64_t time_us) noexcept {
+    expire(time_us);
+    return total_count_ ? total_sum_ / total_count_ : 0;
+}
+
+} // namespace lob
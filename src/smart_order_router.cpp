@@ -0,0 +1,178 @@
+#include "../include/smart_order_router.hpp"
+
+namespace lob {
+
+SmartOrderRouter::SmartOrderRouter(const ConsolidatedBook& book, size_t num_threads, double latency_cost_per_us)
+    : book_(book), latency_cost_per_us_(latency_cost_per_us) {
+    // The calling thread acts as worker 0
+    for (size_t worker = 1; worker < num_threads; ++worker) {
+        workers_.emplace_back(&SmartOrderRouter::worker_thread_function, this, worker);
+    }
+}
+
+SmartOrderRouter::~SmartOrderRouter() {
+    {
+        std::lock_guard<std::mutex> lock(dispatch_mutex_);
+        shutdown_ = true;
+    }
+    dispatch_cv_.notify_all();
+    
+    for (auto& thread : workers_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+void SmartOrderRouter::set_venue_cost(uint32_t venue, double fee_per_unit, uint64_t latency_ns) {
+    if (venue < ConsolidatedBook::kMaxVenues) {
+        costs_[venue] = {fee_per_unit, latency_ns};
+    }
+}
+
+bool SmartOrderRouter::plan(uint32_t symbol_id, Side side, uint64_t quantity, uint64_t limit_price,
+                            RoutePlan& out) const {
+    out = RoutePlan{};
+    const uint32_t venues = static_cast<uint32_t>(book_.venue_count());
+    
+    // Snapshot every venue's opposite side; each is already in price
+    // order and a venue's cost is constant, so effective prices are too
+    VenueDepth depths[ConsolidatedBook::kMaxVenues];
+    uint32_t cursor[ConsolidatedBook::kMaxVenues] = {};
+    uint32_t child_of[ConsolidatedBook::kMaxVenues];
+    for (uint32_t venue = 0; venue < venues; ++venue) {
+        if (!book_.get_venue_depth(symbol_id, venue, depths[venue])) {
+            return false;
+        }
+        child_of[venue] = UINT32_MAX;
+    }
+    
+    uint64_t remaining = quantity;
+    while (remaining > 0) {
+        uint32_t best = UINT32_MAX;
+        double best_effective = 0.0;
+        for (uint32_t venue = 0; venue < venues; ++venue) {
+            const VenueDepth& depth = depths[venue];
+            uint32_t levels = side == Side::BUY ? depth.ask_count : depth.bid_count;
+            if (cursor[venue] == levels) {
+                continue;
+            }
+            uint64_t price = (side == Side::BUY ? depth.asks : depth.bids)[cursor[venue]].price;
+            if (limit_price && (side == Side::BUY ? price > limit_price : price < limit_price)) {
+                continue;
+            }
+            double effective = effective_price(venue, side, price);
+            if (best == UINT32_MAX || (side == Side::BUY ? effective < best_effective : effective > best_effective)) {
+                best = venue;
+                best_effective = effective;
+            }
+        }
+        if (best == UINT32_MAX) {
+            break;
+        }
+        
+        const auto& level = (side == Side::BUY ? depths[best].asks : depths[best].bids)[cursor[best]++];
+        uint64_t take = std::min(remaining, level.quantity);
+        if (child_of[best] == UINT32_MAX) {
+            child_of[best] = out.child_count++;
+            out.children[child_of[best]].venue = best;
+        }
+        ChildOrder& child = out.children[child_of[best]];
+        child.quantity += take;
+        child.limit_price = level.price;
+        out.planned_quantity += take;
+        out.expected_cost += best_effective * static_cast<double>(take);
+        remaining -= take;
+    }
+    
+    // Slowest venue first, so children arrive as close together as
+    // possible; a stable insertion sort keeps price priority among equals
+    for (uint32_t i = 1; i < out.child_count; ++i) {
+        ChildOrder child = out.children[i];
+        uint32_t j = i;
+        for (; j > 0 && costs_[out.children[j - 1].venue].latency_ns < costs_[child.venue].latency_ns; --j) {
+            out.children[j] = out.children[j - 1];
+        }
+        out.children[j] = child;
+    }
+    return out.child_count > 0;
+}
+
+bool SmartOrderRouter::route(uint32_t symbol_id, Side side, uint64_t quantity, uint64_t limit_price,
+                             RoutePlan& out, uint32_t account_id) {
+    if (!plan(symbol_id, side, quantity, limit_price, out)) {
+        return false;
+    }
+    
+    job_plan_ = &out;
+    job_symbol_ = symbol_id;
+    job_side_ = side;
+    job_account_ = account_id;
+    
+    if (!workers_.empty()) {
+        std::lock_guard<std::mutex> lock(dispatch_mutex_);
+        pending_ = workers_.size();
+        ++generation_;
+    }
+    dispatch_cv_.notify_all();
+    
+    submit_children(0);
+    
+    if (!workers_.empty()) {
+        std::unique_lock<std::mutex> lock(dispatch_mutex_);
+        done_cv_.wait(lock, [this] { return pending_ == 0; });
+    }
+    
+    for (uint32_t i = 0; i < out.child_count; ++i) {
+        out.filled_quantity += out.children[i].filled_quantity;
+    }
+    return true;
+}
+
+void SmartOrderRouter::worker_thread_function(size_t worker) {
+    uint64_t seen_generation = 0;
+    
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(dispatch_mutex_);
+            dispatch_cv_.wait(lock, [&] { return shutdown_ || generation_ != seen_generation; });
+            
+            if (shutdown_) {
+                break;
+            }
+            seen_generation = generation_;
+        }
+        
+        submit_children(worker);
+        
+        {
+            std::lock_guard<std::mutex> lock(dispatch_mutex_);
+            if (--pending_ == 0) {
+                done_cv_.notify_one();
+            }
+        }
+    }
+}
+
+void SmartOrderRouter::submit_children(size_t worker) {
+    const size_t stride = workers_.size() + 1;
+    
+    for (size_t i = worker; i < job_plan_->child_count; i += stride) {
+        ChildOrder& child = job_plan_->children[i];
+        OrderBookSimulator& venue = book_.venue(child.venue);
+        
+        child.order_id = venue.submit_order(job_symbol_, job_side_, OrderType::LIMIT, child.quantity,
+                                            child.limit_price, 0, job_account_);
+        if (child.order_id == 0) {
+            continue;
+        }
+        
+        // Immediate-or-cancel: depth may have moved since the plan. Cancel
+        // first so no fill can land after the state is read; a child that
+        // already filled just fails the cancel.
+        venue.cancel_order(child.order_id);
+        child.filled_quantity = venue.get_order_state(child.order_id).filled_quantity;
+    }
+}
+
+} // namespace lob
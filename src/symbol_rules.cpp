@@ -0,0 +1,99 @@
+#include "../include/limit_order_book.hpp"
+
+namespace lob {
+
+bool SymbolRules::add_tick_band(uint64_t floor, uint64_t tick_size) noexcept {
+    if (tick_size == 0) {
+        return false;
+    }
+    
+    if (floor == 0) {
+        band_tick[0] = tick_size;
+        return true;
+    }
+    
+    for (size_t i = 1; i < kMaxTickBands; ++i) {
+        if (band_floor[i] == UINT64_MAX) {
+            if (floor <= band_floor[i - 1]) {
+                return false;
+            }
+            band_floor[i] = floor;
+            band_tick[i] = tick_size;
+            return true;
+        }
+    }
+    return false;
+}
+
+ValidationResult SymbolRules::validate(OrderType type, uint64_t quantity, uint64_t price,
+                                       uint64_t reference_price) const noexcept {
+    bool priced = !is_market_type(type);
+    
+    // Dynamic band as a cross-multiplied distance check, skipped without a reference
+    uint64_t distance = price > reference_price ? price - reference_price : reference_price - price;
+    bool outside_dynamic = priced & (dynamic_band_bps != 0) & (reference_price != 0) &
+                           (distance * 10000 > reference_price * dynamic_band_bps);
+    
+    uint32_t failures = static_cast<uint32_t>((quantity == 0) | (quantity % lot_size != 0)) << 1 |
+                        static_cast<uint32_t>(priced & (price % tick_size_at(price) != 0)) << 2 |
+                        static_cast<uint32_t>(priced & ((price < min_price) | (price > max_price))) << 3 |
+                        static_cast<uint32_t>(outside_dynamic) << 4;
+    
+    // Lowest failing check wins: isolate its bit, then fold the bit's
+    // position out of it (portable count-trailing-zeros for bits 0-7)
+    uint32_t lowest = failures & (0u - failures);
+    uint32_t index = static_cast<uint32_t>((lowest & 0xAAu) != 0) |
+                     static_cast<uint32_t>((lowest & 0xCCu) != 0) << 1 |
+                     static_cast<uint32_t>((lowest & 0xF0u) != 0) << 2;
+    return static_cast<ValidationResult>(index);
+}
+
+uint64_t SymbolRules::ladder_levels() const noexcept {
+    return grid_prices_up_to(max_price);
+}
+
+uint64_t SymbolRules::ladder_index(uint64_t price) const noexcept {
+    uint64_t count = grid_prices_up_to(price);
+    return count > 0 ? count - 1 : 0;
+}
+
+uint64_t SymbolRules::grid_prices_up_to(uint64_t price) const noexcept {
+    // Count grid prices in [min_price, price] band by band
+    uint64_t count = 0;
+    for (size_t i = 0; i < kMaxTickBands && band_floor[i] <= price; ++i) {
+        uint64_t band_end = (i + 1 < kMaxTickBands && band_floor[i + 1] != UINT64_MAX) ? band_floor[i + 1] - 1 : UINT64_MAX;
+        uint64_t low = std::max(band_floor[i], min_price);
+        uint64_t high = std::min(band_end, price);
+        if (low > high) {
+            continue;
+        }
+        
+        uint64_t tick = band_tick[i];
+        uint64_t first = (low + tick - 1) / tick;
+        uint64_t last = high / tick;
+        if (last >= first) {
+            count += last - first + 1;
+        }
+    }
+    return count;
+}
+
+bool SymbolRulesTable::set(uint32_t symbol_id, const SymbolRules& rules) {
+    // validate() divides by the lot size and by every band's tick
+    if (symbol_id >= kMaxSymbols || rules.lot_size == 0) {
+        return false;
+    }
+    for (uint64_t tick : rules.band_tick) {
+        if (tick == 0) {
+            return false;
+        }
+    }
+    
+    if (symbol_id >= rules_.size()) {
+        rules_.resize(symbol_id + 1, default_rules_);
+    }
+    rules_[symbol_id] = rules;
+    return true;
+}
+
+} // namespace lob
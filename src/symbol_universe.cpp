@@ -0,0 +1,97 @@
+#include "../include/symbol_universe.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace lob {
+
+bool parse_symbol_universe(std::istream& input, std::vector<SymbolConfig>& symbols, std::string& error) {
+    std::vector<SymbolConfig> parsed;
+    std::string line;
+    size_t line_number = 0;
+    
+    while (std::getline(input, line)) {
+        line_number++;
+        
+        // Skip blank lines and comments
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        
+        std::vector<std::string> fields;
+        std::stringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, ',')) {
+            fields.push_back(field);
+        }
+        
+        if (fields.size() != 7 && fields.size() != 9) {
+            error = "line " + std::to_string(line_number) + ": expected 7 or 9 fields, got " +
+                    std::to_string(fields.size());
+            return false;
+        }
+        
+        SymbolConfig config;
+        try {
+            config.symbol_id = static_cast<uint32_t>(std::stoul(fields[0]));
+            config.base_price = std::stoull(fields[1]);
+            config.price_range = std::stoull(fields[2]);
+            config.min_quantity = std::stoull(fields[3]);
+            config.max_quantity = std::stoull(fields[4]);
+            config.volatility = std::stod(fields[5]);
+            config.orders_per_second = static_cast<uint32_t>(std::stoul(fields[6]));
+            if (fields.size() == 9) {
+                config.tick_size = std::stoull(fields[7]);
+                config.lot_size = std::stoull(fields[8]);
+            }
+        } catch (const std::exception&) {
+            error = "line " + std::to_string(line_number) + ": invalid number";
+            return false;
+        }
+        
+        if (config.tick_size == 0 || config.lot_size == 0 || config.orders_per_second == 0 ||
+            config.min_quantity > config.max_quantity || config.price_range >= config.base_price) {
+            error = "line " + std::to_string(line_number) + ": inconsistent symbol parameters";
+            return false;
+        }
+        
+        parsed.push_back(config);
+    }
+    
+    symbols = std::move(parsed);
+    return true;
+}
+
+bool load_symbol_universe(const std::string& path, std::vector<SymbolConfig>& symbols, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    return parse_symbol_universe(file, symbols, error);
+}
+
+std::vector<std::vector<size_t>> balance_symbol_groups(const std::vector<SymbolConfig>& symbols, size_t num_groups) {
+    num_groups = std::max<size_t>(1, std::min(num_groups, symbols.size()));
+    std::vector<std::vector<size_t>> groups(num_groups);
+    std::vector<uint64_t> load(num_groups, 0);
+    
+    std::vector<size_t> order(symbols.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return symbols[a].orders_per_second > symbols[b].orders_per_second;
+    });
+    
+    for (size_t index : order) {
+        size_t target = std::min_element(load.begin(), load.end()) - load.begin();
+        groups[target].push_back(index);
+        load[target] += symbols[index].orders_per_second;
+    }
+    
+    return groups;
+}
+
+} // namespace lob
@@ -0,0 +1,95 @@
+#include "../include/limit_order_book.hpp"
+
+namespace lob {
+
+TradeTape::TradeTape(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    mask_ = size - 1;
+    
+    words_ = std::make_unique<std::atomic<uint64_t>[]>(size * kWords);
+    for (size_t i = 0; i < size * kWords; ++i) {
+        words_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void TradeTape::on_trade(const Trade& trade) {
+    // Clock reads on different threads can step back slightly
+    last_timestamp_ = std::max(last_timestamp_, trade.timestamp);
+    
+    uint64_t position = count_.load(std::memory_order_relaxed);
+    claimed_.store(position + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    std::atomic<uint64_t>* slot = &words_[(position & mask_) * kWords];
+    slot[0].store(last_timestamp_, std::memory_order_relaxed);
+    slot[1].store(trade.trade_id, std::memory_order_relaxed);
+    slot[2].store(trade.price, std::memory_order_relaxed);
+    slot[3].store(trade.quantity, std::memory_order_relaxed);
+    
+    count_.store(position + 1, std::memory_order_release);
+}
+
+void TradeTape::read(uint64_t position, TapePrint& out) const noexcept {
+    const std::atomic<uint64_t>* slot = &words_[(position & mask_) * kWords];
+    out.timestamp = slot[0].load(std::memory_order_relaxed);
+    out.trade_id = slot[1].load(std::memory_order_relaxed);
+    out.price = slot[2].load(std::memory_order_relaxed);
+    out.quantity = slot[3].load(std::memory_order_relaxed);
+}
+
+size_t TradeTape::last(size_t count, TapePrint* out) const {
+    uint64_t end = total();
+    uint64_t begin = end - std::min<uint64_t>({count, end, capacity()});
+    
+    for (uint64_t position = begin; position < end; ++position) {
+        read(position, out[position - begin]);
+    }
+    
+    // Drop the oldest copies if the writer lapped them while copying
+    uint64_t valid = std::max(begin, std::min(oldest_valid(), end));
+    if (valid > begin) {
+        std::copy(out + (valid - begin), out + (end - begin), out);
+    }
+    return end - valid;
+}
+
+size_t TradeTape::between(uint64_t from_timestamp, uint64_t to_timestamp, TapePrint* out, size_t max_count) const {
+    while (true) {
+        uint64_t end = total();
+        uint64_t low = end > capacity() ? end - capacity() : 0;
+        
+        // First position with timestamp >= from_timestamp
+        uint64_t first = low;
+        uint64_t high = end;
+        uint64_t oldest_read = end;
+        while (first < high) {
+            uint64_t mid = first + (high - first) / 2;
+            oldest_read = std::min(oldest_read, mid);
+            if (timestamp_at(mid) < from_timestamp) {
+                first = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        
+        size_t copied = 0;
+        for (uint64_t position = first; position < end && copied < max_count; ++position) {
+            read(position, out[copied]);
+            if (out[copied].timestamp > to_timestamp) {
+                break;
+            }
+            copied++;
+        }
+        
+        // Retry if the writer lapped anything the search or copy read
+        oldest_read = std::min(oldest_read, first);
+        if (oldest_valid() <= oldest_read) {
+            return copied;
+        }
+    }
+}
+
+} // namespace lob
@@ -0,0 +1,190 @@
+#include "../include/vector_env.hpp"
+#include <algorithm>
+
+namespace lob {
+
+VectorEnv::VectorEnv(const Config& config)
+    : config_(config),
+      observation_size_(4 * config.depth + 2 * config.trade_history),
+      books_(nullptr) {
+    config_.num_threads = std::max<size_t>(1, std::min(config_.num_threads, config_.num_envs));
+
+    // Construct all books in a single contiguous block
+    books_ = book_allocator_.allocate(config_.num_envs);
+    for (size_t env = 0; env < config_.num_envs; ++env) {
+        new (&books_[env]) OrderBook(config_.symbol_id);
+        books_[env].register_trade_callback([this, env](const Trade& trade) {
+            if (config_.trade_history == 0) {
+                return;
+            }
+            uint64_t slot = trade_heads_[env]++ % config_.trade_history;
+            trade_history_[env * config_.trade_history + slot] = {trade.price, trade.quantity};
+        });
+    }
+
+    next_order_ids_.assign(config_.num_envs, 1);
+    trade_history_.assign(config_.num_envs * config_.trade_history, {0, 0});
+    trade_heads_.assign(config_.num_envs, 0);
+    observations_.assign(config_.num_envs * observation_size_, 0.0f);
+    step_results_.assign(config_.num_envs, EnvStepResult{});
+    level_scratch_.resize(config_.num_threads * std::max<uint32_t>(1, config_.depth));
+
+    // The calling thread acts as worker 0
+    for (size_t worker = 1; worker < config_.num_threads; ++worker) {
+        workers_.emplace_back(&VectorEnv::worker_thread_function, this, worker);
+    }
+}
+
+VectorEnv::~VectorEnv() {
+    {
+        std::lock_guard<std::mutex> lock(dispatch_mutex_);
+        shutdown_ = true;
+    }
+    dispatch_cv_.notify_all();
+
+    for (auto& thread : workers_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    for (size_t env = config_.num_envs; env > 0; --env) {
+        books_[env - 1].~OrderBook();
+    }
+    book_allocator_.deallocate(books_, config_.num_envs);
+}
+
+void VectorEnv::worker_thread_function(size_t worker) {
+    uint64_t seen_generation = 0;
+
+    while (true) {
+        std::function<void(size_t, size_t)> job;
+        {
+            std::unique_lock<std::mutex> lock(dispatch_mutex_);
+            dispatch_cv_.wait(lock, [&] { return shutdown_ || generation_ != seen_generation; });
+
+            if (shutdown_) {
+                break;
+            }
+
+            seen_generation = generation_;
+            job = job_;
+        }
+
+        size_t begin = config_.num_envs * worker / config_.num_threads;
+        size_t end = config_.num_envs * (worker + 1) / config_.num_threads;
+        for (size_t env = begin; env < end; ++env) {
+            job(worker, env);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(dispatch_mutex_);
+            if (--pending_ == 0) {
+                done_cv_.notify_one();
+            }
+        }
+    }
+}
+
+void VectorEnv::run_parallel(std::function<void(size_t, size_t)> job) {
+    if (!workers_.empty()) {
+        std::lock_guard<std::mutex> lock(dispatch_mutex_);
+        job_ = job;
+        pending_ = workers_.size();
+        ++generation_;
+    }
+    dispatch_cv_.notify_all();
+
+    // Worker 0's shard runs on the calling thread
+    size_t end = config_.num_envs / config_.num_threads;
+    for (size_t env = 0; env < end; ++env) {
+        job(0, env);
+    }
+
+    if (!workers_.empty()) {
+        std::unique_lock<std::mutex> lock(dispatch_mutex_);
+        done_cv_.wait(lock, [this] { return pending_ == 0; });
+    }
+}
+
+void VectorEnv::clear_env(size_t env) {
+    books_[env].reset();
+    next_order_ids_[env] = 1;
+    trade_heads_[env] = 0;
+    std::fill_n(trade_history_.begin() + env * config_.trade_history, config_.trade_history, TradePrint{0, 0});
+    std::fill_n(observations_.begin() + env * observation_size_, observation_size_, 0.0f);
+    step_results_[env] = EnvStepResult{};
+}
+
+void VectorEnv::reset() {
+    run_parallel([this](size_t, size_t env) { clear_env(env); });
+}
+
+void VectorEnv::reset_env(size_t env) {
+    clear_env(env);
+}
+
+void VectorEnv::step(const EnvAction* actions) {
+    run_parallel([this, actions](size_t worker, size_t env) {
+        apply_action(env, actions[env]);
+        write_observation(env, level_scratch_.data() + worker * std::max<uint32_t>(1, config_.depth));
+    });
+}
+
+void VectorEnv::apply_action(size_t env, const EnvAction& action) {
+    EnvStepResult& result = step_results_[env];
+    result = EnvStepResult{};
+
+    switch (action.kind) {
+        case EnvAction::Kind::SUBMIT: {
+            uint64_t order_id = next_order_ids_[env]++;
+            auto order = std::make_shared<Order>(order_id, config_.symbol_id, action.side,
+                                               action.order_type, action.quantity, action.price);
+            books_[env].add_order(order);
+            result.order_id = order_id;
+            result.filled_quantity = order->filled_quantity;
+            result.accepted = order->status != OrderStatus::REJECTED;
+            break;
+        }
+        case EnvAction::Kind::CANCEL:
+            result.accepted = books_[env].cancel_order(action.order_id);
+            break;
+        case EnvAction::Kind::NONE:
+        default:
+            break;
+    }
+}
+
+void VectorEnv::write_observation(size_t env, std::pair<uint64_t, uint64_t>* scratch) {
+    const uint32_t depth = config_.depth;
+    float* obs = observations_.data() + env * observation_size_;
+
+    // Top-N depth, zero padded
+    for (Side side : {Side::BUY, Side::SELL}) {
+        uint32_t count = books_[env].copy_levels(side, scratch, depth);
+        float* prices = obs + (side == Side::BUY ? 0 : 2 * depth);
+        float* quantities = prices + depth;
+        for (uint32_t i = 0; i < depth; ++i) {
+            prices[i] = i < count ? static_cast<float>(scratch[i].first) : 0.0f;
+            quantities[i] = i < count ? static_cast<float>(scratch[i].second) : 0.0f;
+        }
+    }
+
+    // Last trades, newest first
+    const uint32_t history = config_.trade_history;
+    float* trade_prices = obs + 4 * depth;
+    float* trade_quantities = trade_prices + history;
+    uint64_t head = trade_heads_[env];
+    for (uint32_t i = 0; i < history; ++i) {
+        if (i < head) {
+            const TradePrint& print = trade_history_[env * history + (head - 1 - i) % history];
+            trade_prices[i] = static_cast<float>(print.price);
+            trade_quantities[i] = static_cast<float>(print.quantity);
+        } else {
+            trade_prices[i] = 0.0f;
+            trade_quantities[i] = 0.0f;
+        }
+    }
+}
+
+} // namespace lob
@@ -1,9 +1,23 @@
 #include "../include/limit_order_book.hpp"
+#include "../include/vector_env.hpp"
+#include "../include/event_simulator.hpp"
+#include "../include/order_flow.hpp"
+#include "../include/flow_models.hpp"
+#include "../include/symbol_universe.hpp"
+#include "../include/smart_order_router.hpp"
+#include "../include/replay.hpp"
+#ifndef _WIN32
+#include "../include/replication.hpp"
+#include "../include/mapped_book_store.hpp"
+#endif
 #include <cassert>
+#include <cmath>
 #include <iostream>
 #include <vector>
 #include <thread>
 #include <chrono>
+#include <map>
+#include <sstream>
 
 using namespace lob;
 
@@ -204,6 +218,1639 @@ void test_market_data() {
     std::cout << "✓ Market data test passed\n";
 }
 
+void test_simulate_match() {
+    std::cout << "Testing dry-run match simulation...\n";
+    
+    OrderBook book(100);
+    
+    auto sell1 = std::make_shared<Order>(1, 100, Side::SELL, OrderType::LIMIT, 1000, 5000);
+    auto sell2 = std::make_shared<Order>(2, 100, Side::SELL, OrderType::LIMIT, 500, 5000);
+    auto sell3 = std::make_shared<Order>(3, 100, Side::SELL, OrderType::LIMIT, 1000, 5010);
+    auto sell4 = std::make_shared<Order>(4, 100, Side::SELL, OrderType::LIMIT, 1000, 5020);
+    book.add_order(sell1);
+    book.add_order(sell2);
+    book.add_order(sell3);
+    book.add_order(sell4);
+    
+    // Limited buy sweeps two levels and stops at the limit
+    auto result = book.simulate_match(Side::BUY, 2000, 5010);
+    assert(result.fills.size() == 3);
+    assert(result.fills[0].resting_order_id == 1);
+    assert(result.fills[2].resting_order_id == 3);
+    assert(result.fills[2].quantity == 500);
+    assert(result.filled_quantity == 2000);
+    assert(result.remaining_quantity == 0);
+    assert(result.levels_consumed == 2);
+    assert(result.average_price == (1500.0 * 5000 + 500.0 * 5010) / 2000);
+    
+    // Unlimited buy larger than the book leaves a remainder
+    result = book.simulate_match(Side::BUY, 5000);
+    assert(result.filled_quantity == 3500);
+    assert(result.remaining_quantity == 1500);
+    assert(result.levels_consumed == 3);
+    
+    // Nothing on the bid side
+    result = book.simulate_match(Side::SELL, 100);
+    assert(result.fills.empty());
+    assert(result.remaining_quantity == 100);
+    
+    // Resting orders are untouched
+    assert(sell1->filled_quantity == 0);
+    assert(sell3->filled_quantity == 0);
+    assert(book.get_trade_count() == 0);
+    assert(book.get_market_data().best_ask_quantity == 1500);
+    
+    std::cout << "✓ Simulate match test passed\n";
+}
+
+void test_vector_env() {
+    std::cout << "Testing vectorized environments...\n";
+    
+    VectorEnv::Config config;
+    config.num_envs = 64;
+    config.depth = 2;
+    config.trade_history = 2;
+    config.num_threads = 4;
+    VectorEnv env(config);
+    
+    assert(env.observation_size() == 4 * 2 + 2 * 2);
+    
+    // Every env rests a sell; odd envs also rest a higher sell
+    std::vector<EnvAction> actions(config.num_envs);
+    for (size_t i = 0; i < config.num_envs; ++i) {
+        actions[i].kind = EnvAction::Kind::SUBMIT;
+        actions[i].side = Side::SELL;
+        actions[i].quantity = 100 + i;
+        actions[i].price = 5000;
+    }
+    env.step(actions);
+    for (size_t i = 0; i < config.num_envs; ++i) {
+        actions[i].kind = (i % 2) ? EnvAction::Kind::SUBMIT : EnvAction::Kind::NONE;
+        actions[i].price = 5010;
+    }
+    env.step(actions);
+    
+    const float* obs = env.observation(3);
+    assert(obs[4] == 5000.0f && obs[5] == 5010.0f);   // ask prices
+    assert(obs[6] == 103.0f && obs[7] == 103.0f);     // ask quantities
+    assert(env.observation(2)[5] == 0.0f);            // even envs have one level
+    
+    // Buy 50 in every env: one print each, envs stay independent
+    for (size_t i = 0; i < config.num_envs; ++i) {
+        actions[i].kind = EnvAction::Kind::SUBMIT;
+        actions[i].side = Side::BUY;
+        actions[i].quantity = 50;
+        actions[i].price = 5000;
+    }
+    env.step(actions);
+    for (size_t i = 0; i < config.num_envs; ++i) {
+        const float* o = env.observation(i);
+        assert(o[8] == 5000.0f && o[10] == 50.0f);    // newest trade
+        assert(o[6] == static_cast<float>(50 + i));   // remaining best ask
+        assert(env.step_results()[i].filled_quantity == 50);
+        assert(env.book(i).get_trade_count() == 1);
+    }
+    
+    env.reset();
+    assert(env.book(7).get_trade_count() == 0);
+    assert(env.observation(7)[4] == 0.0f);
+    
+    std::cout << "✓ Vector env test passed\n";
+}
+
+void test_discrete_event_simulation() {
+    std::cout << "Testing discrete-event simulation...\n";
+    
+    // Events run in time order, ties in scheduling order
+    DiscreteEventSimulator des(7);
+    std::vector<int> sequence;
+    des.schedule_at(300, [&] { sequence.push_back(3); });
+    des.schedule_at(100, [&] { sequence.push_back(1); });
+    des.schedule_at(100, [&] { sequence.push_back(2); });
+    assert(des.run() == 3);
+    assert((sequence == std::vector<int>{1, 2, 3}));
+    assert(des.now() == 300);
+    
+    // A slow agent's order reaches the book after a fast agent's, even if sent first
+    auto run_race = [](uint64_t seed) {
+        DiscreteEventSimulator sim(seed);
+        OrderBook book(100);
+        uint32_t slow = sim.add_agent(LatencyModel::constant(5000), LatencyModel::constant(100));
+        uint32_t fast = sim.add_agent(LatencyModel::uniform(100, 200), LatencyModel::constant(100));
+        
+        auto resting = std::make_shared<Order>(1, 100, Side::SELL, OrderType::LIMIT, 100, 5000);
+        auto slow_buy = std::make_shared<Order>(2, 100, Side::BUY, OrderType::LIMIT, 100, 5000);
+        auto fast_buy = std::make_shared<Order>(3, 100, Side::BUY, OrderType::LIMIT, 100, 5000);
+        SimTime ack_time = 0;
+        
+        sim.schedule_at(0, [&] { book.add_order(resting); });
+        sim.schedule_at(10, [&] {
+            sim.send_to_exchange(slow, [&] { book.add_order(slow_buy); });
+            sim.send_to_exchange(fast, [&] { book.add_order(fast_buy); },
+                                 [&] { ack_time = sim.now(); });
+        });
+        sim.run_until(1000000);
+        
+        assert(fast_buy->is_filled());
+        assert(slow_buy->filled_quantity == 0);
+        assert(sim.now() == 1000000);
+        return ack_time;
+    };
+    
+    SimTime ack = run_race(11);
+    assert(ack >= 10 + 100 + 100 + 100 && ack <= 10 + 200 + 100 + 200);
+    assert(run_race(11) == ack);   // Deterministic under a seed
+    
+    std::cout << "✓ Discrete-event simulation test passed\n";
+}
+
+void test_order_flow_generator() {
+    std::cout << "Testing order flow generator...\n";
+    
+    OrderFlowParams params;
+    params.symbol_id = 101;
+    params.base_price = 3000;
+    params.price_range = 300;
+    params.min_quantity = 50;
+    params.max_quantity = 3000;
+    params.volatility = 0.03;
+    
+    constexpr size_t count = 10000;
+    std::vector<OrderCommand> a(count), b(count), c(count);
+    OrderFlowGenerator(params, 42, 0).generate(a.data(), count);
+    OrderFlowGenerator(params, 42, 0).generate(b.data(), count);
+    OrderFlowGenerator(params, 42, 1).generate(c.data(), count);
+    
+    size_t limits = 0;
+    size_t buys = 0;
+    size_t same_as_other_stream = 0;
+    for (size_t i = 0; i < count; ++i) {
+        assert(a[i].symbol_id == 101);
+        assert(a[i].quantity >= 50 && a[i].quantity <= 3000);
+        assert(a[i].quantity == b[i].quantity && a[i].price == b[i].price && a[i].side == b[i].side);
+        if (a[i].order_type == OrderType::LIMIT) {
+            assert(a[i].price >= 2700 && a[i].price <= 3300);
+            limits++;
+        } else {
+            assert(a[i].price == 0);
+        }
+        buys += (a[i].side == Side::BUY);
+        same_as_other_stream += (a[i].quantity == c[i].quantity);
+    }
+    
+    // Roughly 90/10 limit/market and balanced sides; streams are independent
+    assert(limits > count * 85 / 100 && limits < count * 95 / 100);
+    assert(buys > count * 45 / 100 && buys < count * 55 / 100);
+    assert(same_as_other_stream < count / 100);
+    
+    std::cout << "✓ Order flow generator test passed\n";
+}
+
+void test_flow_models() {
+    std::cout << "Testing Hawkes and queue-reactive flow models...\n";
+    
+    OrderFlowParams params;
+    params.symbol_id = 100;
+    params.base_price = 5000;
+    params.price_range = 500;
+    params.min_quantity = 100;
+    params.max_quantity = 100;
+    
+    // Count events in 100ms windows: Hawkes clusters, Poisson does not
+    auto dispersion = [](FlowModel& model, double& rate) {
+        constexpr SimTime window = 100000000;
+        constexpr size_t windows = 2000;
+        std::vector<double> counts(windows, 0.0);
+        BookTop top{4999, 100, 5001, 100};
+        SimTime now = 0;
+        while (true) {
+            now = model.next_event(now, top).time;
+            if (now >= window * windows) break;
+            counts[now / window] += 1.0;
+        }
+        double mean = 0.0, variance = 0.0;
+        for (double c : counts) mean += c;
+        mean /= windows;
+        for (double c : counts) variance += (c - mean) * (c - mean);
+        variance /= windows;
+        rate = mean * 10.0;
+        return variance / mean;
+    };
+    
+    double hawkes_rate = 0.0, poisson_rate = 0.0;
+    HawkesFlowModel hawkes(params, HawkesFlowModel::symmetric(1000.0, 0.7, 50.0), 42);
+    PoissonFlowModel poisson(params, 1000.0, 42);
+    double hawkes_dispersion = dispersion(hawkes, hawkes_rate);
+    double poisson_dispersion = dispersion(poisson, poisson_rate);
+    assert(hawkes_rate > 900.0 && hawkes_rate < 1100.0);
+    assert(poisson_rate > 950.0 && poisson_rate < 1050.0);
+    assert(poisson_dispersion < 1.3);
+    assert(hawkes_dispersion > 3.0);
+    
+    // Queue-reactive: inserts on a side slow down and cancels pick up as its queue grows
+    QueueReactiveFlowModel queue_reactive(params, QueueReactiveFlowModel::Parameters{}, 7);
+    auto bid_mix = [&](uint64_t bid_quantity, size_t& inserts, size_t& cancels) {
+        BookTop top{4999, bid_quantity, 5001, 500};
+        inserts = cancels = 0;
+        for (int i = 0; i < 20000; ++i) {
+            FlowEvent event = queue_reactive.next_event(0, top);
+            assert(event.time > 0);
+            if (event.command.side == Side::BUY && event.command.order_type == OrderType::LIMIT) {
+                (event.cancel ? cancels : inserts)++;
+            }
+        }
+    };
+    size_t thin_inserts, thin_cancels, thick_inserts, thick_cancels;
+    bid_mix(100, thin_inserts, thin_cancels);
+    bid_mix(5000, thick_inserts, thick_cancels);
+    assert(thick_inserts < thin_inserts / 2);
+    assert(thick_cancels > thin_cancels * 10);
+    
+    // Empty book: only inserts are possible
+    for (int i = 0; i < 1000; ++i) {
+        FlowEvent event = queue_reactive.next_event(0, BookTop{});
+        assert(!event.cancel && event.command.order_type == OrderType::LIMIT);
+    }
+    
+    std::cout << "✓ Flow models test passed\n";
+}
+
+void test_symbol_universe() {
+    std::cout << "Testing symbol universe loading and balancing...\n";
+    
+    std::istringstream config(
+        "# id,base,range,min,max,vol,rate[,tick,lot]\n"
+        "100,5000,500,100,5000,0.02,100\n"
+        "\n"
+        "103,25000,1000,10,100,0.015,25,5,10\n");
+    std::vector<SymbolConfig> symbols;
+    std::string error;
+    assert(parse_symbol_universe(config, symbols, error));
+    assert(symbols.size() == 2);
+    assert(symbols[0].symbol_id == 100 && symbols[0].tick_size == 1 && symbols[0].lot_size == 1);
+    assert(symbols[1].base_price == 25000 && symbols[1].tick_size == 5 && symbols[1].lot_size == 10);
+    
+    std::istringstream bad("100,5000,500,100,5000,0.02,100\n101,3000,300\n");
+    assert(!parse_symbol_universe(bad, symbols, error));
+    assert(error.find("line 2") != std::string::npos);
+    assert(symbols.size() == 2);   // Untouched on failure
+    
+    // Tick and lot sizes shape generated flow
+    OrderFlowParams params;
+    params.base_price = 25000;
+    params.price_range = 1000;
+    params.min_quantity = 10;
+    params.max_quantity = 100;
+    params.volatility = 0.015;
+    params.tick_size = 5;
+    params.lot_size = 10;
+    std::vector<OrderCommand> commands(2000);
+    OrderFlowGenerator(params, 1, 0, 64).generate(commands.data(), commands.size());
+    for (const auto& command : commands) {
+        assert(command.price % 5 == 0);
+        assert(command.quantity % 10 == 0 && command.quantity >= 10);
+    }
+    
+    // 10k symbols with skewed rates on a fixed number of threads
+    std::vector<SymbolConfig> universe;
+    uint64_t total_rate = 0;
+    for (uint32_t i = 0; i < 10000; ++i) {
+        uint32_t rate = 1 + (i % 97) * (i % 13);
+        universe.push_back({i, 5000, 500, 1, 100, 0.01, rate});
+        total_rate += rate;
+    }
+    auto groups = balance_symbol_groups(universe, 8);
+    assert(groups.size() == 8);
+    size_t assigned = 0;
+    for (const auto& group : groups) {
+        uint64_t load = 0;
+        for (size_t index : group) load += universe[index].orders_per_second;
+        assert(load > total_rate / 8 * 99 / 100 && load < total_rate / 8 * 101 / 100);
+        assigned += group.size();
+    }
+    assert(assigned == universe.size());
+    
+    std::cout << "✓ Symbol universe test passed\n";
+}
+
+void test_risk_checks() {
+    std::cout << "Testing pre-trade risk checks...\n";
+    
+    OrderBookSimulator simulator(1);
+    RiskLimits limits;
+    limits.max_order_quantity = 1000;
+    limits.max_order_notional = 4000000;
+    limits.max_open_notional = 6000000;
+    limits.price_collar_bps = 500;   // 5%
+    simulator.set_risk_limits(limits);
+    
+    constexpr uint32_t symbol = 100;
+    constexpr uint32_t account = 7;
+    const RiskEngine& risk = simulator.get_risk_engine();
+    
+    // Size and notional limits
+    assert(simulator.submit_order(symbol, Side::SELL, OrderType::LIMIT, 1001, 5000, 0, account) == 0);
+    assert(simulator.submit_order(symbol, Side::SELL, OrderType::LIMIT, 900, 5000, 0, account) == 0);
+    
+    // Resting orders reserve open notional up to the account limit
+    uint64_t sell1 = simulator.submit_order(symbol, Side::SELL, OrderType::LIMIT, 600, 5000, 0, account);
+    uint64_t sell2 = simulator.submit_order(symbol, Side::SELL, OrderType::LIMIT, 500, 5100, 0, account);
+    assert(sell1 != 0 && sell2 != 0);
+    assert(risk.get_open_notional(account) == 600 * 5000 + 500 * 5100);
+    assert(simulator.submit_order(symbol, Side::SELL, OrderType::LIMIT, 100, 5100, 0, account) == 0);
+    
+    // Other accounts are independent
+    assert(simulator.submit_order(symbol, Side::BUY, OrderType::LIMIT, 200, 5000, 0, 8) != 0);
+    assert(risk.get_open_notional(account) == 400 * 5000 + 500 * 5100);
+    assert(risk.get_open_notional(8) == 0);
+    
+    // Cancel releases the remainder
+    assert(simulator.cancel_order(sell2));
+    assert(risk.get_open_notional(account) == 400 * 5000);
+    
+    // Replace is checked with the original's exposure credited
+    assert(simulator.modify_order(sell1, 800, 5000));
+    assert(risk.get_open_notional(account) == 800 * 5000);
+    
+    // Collar around the last trade price (5000)
+    assert(simulator.submit_order(symbol, Side::BUY, OrderType::LIMIT, 10, 4700, 0, 9) == 0);
+    assert(simulator.submit_order(symbol, Side::BUY, OrderType::LIMIT, 10, 4800, 0, 9) != 0);
+    
+    // Per-account override
+    RiskLimits tight;
+    tight.max_order_quantity = 5;
+    simulator.set_account_risk_limits(9, tight);
+    assert(simulator.submit_order(symbol, Side::BUY, OrderType::LIMIT, 10, 4800, 0, 9) == 0);
+    
+    auto metrics = simulator.get_performance_metrics();
+    assert(metrics.risk_rejects == 5);
+    
+    std::cout << "✓ Risk checks test passed\n";
+}
+
+void test_positions() {
+    std::cout << "Testing position and P&L tracking...\n";
+    
+    OrderBookSimulator simulator(1);
+    constexpr uint32_t symbol = 100;
+    
+    // Account 1 buys 100 @ 5000 and 100 @ 5100
+    simulator.submit_order(symbol, Side::SELL, OrderType::LIMIT, 100, 5000, 0, 2);
+    simulator.submit_order(symbol, Side::BUY, OrderType::LIMIT, 100, 5000, 0, 1);
+    simulator.submit_order(symbol, Side::SELL, OrderType::LIMIT, 100, 5100, 0, 3);
+    simulator.submit_order(symbol, Side::BUY, OrderType::LIMIT, 100, 5100, 0, 1);
+    
+    PositionSnapshot position = simulator.get_position(1, symbol);
+    assert(position.state.position == 200);
+    assert(position.state.average_cost == 5050.0);
+    assert(position.state.realized_pnl == 0.0);
+    
+    // Selling 250 into a 5200 bid closes the long and flips short 50
+    simulator.submit_order(symbol, Side::BUY, OrderType::LIMIT, 250, 5200, 0, 3);
+    simulator.submit_order(symbol, Side::SELL, OrderType::LIMIT, 250, 5200, 0, 1);
+    
+    position = simulator.get_position(1, symbol);
+    assert(position.state.position == -50);
+    assert(position.state.average_cost == 5200.0);
+    assert(position.state.realized_pnl == 200.0 * 150.0);
+    assert(position.state.bought_quantity == 200 && position.state.sold_quantity == 250);
+    
+    PositionSnapshot counterparty = simulator.get_position(3, symbol);
+    assert(counterparty.state.position == 150);
+    assert(counterparty.state.realized_pnl == -100.0 * 100.0);
+    
+    // Marks come from the lock-free top of book
+    simulator.submit_order(symbol, Side::BUY, OrderType::LIMIT, 10, 5150, 0, 4);
+    simulator.submit_order(symbol, Side::SELL, OrderType::LIMIT, 10, 5300, 0, 4);
+    
+    position = simulator.get_position(1, symbol);
+    assert(position.mark_price == 5300);
+    assert(position.unrealized_pnl == -50.0 * 100.0);
+    counterparty = simulator.get_position(3, symbol);
+    assert(counterparty.mark_price == 5150);
+    assert(counterparty.unrealized_pnl == 150.0 * -50.0);
+    
+    assert(simulator.get_account_positions(1).size() == 1);
+    assert(simulator.get_account_positions(99).empty());
+    assert(simulator.get_position(99, symbol).state.position == 0);
+    
+    // Direct book read of the published BBO
+    OrderBook book(1);
+    book.add_order(std::make_shared<Order>(1, 1, Side::BUY, OrderType::LIMIT, 30, 990));
+    book.add_order(std::make_shared<Order>(2, 1, Side::SELL, OrderType::LIMIT, 40, 1010));
+    TopOfBook top = book.get_top_of_book();
+    assert(top.best_bid_price == 990 && top.best_bid_quantity == 30);
+    assert(top.best_ask_price == 1010 && top.best_ask_quantity == 40);
+    assert(book.cancel_order(1));
+    assert(book.get_top_of_book().best_bid_price == 0);
+    
+    std::cout << "✓ Position tracking test passed\n";
+}
+
+void test_client_order_ids() {
+    std::cout << "Testing client order id mapping...\n";
+    
+    ClOrdId a, b;
+    assert(ClOrdId::from_string("ORD-0001", a));
+    assert(ClOrdId::from_string("ORD-0001", b));
+    assert(a == b && a.hash() == b.hash());
+    assert(a.view() == "ORD-0001");
+    assert(!ClOrdId::from_string("", a));
+    assert(!ClOrdId::from_string(std::string(ClOrdId::kMaxLength + 1, 'x'), a));
+    
+    // Index grows past its initial capacity
+    ClientOrderIndex index;
+    for (uint64_t i = 1; i <= 1000; ++i) {
+        assert(ClOrdId::from_string("C" + std::to_string(i), a));
+        assert(index.insert(a, i, 7));
+    }
+    assert(ClOrdId::from_string("C500", a));
+    assert(!index.insert(a, 2000, 7));
+    assert(index.find(a)->order_id == 500);
+    assert(index.size() == 1000);
+    
+    OrderBookSimulator simulator(1);
+    constexpr uint32_t symbol = 100;
+    
+    uint64_t order_id = simulator.submit_client_order(1, "BUY-1", symbol, Side::BUY, OrderType::LIMIT, 100, 5000);
+    assert(order_id != 0);
+    assert(simulator.find_client_order(1, "BUY-1") == order_id);
+    
+    // ClOrdIDs are scoped per session and unique within one
+    assert(simulator.submit_client_order(1, "BUY-1", symbol, Side::BUY, OrderType::LIMIT, 100, 5000) == 0);
+    assert(simulator.submit_client_order(2, "BUY-1", symbol, Side::BUY, OrderType::LIMIT, 100, 4990) != 0);
+    assert(simulator.find_client_order(3, "BUY-1") == 0);
+    
+    // Amend assigns a new ClOrdID to the same engine order
+    assert(simulator.modify_client_order(1, "BUY-1", "BUY-2", 150, 5010));
+    assert(simulator.find_client_order(1, "BUY-2") == order_id);
+    assert(!simulator.modify_client_order(1, "BUY-2", "BUY-1", 150, 5010));
+    auto bids = simulator.get_bid_levels(symbol, 1);
+    assert(bids.size() == 1 && bids[0].first == 5010 && bids[0].second == 150);
+    
+    assert(simulator.cancel_client_order(1, "BUY-2"));
+    assert(!simulator.cancel_client_order(1, "BUY-2"));
+    assert(!simulator.cancel_client_order(1, "UNKNOWN"));
+    assert(simulator.get_bid_levels(symbol, 1)[0].first == 4990);
+    
+    std::cout << "✓ Client order id test passed\n";
+}
+
+void test_order_state() {
+    std::cout << "Testing order state queries...\n";
+    
+    OrderBookSimulator simulator(1);
+    constexpr uint32_t symbol = 100;
+    
+    uint64_t sell = simulator.submit_order(symbol, Side::SELL, OrderType::LIMIT, 100, 5000);
+    OrderState state = simulator.get_order_state(sell);
+    assert(state.order_id == sell && state.status == OrderStatus::NEW);
+    assert(state.remaining_quantity == 100 && state.filled_quantity == 0);
+    
+    uint64_t buy = simulator.submit_order(symbol, Side::BUY, OrderType::LIMIT, 60, 5000);
+    state = simulator.get_order_state(sell);
+    assert(state.status == OrderStatus::PARTIALLY_FILLED);
+    assert(state.filled_quantity == 60 && state.remaining_quantity == 40);
+    assert(state.average_price == 5000.0);
+    assert(simulator.get_order_state(buy).status == OrderStatus::FILLED);
+    
+    // Average price across fills at different levels
+    simulator.submit_order(symbol, Side::SELL, OrderType::LIMIT, 100, 5100);
+    uint64_t sweep = simulator.submit_order(symbol, Side::BUY, OrderType::LIMIT, 90, 5200);
+    state = simulator.get_order_state(sweep);
+    assert(state.status == OrderStatus::FILLED && state.filled_quantity == 90);
+    assert(state.average_price == (40.0 * 5000 + 50.0 * 5100) / 90.0);
+    
+    // Cancel keeps the executed quantity
+    uint64_t resting = simulator.submit_order(symbol, Side::BUY, OrderType::LIMIT, 30, 4900);
+    assert(simulator.cancel_order(resting));
+    state = simulator.get_order_state(resting);
+    assert(state.status == OrderStatus::CANCELLED && state.remaining_quantity == 0);
+    
+    // A replace restarts the record under the same id
+    uint64_t amended = simulator.submit_order(symbol, Side::BUY, OrderType::LIMIT, 30, 4900);
+    assert(simulator.modify_order(amended, 70, 4950));
+    state = simulator.get_order_state(amended);
+    assert(state.status == OrderStatus::NEW && state.remaining_quantity == 70);
+    
+    // Market orders with no liquidity are rejected
+    uint64_t market = simulator.submit_order(symbol + 1, Side::BUY, OrderType::MARKET, 10, 0);
+    assert(simulator.get_order_state(market).status == OrderStatus::REJECTED);
+    
+    assert(simulator.get_order_state(999999).order_id == 0);
+    assert(simulator.get_order_state(uint64_t(1) << 62).order_id == 0);
+    
+    std::cout << "✓ Order state test passed\n";
+}
+
+void test_execution_reports() {
+    std::cout << "Testing execution report streams...\n";
+    
+    SpscRing<uint64_t> ring(3);
+    assert(ring.capacity() == 4);
+    for (uint64_t i = 0; i < 4; ++i) {
+        assert(ring.try_push(i));
+    }
+    assert(!ring.try_push(4));
+    uint64_t values[8];
+    assert(ring.pop_batch(values, 3) == 3 && values[2] == 2);
+    assert(ring.try_push(4) && ring.size() == 2);
+    
+    OrderBookSimulator simulator(1);
+    constexpr uint32_t symbol = 100;
+    assert(simulator.open_session(1, 64));
+    assert(!simulator.open_session(1));
+    assert(!simulator.open_session(0));
+    
+    uint64_t sell = simulator.submit_client_order(1, "S1", symbol, Side::SELL, OrderType::LIMIT, 100, 5000);
+    uint64_t buy = simulator.submit_client_order(2, "B1", symbol, Side::BUY, OrderType::LIMIT, 40, 5000);
+    assert(simulator.modify_client_order(1, "S1", "S2", 80, 5000));
+    assert(simulator.cancel_client_order(1, "S2"));
+    
+    // Anonymous flow never reaches a session
+    simulator.submit_order(symbol, Side::BUY, OrderType::LIMIT, 10, 4000);
+    
+    ExecutionReport reports[16];
+    size_t count = simulator.poll_execution_reports(1, reports, 16);
+    assert(count == 4);
+    assert(reports[0].type == ExecType::ACK && reports[0].order_id == sell && reports[0].leaves_quantity == 100);
+    assert(reports[1].type == ExecType::PARTIAL_FILL && reports[1].last_quantity == 40);
+    assert(reports[1].last_price == 5000 && reports[1].leaves_quantity == 60);
+    assert(reports[2].type == ExecType::REPLACE && reports[2].leaves_quantity == 80);
+    assert(reports[3].type == ExecType::CANCEL && reports[3].leaves_quantity == 0);
+    assert(simulator.poll_execution_reports(1, reports, 16) == 0);
+    
+    count = simulator.poll_execution_reports(2, reports, 16);
+    assert(count == 2);
+    assert(reports[0].type == ExecType::ACK && reports[0].order_id == buy);
+    assert(reports[1].type == ExecType::FILL && reports[1].cumulative_quantity == 40);
+    
+    // Market order with nothing to hit
+    simulator.submit_client_order(2, "M1", symbol + 1, Side::BUY, OrderType::MARKET, 10, 0);
+    count = simulator.poll_execution_reports(2, reports, 16);
+    assert(count == 2 && reports[1].type == ExecType::REJECT);
+    
+    // Overflow is counted, never blocks matching
+    assert(simulator.open_session(3, 2));
+    for (int i = 0; i < 3; ++i) {
+        simulator.submit_client_order(3, "Q" + std::to_string(i), symbol, Side::BUY, OrderType::LIMIT, 1, 4000);
+    }
+    assert(simulator.get_dropped_reports(3) == 1);
+    assert(simulator.poll_execution_reports(3, reports, 16) == 2);
+    
+    std::cout << "✓ Execution report test passed\n";
+}
+
+void test_mass_quote() {
+    std::cout << "Testing mass quotes...\n";
+    
+    OrderBookSimulator simulator(1);
+    constexpr uint32_t symbol_a = 100;
+    constexpr uint32_t symbol_b = 200;
+    constexpr uint32_t maker = 5;
+    
+    std::vector<QuoteEntry> quotes = {
+        {symbol_a, Side::BUY, 4990, 100}, {symbol_a, Side::BUY, 4980, 200},
+        {symbol_a, Side::SELL, 5010, 100}, {symbol_a, Side::SELL, 5020, 200},
+        {symbol_b, Side::BUY, 990, 50}, {symbol_b, Side::SELL, 1010, 50}
+    };
+    assert(simulator.mass_quote(maker, quotes.data(), quotes.size(), 11));
+    assert(simulator.get_bid_levels(symbol_a).size() == 2);
+    assert(simulator.get_ask_levels(symbol_b)[0].first == 1010);
+    
+    int updates = 0;
+    simulator.register_market_data_callback(symbol_a, [&](const MarketDataSnapshot&) { updates++; });
+    
+    // Requote shifts every level; one market data update per book
+    quotes = {
+        {symbol_a, Side::BUY, 4995, 100}, {symbol_a, Side::SELL, 5005, 100},
+        {symbol_b, Side::BUY, 995, 50}, {symbol_b, Side::SELL, 1005, 50}
+    };
+    assert(simulator.mass_quote(maker, quotes.data(), quotes.size(), 11));
+    assert(updates == 1);
+    auto bids = simulator.get_bid_levels(symbol_a);
+    assert(bids.size() == 1 && bids[0].first == 4995 && bids[0].second == 100);
+    auto asks = simulator.get_ask_levels(symbol_b);
+    assert(asks.size() == 1 && asks[0].first == 1005);
+    
+    // Quotes trade like any resting order
+    simulator.submit_order(symbol_a, Side::SELL, OrderType::LIMIT, 40, 4995);
+    assert(simulator.get_bid_levels(symbol_a)[0].second == 60);
+    
+    // A leg failing risk leaves the previous quotes in place
+    RiskLimits limits;
+    limits.max_order_quantity = 500;
+    simulator.set_account_risk_limits(11, limits);
+    quotes = {{symbol_a, Side::BUY, 4996, 100}, {symbol_b, Side::SELL, 1004, 1000}};
+    assert(!simulator.mass_quote(maker, quotes.data(), quotes.size(), 11));
+    assert(simulator.get_bid_levels(symbol_a)[0].first == 4995);
+    assert(simulator.get_risk_engine().get_open_notional(11) == 60 * 4995 + 100 * 5005 + 50 * 995 + 50 * 1005);
+    
+    // Zero quantity pulls a symbol
+    quotes = {{symbol_b, Side::BUY, 0, 0}};
+    assert(simulator.mass_quote(maker, quotes.data(), quotes.size(), 11));
+    assert(simulator.get_bid_levels(symbol_b).empty() && simulator.get_ask_levels(symbol_b).empty());
+    assert(simulator.get_ask_levels(symbol_a).size() == 1);
+    
+    assert(!simulator.mass_quote(0, quotes.data(), quotes.size()));
+    
+    std::cout << "✓ Mass quote test passed\n";
+}
+
+void test_cancel_on_disconnect() {
+    std::cout << "Testing cancel-on-disconnect...\n";
+    
+    OrderBookSimulator simulator(1);
+    constexpr uint32_t symbol_a = 100;
+    constexpr uint32_t symbol_b = 200;
+    
+    for (int i = 0; i < 5; ++i) {
+        simulator.submit_client_order(1, "A" + std::to_string(i), symbol_a, Side::BUY, OrderType::LIMIT, 10, 4990 - i);
+        simulator.submit_client_order(1, "B" + std::to_string(i), symbol_b, Side::SELL, OrderType::LIMIT, 10, 1010 + i);
+    }
+    simulator.submit_client_order(2, "X", symbol_a, Side::BUY, OrderType::LIMIT, 10, 4980);
+    assert(simulator.get_live_order_count(1) == 10);
+    
+    // Fills, cancels and replaces keep the list current
+    simulator.submit_order(symbol_a, Side::SELL, OrderType::LIMIT, 10, 4990);
+    assert(simulator.cancel_client_order(1, "B0"));
+    assert(simulator.modify_client_order(1, "B1", "B1a", 20, 1011));
+    assert(simulator.get_live_order_count(1) == 8);
+    
+    int updates_a = 0;
+    simulator.register_market_data_callback(symbol_a, [&](const MarketDataSnapshot&) { updates_a++; });
+    
+    // One bulk purge, one market data update per book
+    assert(simulator.disconnect_session(1) == 8);
+    assert(simulator.get_live_order_count(1) == 0);
+    assert(updates_a == 1);
+    assert(simulator.get_ask_levels(symbol_b).empty());
+    auto bids = simulator.get_bid_levels(symbol_a);
+    assert(bids.size() == 1 && bids[0].first == 4980);
+    assert(simulator.disconnect_session(1) == 0);
+    
+    // Heartbeat timeout only purges sessions that stopped heartbeating
+    simulator.session_heartbeat(2);
+    simulator.submit_client_order(3, "Y", symbol_a, Side::BUY, OrderType::LIMIT, 10, 4970);
+    assert(simulator.expire_sessions(std::chrono::seconds(60)) == 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    assert(simulator.expire_sessions(std::chrono::milliseconds(1)) == 1);
+    assert(simulator.get_live_order_count(2) == 0);
+    assert(simulator.get_live_order_count(3) == 1);
+    
+    std::cout << "✓ Cancel-on-disconnect test passed\n";
+}
+
+void test_symbol_rules() {
+    std::cout << "Testing symbol reference data...\n";
+    
+    // Tick 1 below 1000, 5 up to 10000, 10 above
+    SymbolRules rules;
+    assert(rules.add_tick_band(1000, 5));
+    assert(rules.add_tick_band(10000, 10));
+    assert(!rules.add_tick_band(5000, 2));
+    rules.lot_size = 100;
+    rules.min_price = 900;
+    rules.max_price = 10100;
+    rules.dynamic_band_bps = 1000;   // 10%
+    
+    assert(rules.tick_size_at(999) == 1 && rules.tick_size_at(1000) == 5 && rules.tick_size_at(20000) == 10);
+    assert(rules.validate(OrderType::LIMIT, 200, 1005, 0) == ValidationResult::OK);
+    assert(rules.validate(OrderType::LIMIT, 200, 1003, 0) == ValidationResult::INVALID_TICK);
+    assert(rules.validate(OrderType::LIMIT, 150, 1005, 0) == ValidationResult::INVALID_QUANTITY);
+    assert(rules.validate(OrderType::LIMIT, 0, 1005, 0) == ValidationResult::INVALID_QUANTITY);
+    assert(rules.validate(OrderType::LIMIT, 100, 899, 0) == ValidationResult::OUTSIDE_STATIC_BAND);
+    assert(rules.validate(OrderType::LIMIT, 100, 10110, 0) == ValidationResult::OUTSIDE_STATIC_BAND);
+    assert(rules.validate(OrderType::LIMIT, 100, 1200, 1000) == ValidationResult::OUTSIDE_DYNAMIC_BAND);
+    assert(rules.validate(OrderType::LIMIT, 100, 1100, 1000) == ValidationResult::OK);
+    assert(rules.validate(OrderType::MARKET, 100, 0, 1000) == ValidationResult::OK);
+    
+    // Several failures report the lowest-numbered one
+    assert(rules.validate(OrderType::LIMIT, 150, 1003, 0) == ValidationResult::INVALID_QUANTITY);
+    assert(rules.validate(OrderType::LIMIT, 100, 10101, 0) == ValidationResult::INVALID_TICK);
+    assert(rules.validate(OrderType::LIMIT, 100, 10200, 5000) == ValidationResult::OUTSIDE_STATIC_BAND);
+    
+    // Ladder: 900..999 step 1, 1000..9995 step 5, 10000..10100 step 10
+    assert(rules.ladder_levels() == 100 + 1800 + 11);
+    assert(rules.ladder_index(900) == 0);
+    assert(rules.ladder_index(1000) == 100);
+    assert(rules.ladder_index(10000) == 1900);
+    
+    OrderBookSimulator simulator(1);
+    constexpr uint32_t symbol = 100;
+    assert(simulator.set_symbol_rules(symbol, rules));
+    assert(simulator.get_symbol_rules(symbol).lot_size == 100);
+    assert(simulator.get_symbol_rules(symbol + 1).lot_size == 1);
+    
+    // Rules that validate() would divide by zero under are refused
+    SymbolRules broken = rules;
+    broken.lot_size = 0;
+    assert(!simulator.set_symbol_rules(symbol + 1, broken));
+    broken = rules;
+    broken.band_tick[2] = 0;
+    assert(!simulator.set_symbol_rules(symbol + 1, broken));
+    
+    assert(simulator.submit_order(symbol, Side::SELL, OrderType::LIMIT, 100, 1003) == 0);
+    uint64_t sell = simulator.submit_order(symbol, Side::SELL, OrderType::LIMIT, 100, 1005);
+    assert(sell != 0);
+    assert(!simulator.modify_order(sell, 150, 1005));
+    assert(simulator.modify_order(sell, 200, 1005));
+    
+    // Dynamic band follows the last trade
+    simulator.submit_order(symbol, Side::BUY, OrderType::LIMIT, 100, 1005);
+    assert(simulator.submit_order(symbol, Side::BUY, OrderType::LIMIT, 100, 900) == 0);
+    assert(simulator.submit_order(symbol, Side::BUY, OrderType::LIMIT, 100, 950) != 0);
+    
+    assert(simulator.get_performance_metrics().validation_rejects == 3);
+    
+    std::cout << "✓ Symbol reference data test passed\n";
+}
+
+void test_price_bands() {
+    std::cout << "Testing price bands and volatility halts...\n";
+    
+    // Rolling reference: 64 buckets of 1ms
+    RollingPriceAverage average(64000);
+    average.add(1000, 100);
+    average.add(2000, 200);
+    assert(average.mean(2000) == 150);
+    assert(average.mean(65000) == 200);
+    assert(average.mean(66000) == 0);
+    
+    OrderBook book(1);
+    PriceBandConfig config;
+    config.band_bps = 500;                  // 5%
+    config.limit_state_us = 1000;
+    config.halt_us = 5000;
+    config.initial_reference_price = 1000;
+    book.set_price_bands(config);
+    assert(book.get_price_bands().lower == 950 && book.get_price_bands().upper == 1050);
+    
+    const uint64_t t0 = 1000000;
+    auto order = [&](uint64_t id, Side side, OrderType type, uint64_t quantity, uint64_t price, uint64_t time) {
+        auto o = std::make_shared<Order>(id, 1, side, type, quantity, price);
+        o->timestamp = time;
+        book.add_order(o);
+        return o;
+    };
+    
+    // The buy trades at 1040, moving the band to [988, 1092]; the ask at
+    // 1200 is out of band, so the crossing remainder is cancelled
+    order(1, Side::SELL, OrderType::LIMIT, 10, 1040, t0);
+    order(2, Side::SELL, OrderType::LIMIT, 10, 1200, t0);
+    auto buy = order(3, Side::BUY, OrderType::LIMIT, 20, 1300, t0);
+    assert(buy->filled_quantity == 10 && buy->status == OrderStatus::CANCELLED);
+    assert(book.get_trade_count() == 1);
+    assert(book.get_price_bands().reference_price == 1040 && book.get_price_bands().upper == 1092);
+    assert(book.get_top_of_book().best_bid_price == 0);
+    
+    // A bid at the upper band is a limit state until it clears
+    order(4, Side::BUY, OrderType::LIMIT, 10, 1092, t0 + 1);
+    assert(book.get_price_bands().state == TradingState::LIMIT_STATE);
+    assert(book.cancel_order(4));
+    assert(book.get_price_bands().state == TradingState::CONTINUOUS);
+    
+    // Staying there past limit_state_us halts the book
+    auto bid = order(5, Side::BUY, OrderType::LIMIT, 10, 1092, t0 + 10);
+    book.advance_time(t0 + 500);
+    assert(book.get_price_bands().state == TradingState::LIMIT_STATE);
+    book.advance_time(t0 + 1010);
+    assert(book.get_price_bands().state == TradingState::HALTED);
+    
+    // Halted: limit orders rest without matching, market orders are rejected
+    order(6, Side::SELL, OrderType::LIMIT, 5, 1080, t0 + 2000);
+    auto market = order(7, Side::BUY, OrderType::MARKET, 5, 0, t0 + 2000);
+    order(8, Side::SELL, OrderType::LIMIT, 10, 1100, t0 + 2000);
+    assert(market->status == OrderStatus::REJECTED);
+    assert(book.get_trade_count() == 1);
+    assert(book.get_top_of_book().best_bid_price == 1092 && book.get_top_of_book().best_ask_price == 1080);
+    
+    // The reopening auction uncrosses 5 at 1080 (equal volume and imbalance
+    // at 1092, but 1080 is nearer the reference) and recentres the band
+    book.advance_time(t0 + 6010);
+    PriceBands bands = book.get_price_bands();
+    assert(bands.state == TradingState::CONTINUOUS);
+    assert(bands.reference_price == 1080 && bands.lower == 1026 && bands.upper == 1134);
+    assert(book.get_trade_count() == 2 && book.get_last_trade_price() == 1080);
+    assert(bid->filled_quantity == 5 && bid->status == OrderStatus::PARTIALLY_FILLED);
+    TopOfBook top = book.get_top_of_book();
+    assert(top.best_bid_price == 1092 && top.best_bid_quantity == 5 && top.best_ask_price == 1100);
+    
+    // Reconfiguring a halted, crossed book runs the auction before the new
+    // bands apply, so it never reopens crossed
+    OrderBook halted(2);
+    halted.set_price_bands(config);
+    auto rest = [&](uint64_t id, Side side, uint64_t price, uint64_t time) {
+        auto o = std::make_shared<Order>(id, 2, side, OrderType::LIMIT, 10, price);
+        o->timestamp = time;
+        halted.add_order(o);
+    };
+    rest(1, Side::BUY, 1050, t0);
+    halted.advance_time(t0 + 1000);
+    rest(2, Side::SELL, 1000, t0 + 1500);
+    assert(halted.get_price_bands().state == TradingState::HALTED && halted.get_trade_count() == 0);
+    config.band_bps = 1000;
+    halted.set_price_bands(config);
+    assert(halted.get_price_bands().state == TradingState::CONTINUOUS && halted.get_price_bands().upper == 1100);
+    assert(halted.get_trade_count() == 1 && halted.get_last_trade_price() == 1000);
+    assert(halted.get_top_of_book().best_bid_price == 0 && halted.get_top_of_book().best_ask_price == 0);
+    
+    // Resetting a halted book empties it, so it reopens uncrossed
+    rest(3, Side::BUY, 1100, t0 + 2000);
+    halted.advance_time(t0 + 3000);
+    rest(4, Side::SELL, 900, t0 + 3500);
+    assert(halted.get_price_bands().state == TradingState::HALTED);
+    halted.reset();
+    assert(halted.get_price_bands().state == TradingState::CONTINUOUS && halted.get_trade_count() == 0);
+    assert(halted.get_top_of_book().best_bid_price == 0 && halted.get_top_of_book().best_ask_price == 0);
+    config.band_bps = 500;
+    
+    OrderBookSimulator simulator(1);
+    simulator.set_price_bands(7, config);
+    assert(simulator.get_price_bands(7).upper == 1050);
+    assert(simulator.get_price_bands(8).upper == 0);
+    
+    std::cout << "✓ Price bands test passed\n";
+}
+
+void test_bar_aggregation() {
+    std::cout << "Testing bar aggregation...\n";
+    
+    OrderBookSimulator simulator(1);
+    constexpr uint32_t symbol = 42;
+    const uint64_t second = 1000000;
+    BarAggregator& bars = simulator.enable_bars({second, 60 * second});
+    
+    std::vector<Bar> completed;
+    bars.subscribe([&](const Bar& bar) { completed.push_back(bar); });
+    
+    // Five prints; each buy lifts a fresh ask
+    const uint64_t prices[] = {100, 104, 98, 101, 103};
+    const uint64_t quantities[] = {10, 20, 5, 15, 10};
+    for (size_t i = 0; i < 5; ++i) {
+        simulator.submit_order(symbol, Side::SELL, OrderType::LIMIT, quantities[i], prices[i]);
+        simulator.submit_order(symbol, Side::BUY, OrderType::LIMIT, quantities[i], prices[i]);
+    }
+    
+    MarketDataSnapshot snapshot = simulator.get_market_data(symbol);
+    assert(snapshot.last_trade_price == 103 && snapshot.last_trade_quantity == 10);
+    
+    assert(bars.poll() == 5);
+    Bar current;
+    assert(bars.current_bar(symbol, 1, current) && current.trade_count > 0);
+    assert(!bars.current_bar(symbol + 1, 0, current));
+    
+    // Close everything; the prints may straddle a boundary, so check totals
+    bars.flush(UINT64_MAX);
+    for (size_t interval = 0; interval < 2; ++interval) {
+        uint64_t volume = 0, count = 0, high = 0, low = UINT64_MAX;
+        double notional = 0.0;
+        std::vector<Bar> series;
+        for (const Bar& bar : completed) {
+            if (bar.interval_us == bars.intervals()[interval]) {
+                assert(bar.symbol_id == symbol && bar.start_us % bar.interval_us == 0);
+                series.push_back(bar);
+                volume += bar.volume;
+                count += bar.trade_count;
+                high = std::max(high, bar.high);
+                low = std::min(low, bar.low);
+                notional += bar.notional;
+            }
+        }
+        assert(!series.empty());
+        assert(series.front().open == 100 && series.back().close == 103);
+        assert(volume == 60 && count == 5 && high == 104 && low == 98);
+        assert(notional == 6115.0);
+        if (series.size() == 1) {
+            assert(series[0].vwap() == 6115.0 / 60.0);
+        }
+    }
+    assert(bars.get_dropped_prints() == 0);
+    
+    std::cout << "✓ Bar aggregation test passed\n";
+}
+
+void test_book_features() {
+    std::cout << "Testing streaming book features...\n";
+    
+    OrderBook book(1);
+    BookFeaturesConfig config;
+    config.depth = 2;
+    config.ewma_alpha = 0.5;
+    book.set_features(config);
+    
+    book.add_order(std::make_shared<Order>(1, 1, Side::BUY, OrderType::LIMIT, 10, 100));
+    book.add_order(std::make_shared<Order>(2, 1, Side::BUY, OrderType::LIMIT, 30, 99));
+    book.add_order(std::make_shared<Order>(3, 1, Side::SELL, OrderType::LIMIT, 30, 102));
+    book.add_order(std::make_shared<Order>(4, 1, Side::SELL, OrderType::LIMIT, 10, 103));
+    book.add_order(std::make_shared<Order>(5, 1, Side::SELL, OrderType::LIMIT, 50, 110));   // Beyond depth
+    
+    BookFeatures features = book.get_features();
+    assert(features.imbalance == -0.5);
+    assert(features.depth_imbalance == 0.0);
+    assert(features.microprice == 100.5);
+    assert(features.depth_weighted_mid == (99.25 + 102.25) / 2);
+    assert(features.spread_mean == 2.0 && features.mid_volatility == 0.0);
+    assert(features.bbo_changes == 1);
+    
+    // Spread widens to 3 and the mid moves up half a tick
+    assert(book.cancel_order(3));
+    features = book.get_features();
+    assert(features.bbo_changes == 2);
+    assert(features.spread_mean == 2.5);
+    assert(features.spread_volatility == 0.5);
+    assert(std::abs(features.mid_volatility - std::sqrt(0.125)) < 1e-12);
+    assert(features.microprice == (100.0 * 10 + 103.0 * 10) / 20);
+    
+    // Depth changes behind the top move depth features only
+    book.add_order(std::make_shared<Order>(6, 1, Side::BUY, OrderType::LIMIT, 40, 99));
+    features = book.get_features();
+    assert(features.bbo_changes == 2 && features.depth_imbalance > 0.0);
+    
+    OrderBookSimulator simulator(1);
+    simulator.set_book_features(9, config);
+    simulator.submit_order(9, Side::BUY, OrderType::LIMIT, 30, 100);
+    simulator.submit_order(9, Side::SELL, OrderType::LIMIT, 10, 101);
+    assert(simulator.get_book_features(9).imbalance == 0.5);
+    
+    std::cout << "✓ Book features test passed\n";
+}
+
+void test_trade_tape() {
+    std::cout << "Testing time-and-sales tape...\n";
+    
+    TradeTape tape(5);
+    assert(tape.capacity() == 8);
+    
+    // Ten prints at t = 10, 20, ..., 100; the first two are overwritten
+    for (uint64_t i = 1; i <= 10; ++i) {
+        Trade trade(i, 1, 2, 1, i, 100 + i);
+        trade.timestamp = 10 * i;
+        tape.on_trade(trade);
+    }
+    assert(tape.total() == 10);
+    
+    TapePrint prints[16];
+    assert(tape.last(3, prints) == 3);
+    assert(prints[0].trade_id == 8 && prints[2].trade_id == 10 && prints[2].price == 110);
+    assert(tape.last(16, prints) == 8 && prints[0].trade_id == 3);
+    
+    assert(tape.between(35, 60, prints, 16) == 3);
+    assert(prints[0].timestamp == 40 && prints[2].timestamp == 60);
+    assert(tape.between(0, 1000, prints, 2) == 2 && prints[0].trade_id == 3);
+    assert(tape.between(101, 200, prints, 16) == 0);
+    
+    // A clock step back is clamped so the tape stays sorted
+    Trade late(11, 1, 2, 1, 1, 111);
+    late.timestamp = 5;
+    tape.on_trade(late);
+    assert(tape.last(1, prints) == 1 && prints[0].timestamp == 100);
+    
+    // Lock-free reads while a writer laps the ring
+    TradeTape shared(64);
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (uint64_t i = 1; i <= 200000; ++i) {
+            Trade trade(i, 1, 2, 1, i, i);
+            trade.timestamp = i;
+            shared.on_trade(trade);
+        }
+        done = true;
+    });
+    while (!done) {
+        size_t count = shared.last(16, prints);
+        for (size_t i = 1; i < count; ++i) {
+            assert(prints[i].trade_id == prints[i - 1].trade_id + 1);
+            assert(prints[i].price == prints[i].trade_id && prints[i].timestamp == prints[i].trade_id);
+        }
+    }
+    writer.join();
+    
+    // Simulator tapes record every symbol's trades
+    OrderBookSimulator simulator(1);
+    simulator.enable_trade_tapes(1024);
+    simulator.submit_order(3, Side::SELL, OrderType::LIMIT, 10, 100);
+    simulator.submit_order(3, Side::BUY, OrderType::LIMIT, 4, 100);
+    const TradeTape* symbol_tape = simulator.get_trade_tape(3);
+    assert(symbol_tape && symbol_tape->total() == 1);
+    assert(symbol_tape->last(1, prints) == 1 && prints[0].quantity == 4);
+    assert(simulator.get_trade_tape(4) == nullptr);
+    
+    std::cout << "✓ Trade tape test passed\n";
+}
+
+void test_consolidated_book() {
+    std::cout << "Testing consolidated multi-venue book...\n";
+    
+    OrderBookSimulator venue_a(1), venue_b(1), venue_c(1);
+    ConsolidatedBook consolidated(3);
+    assert(consolidated.add_venue(venue_a) == 0);
+    assert(consolidated.add_venue(venue_b) == 1);
+    assert(consolidated.add_venue(venue_c) == 2);
+    constexpr uint32_t symbol = 5;
+    consolidated.track_symbol(symbol);
+    
+    std::vector<Nbbo> changes;
+    consolidated.subscribe([&](uint32_t symbol_id, const Nbbo& nbbo) {
+        assert(symbol_id == symbol);
+        changes.push_back(nbbo);
+    });
+    
+    venue_a.submit_order(symbol, Side::BUY, OrderType::LIMIT, 10, 99);
+    venue_a.submit_order(symbol, Side::SELL, OrderType::LIMIT, 10, 103);
+    venue_b.submit_order(symbol, Side::BUY, OrderType::LIMIT, 20, 100);
+    venue_b.submit_order(symbol, Side::SELL, OrderType::LIMIT, 5, 104);
+    uint64_t c_ask = venue_c.submit_order(symbol, Side::SELL, OrderType::LIMIT, 7, 102);
+    venue_c.submit_order(symbol, Side::BUY, OrderType::LIMIT, 30, 100);
+    
+    Nbbo nbbo = consolidated.get_nbbo(symbol);
+    assert(nbbo.best_bid_price == 100 && nbbo.best_bid_venue == 2 && nbbo.best_bid_quantity == 30);
+    assert(nbbo.best_ask_price == 102 && nbbo.best_ask_venue == 2 && nbbo.best_ask_quantity == 7);
+    
+    // Updates that leave the NBBO unchanged publish nothing
+    size_t published = changes.size();
+    venue_a.submit_order(symbol, Side::BUY, OrderType::LIMIT, 10, 98);
+    assert(changes.size() == published);
+    
+    assert(venue_c.cancel_order(c_ask));
+    nbbo = consolidated.get_nbbo(symbol);
+    assert(nbbo.best_ask_price == 103 && nbbo.best_ask_venue == 0);
+    assert(changes.size() == published + 1 && changes.back().best_ask_price == 103);
+    
+    // Consolidated depth in price priority, ties in venue order
+    ConsolidatedLevel levels[8];
+    size_t count = consolidated.get_depth(symbol, Side::BUY, levels, 8);
+    assert(count == 4);
+    assert(levels[0].price == 100 && levels[0].venue == 1);
+    assert(levels[1].price == 100 && levels[1].venue == 2);
+    assert(levels[2].price == 99 && levels[3].price == 98);
+    assert(consolidated.get_depth(symbol, Side::SELL, levels, 1) == 1 && levels[0].price == 103);
+    
+    VenueDepth depth;
+    assert(consolidated.get_venue_depth(symbol, 0, depth) && depth.bid_count == 2 && depth.ask_count == 1);
+    assert(consolidated.get_nbbo(symbol + 1).best_bid_price == 0);
+    
+    // A destroyed consolidated book detaches, so its venues trade on safely
+    size_t notified = 0;
+    {
+        ConsolidatedBook scoped(2);
+        scoped.add_venue(venue_a);
+        scoped.track_symbol(symbol);
+        scoped.subscribe([&](uint32_t, const Nbbo&) { notified++; });
+        venue_a.submit_order(symbol, Side::BUY, OrderType::LIMIT, 1, 100);
+        assert(notified == 1);
+    }
+    venue_a.submit_order(symbol, Side::BUY, OrderType::LIMIT, 1, 101);
+    assert(notified == 1 && consolidated.get_nbbo(symbol).best_bid_price == 101);
+    
+    std::cout << "✓ Consolidated book test passed\n";
+}
+
+void test_smart_order_router() {
+    std::cout << "Testing smart order router...\n";
+    
+    OrderBookSimulator venue_a(1), venue_b(1), venue_c(1);
+    ConsolidatedBook consolidated(5);
+    consolidated.add_venue(venue_a);
+    consolidated.add_venue(venue_b);
+    consolidated.add_venue(venue_c);
+    constexpr uint32_t symbol = 8;
+    consolidated.track_symbol(symbol);
+    
+    venue_a.submit_order(symbol, Side::SELL, OrderType::LIMIT, 10, 100);
+    venue_a.submit_order(symbol, Side::SELL, OrderType::LIMIT, 10, 102);
+    venue_b.submit_order(symbol, Side::SELL, OrderType::LIMIT, 10, 99);
+    venue_c.submit_order(symbol, Side::SELL, OrderType::LIMIT, 10, 100);
+    
+    // B is cheapest on price but pays a 2.0 fee; C is 1ms away at 0.0005 per us
+    SmartOrderRouter router(consolidated, 2, 0.0005);
+    router.set_venue_cost(1, 2.0, 0);
+    router.set_venue_cost(2, 0.0, 1000000);
+    
+    // Effective asks: A 100, C 100.5, B 101, A 102
+    RoutePlan plan;
+    assert(router.plan(symbol, Side::BUY, 35, 0, plan));
+    assert(plan.child_count == 3 && plan.planned_quantity == 35);
+    assert(plan.expected_cost == 1000.0 + 1005.0 + 1010.0 + 510.0);
+    assert(plan.children[0].venue == 2 && plan.children[0].quantity == 10);         // Slowest first
+    assert(plan.children[1].venue == 0 && plan.children[1].quantity == 15 && plan.children[1].limit_price == 102);
+    assert(plan.children[2].venue == 1 && plan.children[2].limit_price == 99);
+    
+    // A limit stops the sweep on raw price
+    assert(router.plan(symbol, Side::BUY, 35, 100, plan) && plan.planned_quantity == 30);
+    assert(!router.plan(symbol, Side::SELL, 10, 0, plan));
+    
+    assert(router.route(symbol, Side::BUY, 35, 0, plan));
+    assert(plan.filled_quantity == 35);
+    for (uint32_t i = 0; i < plan.child_count; ++i) {
+        assert(plan.children[i].order_id != 0 && plan.children[i].filled_quantity == plan.children[i].quantity);
+    }
+    Nbbo nbbo = consolidated.get_nbbo(symbol);
+    assert(nbbo.best_ask_price == 102 && nbbo.best_ask_quantity == 5 && nbbo.best_ask_venue == 0);
+    
+    // Parents larger than the visible depth fill what is there; nothing rests
+    assert(router.route(symbol, Side::BUY, 10, 0, plan));
+    assert(plan.planned_quantity == 5 && plan.filled_quantity == 5);
+    assert(venue_a.get_bid_levels(symbol).empty());
+    assert(!router.route(symbol, Side::BUY, 10, 0, plan));
+    
+    std::cout << "✓ Smart order router test passed\n";
+}
+
+void test_market_orders() {
+    std::cout << "Testing market order protection...\n";
+    
+    OrderBook book(1);
+    uint64_t next_id = 1;
+    auto order = [&](Side side, OrderType type, uint64_t quantity, uint64_t price) {
+        auto o = std::make_shared<Order>(next_id++, 1, side, type, quantity, price);
+        book.add_order(o);
+        return o;
+    };
+    
+    // A 2-tick collar from the best ask at arrival stops the sweep at 102;
+    // the remainder of a market order is dropped
+    MarketProtection protection;
+    protection.collar_ticks = 2;
+    book.set_market_protection(protection);
+    order(Side::SELL, OrderType::LIMIT, 10, 100);
+    order(Side::SELL, OrderType::LIMIT, 10, 101);
+    order(Side::SELL, OrderType::LIMIT, 10, 103);
+    auto market = order(Side::BUY, OrderType::MARKET, 25, 0);
+    assert(market->filled_quantity == 20 && market->status == OrderStatus::PARTIALLY_FILLED);
+    assert(book.get_top_of_book().best_ask_price == 103 && book.get_top_of_book().best_bid_price == 0);
+    assert(!book.cancel_order(market->order_id));
+    
+    // 5% of 99 is a 4-tick collar, so the sell sweeps 99 and 98 and the
+    // market-to-limit remainder rests at 98
+    protection.collar_ticks = 0;
+    protection.collar_bps = 500;
+    book.set_market_protection(protection);
+    order(Side::BUY, OrderType::LIMIT, 10, 99);
+    order(Side::BUY, OrderType::LIMIT, 10, 98);
+    order(Side::BUY, OrderType::LIMIT, 10, 90);
+    auto mtl = order(Side::SELL, OrderType::MARKET_TO_LIMIT, 25, 0);
+    assert(mtl->filled_quantity == 20 && mtl->price == 98 && mtl->status == OrderStatus::PARTIALLY_FILLED);
+    TopOfBook top = book.get_top_of_book();
+    assert(top.best_ask_price == 98 && top.best_ask_quantity == 5 && top.best_bid_price == 90);
+    assert(book.cancel_order(mtl->order_id));
+    
+    // Without a fill there is no price to convert at
+    OrderBook empty(2);
+    auto unfilled = std::make_shared<Order>(1, 2, Side::BUY, OrderType::MARKET_TO_LIMIT, 5, 0);
+    empty.add_order(unfilled);
+    assert(unfilled->status == OrderStatus::REJECTED && empty.get_top_of_book().best_bid_price == 0);
+    
+    // A limit sell sweeps several bid levels
+    OrderBook sweep(3);
+    sweep.add_order(std::make_shared<Order>(1, 3, Side::BUY, OrderType::LIMIT, 5, 100));
+    sweep.add_order(std::make_shared<Order>(2, 3, Side::BUY, OrderType::LIMIT, 5, 99));
+    auto sell = std::make_shared<Order>(3, 3, Side::SELL, OrderType::LIMIT, 10, 95);
+    sweep.add_order(sell);
+    assert(sell->status == OrderStatus::FILLED && sweep.get_trade_count() == 2);
+    
+    // Rested market-to-limit remainders count against the open notional limit
+    OrderBookSimulator simulator(1);
+    RiskLimits limits;
+    limits.max_open_notional = 1200;
+    simulator.set_account_risk_limits(5, limits);
+    const RiskEngine& risk = simulator.get_risk_engine();
+    std::vector<uint64_t> rested;
+    for (uint32_t symbol : {10u, 11u}) {
+        simulator.submit_order(symbol, Side::SELL, OrderType::LIMIT, 10, 100, 0, 6);
+        rested.push_back(simulator.submit_order(symbol, Side::BUY, OrderType::MARKET_TO_LIMIT, 15, 0, 0, 5));
+        assert(rested.back() != 0);
+    }
+    assert(risk.get_open_notional(5) == 2 * 5 * 100);
+    uint64_t rejects = risk.get_reject_count();
+    assert(simulator.submit_order(12, Side::BUY, OrderType::LIMIT, 5, 100, 0, 5) == 0);
+    assert(risk.get_reject_count() == rejects + 1);
+    
+    // Fills and cancels on the rested remainder release it
+    simulator.submit_order(10, Side::SELL, OrderType::LIMIT, 2, 100, 0, 6);
+    assert(risk.get_open_notional(5) == 8 * 100);
+    assert(simulator.cancel_order(rested[1]));
+    assert(risk.get_open_notional(5) == 3 * 100);
+    
+    std::cout << "✓ Market order protection test passed\n";
+}
+
+void test_journal_archive() {
+    std::cout << "Testing journal archive...\n";
+    
+    // The simulator journals every command applied to its books
+    OrderBookSimulator simulator(1);
+    std::vector<JournalRecord> journal;
+    std::mutex journal_mutex;
+    simulator.set_journal([&](const JournalRecord& record) {
+        std::lock_guard<std::mutex> lock(journal_mutex);
+        journal.push_back(record);
+    });
+    uint64_t bid = simulator.submit_order(1, Side::BUY, OrderType::LIMIT, 10, 100);
+    simulator.submit_order(2, Side::SELL, OrderType::LIMIT, 5, 200);
+    assert(simulator.modify_order(bid, 20, 101));
+    simulator.submit_order(1, Side::SELL, OrderType::MARKET, 5, 0);
+    assert(simulator.cancel_order(bid));
+    simulator.advance_time(journal.back().timestamp + 1000);
+    assert(journal.size() == 7 && simulator.get_journal_sequence() == 7);
+    for (size_t i = 0; i < journal.size(); ++i) {
+        assert(journal[i].sequence == i + 1);
+    }
+    assert(journal[2].command == JournalCommand::MODIFY && journal[2].order_id == bid && journal[2].price == 101);
+    assert(journal[3].order_type == OrderType::MARKET && journal[3].price == 0);
+    assert(journal[4].command == JournalCommand::CANCEL && journal[4].order_id == bid);
+    assert(journal[5].command == JournalCommand::ADVANCE_TIME && journal[6].command == JournalCommand::ADVANCE_TIME);
+    
+    // Interleaved symbols over many small blocks
+    const uint32_t symbols = 4;
+    std::vector<JournalRecord> records;
+    for (uint64_t i = 1; i <= 5000; ++i) {
+        JournalRecord record;
+        record.sequence = i;
+        record.symbol_id = static_cast<uint32_t>(i * 7 % symbols) + 10;
+        record.timestamp = 1'000'000'000 + i * 13;
+        record.order_id = i;
+        record.command = static_cast<JournalCommand>(i % 5 == 0 ? 1 : i % 7 == 0 ? 2 : i % 97 == 0 ? 3 : 0);
+        if (record.command != JournalCommand::CANCEL && record.command != JournalCommand::ADVANCE_TIME) {
+            record.side = i % 2 ? Side::BUY : Side::SELL;
+            record.order_type = i % 11 == 0 ? OrderType::MARKET : OrderType::LIMIT;
+            record.quantity = 100 * (1 + i % 5);
+            record.price = record.order_type == OrderType::MARKET ? 0 : 10000 + (i * 31 % 40);
+            record.account_id = static_cast<uint32_t>(i % 3);
+            record.session_id = 7;
+            if (i % 13 == 0) {
+                ClOrdId::from_string("c" + std::to_string(i), record.cl_ord_id);
+            }
+        }
+        if (record.command == JournalCommand::ADVANCE_TIME) {
+            record.order_id = 0;
+        }
+        records.push_back(record);
+    }
+    
+    const std::string path = "test_journal_archive.lobj";
+    JournalArchiveWriter writer(256);
+    assert(writer.open(path));
+    for (const auto& record : records) {
+        assert(writer.append(record));
+    }
+    assert(writer.close());
+    assert(writer.bytes_written() * 4 < records.size() * sizeof(JournalRecord));
+    
+    JournalArchiveReader reader;
+    assert(reader.open(path));
+    assert(reader.record_count() == records.size() && reader.block_count() == 20);
+    std::vector<JournalRecord> decoded, block;
+    for (size_t i = 0; i < reader.block_count(); ++i) {
+        assert(reader.read_block(i, block));
+        decoded.insert(decoded.end(), block.begin(), block.end());
+    }
+    assert(decoded.size() == records.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+        const JournalRecord& a = records[i];
+        const JournalRecord& b = decoded[i];
+        assert(a.sequence == b.sequence && a.timestamp == b.timestamp && a.order_id == b.order_id &&
+               a.quantity == b.quantity && a.price == b.price && a.symbol_id == b.symbol_id &&
+               a.account_id == b.account_id && a.session_id == b.session_id && a.command == b.command &&
+               a.side == b.side && a.order_type == b.order_type && a.cl_ord_id == b.cl_ord_id);
+    }
+    
+    // Seeks by sequence and by (symbol, sequence / time)
+    assert(reader.find_block(1) == 0 && reader.find_block(257) == 1 && reader.find_block(5001) == 20);
+    assert(reader.find_block(11, 3000) == 11 && reader.find_block_at_time(11, 1'000'000'000 + 3000 * 13) == 11);
+    assert(reader.find_block(11, 0) == 0 && reader.find_block(99, 10) == reader.block_count());
+    assert(reader.next_block(11, 11) == 12 && reader.next_block(11, 19) == reader.block_count());
+    std::remove(path.c_str());
+    
+    std::cout << "✓ Journal archive test passed\n";
+}
+
+// Seeded random flow on symbols 1 and 2 for the journal-driven tests:
+// limit submits around 95-106 (60%), cancels (20%) and modifies (10%) of
+// earlier orders, and market orders or more submits (10%)
+class RandomOrderFlow {
+public:
+    RandomOrderFlow(uint64_t seed, uint32_t account_id, bool market_orders)
+        : rng_(seed), account_id_(account_id), market_orders_(market_orders) {}
+    
+    void step(OrderBookSimulator& simulator) {
+        uint32_t symbol = 1 + rng_() % 2;
+        uint64_t r = rng_() % 10;
+        if (r < 6 || (r == 9 && !market_orders_) || ids_.empty()) {
+            Side side = rng_() % 2 ? Side::BUY : Side::SELL;
+            uint64_t price = side == Side::BUY ? 95 + rng_() % 8 : 99 + rng_() % 8;
+            uint64_t id = simulator.submit_order(symbol, side, OrderType::LIMIT, 1 + rng_() % 20, price, 0, account_id_);
+            if (id) {
+                ids_.push_back(id);
+            }
+        } else if (r < 8) {
+            simulator.cancel_order(ids_[rng_() % ids_.size()]);
+        } else if (r < 9) {
+            simulator.modify_order(ids_[rng_() % ids_.size()], 1 + rng_() % 20, 96 + rng_() % 8);
+        } else {
+            Side side = rng_() % 2 ? Side::BUY : Side::SELL;
+            simulator.submit_order(symbol, side, OrderType::MARKET, 1 + rng_() % 10, 0, 0, account_id_);
+        }
+    }
+    
+    void run(OrderBookSimulator& simulator, int steps) {
+        for (int i = 0; i < steps; ++i) {
+            step(simulator);
+        }
+    }
+    
+    // Every accepted limit order id, oldest first
+    const std::vector<uint64_t>& ids() const noexcept { return ids_; }
+    
+private:
+    Xoshiro256pp rng_;
+    uint32_t account_id_;
+    bool market_orders_;
+    std::vector<uint64_t> ids_;
+};
+
+void test_replay_seek() {
+    std::cout << "Testing replay seek...\n";
+    
+    // Primary run journaled into an archive, with the book's levels noted
+    // at a few sequence numbers and one snapshot taken mid-run
+    OrderBookSimulator simulator(1);
+    std::vector<JournalRecord> journal;
+    simulator.set_journal([&](const JournalRecord& record) { journal.push_back(record); });
+    
+    using Levels = std::vector<std::pair<uint64_t, uint64_t>>;
+    std::map<uint64_t, std::pair<Levels, Levels>> expected;
+    auto note = [&] {
+        uint64_t sequence = simulator.get_journal_sequence();
+        expected[sequence] = {simulator.get_bid_levels(1, 20), simulator.get_ask_levels(1, 20)};
+        return sequence;
+    };
+    
+    RandomOrderFlow flow(7, 0, true);
+    BookSnapshot snapshot;
+    uint64_t snapshot_mark = 0;
+    for (int i = 0; i < 3000; ++i) {
+        flow.step(simulator);
+        if (i % 500 == 250) {
+            note();
+        }
+        if (i == 1500) {
+            snapshot = simulator.snapshot_book(1);
+            snapshot_mark = note();
+        }
+    }
+    note();
+    assert(snapshot.sequence > 0 && snapshot.sequence <= snapshot_mark && !snapshot.orders.empty());
+    
+    const std::string path = "test_replay_seek.lobj";
+    JournalArchiveWriter writer(128);
+    assert(writer.open(path));
+    for (const auto& record : journal) {
+        writer.append(record);
+    }
+    assert(writer.close());
+    JournalArchiveReader reader;
+    assert(reader.open(path));
+    
+    // Snapshots survive a round trip through a stream
+    std::stringstream stream;
+    assert(write_book_snapshot(stream, snapshot));
+    BookSnapshot loaded;
+    assert(read_book_snapshot(stream, loaded));
+    assert(loaded.sequence == snapshot.sequence && loaded.orders.size() == snapshot.orders.size());
+    
+    // Seeks forward, back, and from the snapshot all land on the primary's state
+    ReplaySession session(reader, 1);
+    session.add_snapshot(loaded);
+    for (uint64_t target : {expected.begin()->first, expected.rbegin()->first, std::next(expected.begin())->first,
+                            snapshot_mark, std::prev(expected.end(), 2)->first}) {
+        assert(session.seek(target));
+        const auto& levels = expected[target];
+        assert(session.book().get_bid_levels(20) == levels.first);
+        assert(session.book().get_ask_levels(20) == levels.second);
+    }
+    
+    // The last seek started from the snapshot and only applied the delta
+    ReplaySession fresh(reader, 1);
+    fresh.add_snapshot(snapshot);
+    assert(fresh.seek(expected.rbegin()->first));
+    assert(fresh.records_applied() < journal.size() / 2);
+    
+    // Stepping moves one symbol-1 record at a time
+    assert(session.seek(snapshot.sequence));
+    const JournalRecord* next = session.peek();
+    assert(next && next->symbol_id == 1 && next->sequence > snapshot.sequence);
+    uint64_t next_sequence = next->sequence;
+    assert(session.step() && session.position() == next_sequence);
+    
+    // A time seek lands after the symbol's last record at or before that time
+    uint64_t seek_time = snapshot.clock_us;
+    uint64_t last_at_time = 0;
+    for (const auto& record : journal) {
+        if (record.symbol_id == 1 && record.timestamp <= seek_time) {
+            last_at_time = record.sequence;
+        }
+    }
+    assert(session.seek_to_time(seek_time) && session.position() == last_at_time);
+    assert(fresh.seek(last_at_time));
+    assert(session.book().get_bid_levels(20) == fresh.book().get_bid_levels(20));
+    assert(session.book().get_ask_levels(20) == fresh.book().get_ask_levels(20));
+    
+    // Checkpoints taken while stepping bound later seeks back
+    ReplaySession checkpointed(reader, 1);
+    checkpointed.set_checkpoint_interval(100);
+    assert(checkpointed.seek(journal.size()));
+    assert(checkpointed.snapshot_count() > 5);
+    uint64_t applied = checkpointed.records_applied();
+    assert(checkpointed.seek(expected.begin()->first));
+    assert(checkpointed.records_applied() - applied < 100);
+    assert(checkpointed.book().get_ask_levels(20) == expected.begin()->second.second);
+    std::remove(path.c_str());
+    
+    std::cout << "✓ Replay seek test passed\n";
+}
+
+#ifndef _WIN32
+void test_hot_standby() {
+    std::cout << "Testing hot standby replication...\n";
+    
+    const std::string path = "test_journal_ring.shm";
+    auto primary_ring = JournalRing::create(path, 4096);
+    auto standby_ring = JournalRing::attach(path);
+    assert(primary_ring && standby_ring && standby_ring->capacity() == 4096);
+    
+    OrderBookSimulator primary(1), replica(1);
+    JournalPublisher publisher(*primary_ring);
+    primary.set_journal(publisher.sink());
+    HotStandby standby(*standby_ring, replica);
+    
+    auto same_state = [&] {
+        for (uint32_t symbol : {1u, 2u}) {
+            if (primary.get_bid_levels(symbol, 50) != replica.get_bid_levels(symbol, 50) ||
+                primary.get_ask_levels(symbol, 50) != replica.get_ask_levels(symbol, 50) ||
+                primary.get_position(3, symbol).state.position != replica.get_position(3, symbol).state.position) {
+                return false;
+            }
+        }
+        return primary.get_risk_engine().get_open_notional(3) == replica.get_risk_engine().get_open_notional(3);
+    };
+    
+    RandomOrderFlow flow(11, 3, false);
+    
+    // Polled on the caller's thread. The session orders rest outside the
+    // flow's prices, and the amend gives one of them a new ClOrdID.
+    flow.run(primary, 500);
+    uint64_t session_bid = primary.submit_client_order(4, "h1", 1, Side::BUY, OrderType::LIMIT, 3, 80, 0, 3);
+    uint64_t session_ask = primary.submit_client_order(4, "h2", 2, Side::SELL, OrderType::LIMIT, 4, 120, 0, 3);
+    assert(session_bid != 0 && session_ask != 0);
+    assert(primary.modify_client_order(4, "h2", "h3", 5, 121));
+    assert(standby.poll() == primary.get_journal_sequence());
+    assert(same_state() && !standby.diverged());
+    
+    // Followed on a background thread; silence from the primary promotes it
+    std::atomic<bool> promoted_callback{false};
+    standby.start(20'000'000, [&] { promoted_callback = true; });
+    flow.run(primary, 500);
+    for (int i = 0; i < 2000 && !promoted_callback; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(promoted_callback && standby.promoted() && standby.promote());
+    assert(standby.records_applied() == primary.get_journal_sequence());
+    assert(same_state() && standby.max_lag_ns() > 0);
+    
+    // The promoted replica carries the client session and its ClOrdIDs
+    assert(replica.find_client_order(4, "h1") == session_bid);
+    assert(replica.find_client_order(4, "h3") == session_ask);
+    assert(replica.get_live_order_count(4) == 2);
+    assert(!replica.submit_client_order(4, "h2", 1, Side::BUY, OrderType::LIMIT, 1, 80, 0, 3));
+    assert(replica.cancel_client_order(4, "h1"));
+    assert(replica.disconnect_session(4) == 1 && replica.get_live_order_count(4) == 0);
+    
+    // The promoted replica issues ids after the primary's
+    uint64_t last_primary_id = flow.ids().back();
+    uint64_t id = replica.submit_order(1, Side::BUY, OrderType::LIMIT, 1, 90, 0, 3);
+    assert(id > last_primary_id && replica.get_journal_sequence() >= primary.get_journal_sequence());
+    
+    // A full ring drops rather than stall the primary, and the standby knows
+    auto small = JournalRing::create(path, 2);
+    JournalPublisher small_publisher(*small);
+    for (int i = 0; i < 3; ++i) {
+        small_publisher.publish(JournalRecord{});
+    }
+    assert(small->dropped() == 1);
+    HotStandby stale(*small, replica);
+    assert(stale.diverged() && !stale.promote() && stale.records_applied() == 2);
+    small->close_stream();
+    assert(stale.primary_failed(UINT64_MAX));
+    std::remove(path.c_str());
+    
+    std::cout << "✓ Hot standby test passed\n";
+}
+
+void test_mapped_book_store() {
+    std::cout << "Testing memory-mapped book store...\n";
+    
+    const std::string path = "test_book_store.img";
+    MappedBookStore::Capacity capacity;
+    capacity.orders = 4096;
+    capacity.levels = 512;
+    capacity.symbols = 16;
+    auto store = MappedBookStore::create(path, capacity);
+    assert(store && store->order_count() == 0);
+    
+    // Journaled, so the committed sequence is a real replay position
+    OrderBookSimulator primary(1);
+    uint64_t journaled = 0;
+    primary.set_journal([&](const JournalRecord&) { journaled++; });
+    primary.add_book_listener(store.get());
+    
+    RandomOrderFlow flow(23, 3, true);
+    flow.run(primary, 2000);
+    std::vector<uint64_t> live = flow.ids();
+    uint64_t session_bid = primary.submit_client_order(4, "a", 1, Side::BUY, OrderType::LIMIT, 3, 90, 0, 3);
+    uint64_t session_ask = primary.submit_client_order(4, "b", 2, Side::SELL, OrderType::LIMIT, 4, 110, 0, 3);
+    live.push_back(session_bid);
+    live.push_back(session_ask);
+    uint64_t committed = primary.get_journal_sequence();
+    assert(committed > 0 && committed == journaled);
+    assert(store->commit(committed));
+    size_t resting = store->order_count();
+    uint64_t checksum = store->checksum();
+    assert(resting > 0 && store->level_count() > 0);
+    
+    // Reopen as a restarted process would and rebuild the books from it
+    store.reset();
+    store = MappedBookStore::open(path);
+    assert(store && store->order_count() == resting && store->checksum() == checksum);
+    assert(store->committed_sequence() == committed);
+    
+    OrderBookSimulator restarted(1);
+    assert(store->restore_into(restarted) == resting);
+    for (uint32_t symbol : {1u, 2u}) {
+        assert(restarted.get_bid_levels(symbol, 50) == primary.get_bid_levels(symbol, 50));
+        assert(restarted.get_ask_levels(symbol, 50) == primary.get_ask_levels(symbol, 50));
+    }
+    assert(restarted.get_risk_engine().get_open_notional(3) == primary.get_risk_engine().get_open_notional(3));
+    assert(restarted.get_journal_sequence() == committed);
+    
+    // Restored orders carry their order state, session membership and ClOrdIDs
+    OrderState state = restarted.get_order_state(session_bid);
+    assert(state.order_id == session_bid && state.remaining_quantity == 3 && state.status == OrderStatus::NEW);
+    assert(restarted.get_live_order_count(4) == 2);
+    assert(restarted.find_client_order(4, "a") == session_bid && restarted.find_client_order(4, "b") == session_ask);
+    assert(!restarted.submit_client_order(4, "a", 1, Side::BUY, OrderType::LIMIT, 1, 90, 0, 3));
+    
+    // Restoring over a populated book swaps reservations rather than adding
+    uint64_t open_notional = restarted.get_risk_engine().get_open_notional(3);
+    assert(store->restore_into(restarted) == resting);
+    assert(restarted.get_risk_engine().get_open_notional(3) == open_notional);
+    assert(restarted.get_live_order_count(4) == 2 && restarted.find_client_order(4, "b") == session_ask);
+    
+    // Every resting order is addressable by id straight from the mapping
+    uint32_t found = 0;
+    for (uint64_t id : live) {
+        Order order;
+        if (store->find_order(id, order)) {
+            assert(order.order_id == id && order.remaining_quantity() > 0 && order.account_id == 3);
+            found++;
+        }
+    }
+    assert(found == resting);
+    
+    // Following the restarted engine keeps the image current,
+    // and its journal continues where the image was committed
+    uint64_t next_sequence = 0;
+    restarted.set_journal([&](const JournalRecord& record) { next_sequence = record.sequence; });
+    restarted.add_book_listener(store.get());
+    uint64_t id = restarted.submit_order(1, Side::BUY, OrderType::LIMIT, 5, 80, 0, 3);
+    assert(id > live.back() && store->order_count() == resting + 1);
+    assert(next_sequence == committed + 1);
+    
+    // Restored session orders answer to their ClOrdIDs and to cancel-on-disconnect
+    assert(restarted.cancel_client_order(4, "a") && !restarted.cancel_client_order(4, "a"));
+    assert(restarted.disconnect_session(4) == 1 && store->order_count() == resting - 1);
+    
+    // An update after the last commit leaves the image dirty, so it is refused
+    store.reset();
+    assert(!MappedBookStore::open(path));
+    
+    // Running out of slots poisons commits
+    capacity.orders = 2;
+    auto tiny = MappedBookStore::create(path, capacity);
+    OrderBookSimulator small(1);
+    small.add_book_listener(tiny.get());
+    for (uint64_t price = 90; price < 93; ++price) {
+        small.submit_order(1, Side::BUY, OrderType::LIMIT, 1, price);
+    }
+    assert(tiny->order_count() == 2 && !tiny->commit(small.get_journal_sequence()));
+    tiny.reset();
+    assert(!MappedBookStore::open(path));
+    std::remove(path.c_str());
+    
+    std::cout << "✓ Mapped book store test passed\n";
+}
+#endif
+
 void test_concurrent_operations() {
     std::cout << "Testing concurrent operations...\n";
     
@@ -213,6 +1860,7 @@ void test_concurrent_operations() {
     constexpr int symbol_id = 100;
     
     std::vector<uint64_t> order_ids;
+    std::mutex order_ids_mutex;
     
     // Submit orders from multiple threads
     std::vector<std::thread> threads;
@@ -226,6 +1874,7 @@ void test_concurrent_operations() {
                 
                 uint64_t order_id = simulator.submit_order(symbol_id, side, OrderType::LIMIT, 
                                                          quantity, price);
+                std::lock_guard<std::mutex> lock(order_ids_mutex);
                 order_ids.push_back(order_id);
             }
         });
@@ -256,6 +1905,33 @@ void run_all_tests() {
     test_price_priority();
     test_order_cancellation();
     test_market_data();
+    test_simulate_match();
+    test_vector_env();
+    test_discrete_event_simulation();
+    test_order_flow_generator();
+    test_flow_models();
+    test_symbol_universe();
+    test_risk_checks();
+    test_positions();
+    test_client_order_ids();
+    test_order_state();
+    test_execution_reports();
+    test_mass_quote();
+    test_cancel_on_disconnect();
+    test_symbol_rules();
+    test_price_bands();
+    test_bar_aggregation();
+    test_book_features();
+    test_trade_tape();
+    test_consolidated_book();
+    test_smart_order_router();
+    test_market_orders();
+    test_journal_archive();
+    test_replay_seek();
+#ifndef _WIN32
+    test_hot_standby();
+    test_mapped_book_store();
+#endif
     test_concurrent_operations();
     
     std::cout << "\n🎉 All tests passed successfully!\n";